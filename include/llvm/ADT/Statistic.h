@@ -28,7 +28,10 @@
 
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Compiler.h"
+#include <algorithm>
 #include <atomic>
+#include <climits>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -120,6 +123,21 @@ public:
     init();
   }
 
+  /// Add \p V, saturating at the largest value the statistic can hold. This
+  /// suits sizes, which can exceed the range of the counter.
+  void addSaturating(uint64_t V) {
+    if (V == 0)
+      return;
+    unsigned Prev = Value.load(std::memory_order_relaxed);
+    unsigned New;
+    do {
+      New = static_cast<unsigned>(
+          std::min<uint64_t>(uint64_t(Prev) + V, UINT_MAX));
+    } while (!Value.compare_exchange_weak(Prev, New,
+                                          std::memory_order_relaxed));
+    init();
+  }
+
 #else  // Statistics are disabled in release builds.
 
   const Statistic &operator=(unsigned Val) {
@@ -152,6 +170,8 @@ public:
 
   void updateMax(unsigned V) {}
 
+  void addSaturating(uint64_t V) {}
+
 #endif  // LLVM_ENABLE_STATS
 
 protected:
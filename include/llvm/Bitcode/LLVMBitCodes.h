@@ -268,6 +268,9 @@ enum GlobalValueSummarySymtabCodes {
   //           n x (typeid, kind, name, numrba,
   //                numrba x (numarg, numarg x arg, kind, info, byte, bit))]
   FS_TYPE_ID = 21,
+  // The body hash of the following function summary, if one was computed.
+  // [hash]
+  FS_FUNCTION_HASH = 22,
 };
 
 enum MetadataCodes {
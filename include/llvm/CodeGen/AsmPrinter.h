@@ -127,6 +127,8 @@ public:
 private:
   MCSymbol *CurrentFnBegin = nullptr;
   MCSymbol *CurrentFnEnd = nullptr;
+  MCSymbol *CurrentFnColdBegin = nullptr;
+  MCSymbol *CurrentFnColdEnd = nullptr;
   MCSymbol *CurExceptionSym = nullptr;
 
   // The garbage collection metadata printer table.
@@ -203,6 +205,11 @@ public:
 
   MCSymbol *getFunctionBegin() const { return CurrentFnBegin; }
   MCSymbol *getFunctionEnd() const { return CurrentFnEnd; }
+
+  /// Return the labels around the cold fragment of the current function, or
+  /// null if the function has none. The cold fragment is in another section.
+  MCSymbol *getColdFragmentBegin() const { return CurrentFnColdBegin; }
+  MCSymbol *getColdFragmentEnd() const { return CurrentFnColdEnd; }
   MCSymbol *getCurExceptionSym();
 
   /// Return information about object file lowering.
@@ -18,9 +18,12 @@
 #ifndef LLVM_CODEGEN_GLOBALISEL_COMBINER_HELPER_H
 #define LLVM_CODEGEN_GLOBALISEL_COMBINER_HELPER_H
 
+#include <cstdint>
+
 namespace llvm {
 
 class MachineIRBuilder;
+class MachineOperand;
 class MachineRegisterInfo;
 class MachineInstr;
 
@@ -31,9 +34,22 @@ class CombinerHelper {
 public:
   CombinerHelper(MachineIRBuilder &B);
 
+  /// Erase \p MI and replace the uses of its result with \p Reg, which must
+  /// have the same type.
+  void replaceInstWithReg(MachineInstr &MI, unsigned Reg);
+
   /// If \p MI is COPY, try to combine it.
   /// Returns true if MI changed.
   bool tryCombineCopy(MachineInstr &MI);
+  bool matchCombineCopy(MachineInstr &MI);
+  void applyCombineCopy(MachineInstr &MI);
+
+  /// Match the operand of a G_CONSTANT that a scalar G_MUL multiplies by, if
+  /// it is a power of two greater than one, and set \p ShiftAmt to its log2.
+  bool matchMulByPowerOf2(MachineInstr &MI, const MachineOperand &Imm,
+                          int64_t &ShiftAmt);
+  /// Replace the G_MUL \p MI by a G_SHL of \p ShiftAmt.
+  void applyMulByPowerOf2(MachineInstr &MI, int64_t ShiftAmt);
 
   /// Try to transform \p MI by using all of the above
   /// combine functions. Returns true if changed.
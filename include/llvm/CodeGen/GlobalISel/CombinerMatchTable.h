@@ -0,0 +1,115 @@
+//===- llvm/CodeGen/GlobalISel/CombinerMatchTable.h -------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file This file declares the match-table interpreter used by combiners
+/// that TableGen generates from declarative GICombineRule definitions. The
+/// generated helpers derive from GICombinerMatcher, provide the C++ code
+/// fragments of their rules and run a match table per root instruction.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_COMBINERMATCHTABLE_H
+#define LLVM_CODEGEN_GLOBALISEL_COMBINERMATCHTABLE_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+
+namespace llvm {
+
+class CodeGenCoverage;
+class CombinerHelper;
+class MachineInstr;
+class MachineRegisterInfo;
+
+enum {
+  /// Begin a try-block to attempt a match and jump to OnFail if it is
+  /// unsuccessful.
+  /// - OnFail - The MatchTable entry at which to resume if the match fails.
+  GICM_Try,
+
+  /// Check the opcode on the specified instruction
+  /// - InsnID - Instruction ID
+  /// - Expected opcode
+  GICM_CheckOpcode,
+
+  /// Check the instruction has the right number of operands
+  /// - InsnID - Instruction ID
+  /// - Expected number of operands
+  GICM_CheckNumOperands,
+
+  /// Record the instruction defining a virtual register operand in its first
+  /// operand
+  /// - NewInsnID - Instruction ID to define
+  /// - InsnID - Instruction ID
+  /// - OpIdx - Operand index
+  GICM_RecordDefInsn,
+
+  /// Check the specified operands are identical
+  /// - InsnID - Instruction ID
+  /// - OpIdx - Operand index
+  /// - OtherInsnID - Other instruction ID
+  /// - OtherOpIdx - Other operand index
+  GICM_CheckIsSameOperand,
+
+  /// Check a C++ predicate of a rule
+  /// - PredicateID - The ID of the predicate passed to testPredicate()
+  GICM_CheckPredicate,
+
+  /// Apply a rule whose match succeeded, unless it is disabled
+  /// - RuleID - The ID of the rule, for coverage and rule disabling
+  /// - ApplyID - The ID of the apply code passed to runApply()
+  GICM_Apply,
+
+  /// Fail the current try-block, or completely fail to match if there is no
+  /// current try-block.
+  GICM_Reject,
+};
+
+/// The instructions and values a rule binds while it is matched.
+struct GICombinerMatchState {
+  /// The instructions bound by the current rule. MIs[0] is the root.
+  SmallVector<MachineInstr *, 4> MIs;
+  /// Scratch data the match predicates pass to the apply code.
+  int64_t MatchInfo = 0;
+
+  GICombinerMatchState(MachineInstr &Root) { MIs.push_back(&Root); }
+};
+
+/// Base class of the combiner helpers that TableGen generates.
+class GICombinerMatcher {
+public:
+  virtual ~GICombinerMatcher() = default;
+
+protected:
+  /// Run \p MatchTable on the root instruction \p MI. Returns true if a rule
+  /// was applied.
+  bool executeMatchTable(const int64_t *MatchTable, MachineInstr &MI,
+                         MachineRegisterInfo &MRI, CombinerHelper &Helper,
+                         CodeGenCoverage &CoverageInfo) const;
+
+  virtual bool isRuleDisabled(unsigned RuleID) const = 0;
+  virtual bool testPredicate(unsigned PredicateID, MachineInstr &MI,
+                             GICombinerMatchState &State,
+                             MachineRegisterInfo &MRI,
+                             CombinerHelper &Helper) const = 0;
+  virtual void runApply(unsigned ApplyID, MachineInstr &MI,
+                        GICombinerMatchState &State, MachineRegisterInfo &MRI,
+                        CombinerHelper &Helper) const = 0;
+};
+
+/// Write the rules that \p CoverageInfo records as applied to the file
+/// selected by -gicombiner-coverage-prefix, if combiner coverage was
+/// enabled at build time.
+void emitGICombinerCoverage(const CodeGenCoverage &CoverageInfo,
+                            StringRef CombinerName);
+
+} // end namespace llvm
+
+#endif // LLVM_CODEGEN_GLOBALISEL_COMBINERMATCHTABLE_H
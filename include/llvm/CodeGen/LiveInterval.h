@@ -606,6 +606,17 @@ namespace llvm {
     /// activated in the constructor of the live range.
     void flushSegmentSet();
 
+    /// Release the unused capacity of the segment and value number vectors.
+    /// Vectors grow geometrically while a range is computed, so a large range
+    /// can leave up to half of its allocation unused.
+    void compact();
+
+    /// Returns the number of bytes allocated for the segment and value number
+    /// vectors. The VNInfos live in a shared allocator and are not included.
+    size_t getAllocatedBytes() const {
+      return capacity_in_bytes(segments) + capacity_in_bytes(valnos);
+    }
+
     void print(raw_ostream &OS) const;
     void dump() const;
 
@@ -126,6 +126,10 @@ private:
   /// Indicate that this basic block is the entry block of a cleanup funclet.
   bool IsCleanupFuncletEntry = false;
 
+  /// Indicate that this basic block belongs to the cold fragment of its
+  /// function, which is emitted in a section of its own.
+  bool IsInColdFragment = false;
+
   /// since getSymbol is a relatively heavy-weight operation, the symbol
   /// is only computed once and is cached.
   mutable MCSymbol *CachedMCSymbol = nullptr;
@@ -394,6 +398,13 @@ public:
   /// Indicates if this is the entry block of an EH funclet.
   void setIsEHFuncletEntry(bool V = true) { IsEHFuncletEntry = V; }
 
+  /// Returns true if this block belongs to the cold fragment of its function.
+  /// The blocks of the cold fragment are the last ones of the function.
+  bool isInColdFragment() const { return IsInColdFragment; }
+
+  /// Indicates if this block belongs to the cold fragment of its function.
+  void setIsInColdFragment(bool V = true) { IsInColdFragment = V; }
+
   /// Returns true if this is the entry block of a cleanup funclet.
   bool isCleanupFuncletEntry() const { return IsCleanupFuncletEntry; }
 
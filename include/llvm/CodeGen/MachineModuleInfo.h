@@ -38,6 +38,7 @@
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/Pass.h"
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -141,6 +142,8 @@ class MachineModuleInfo : public ImmutablePass {
   unsigned NextFnNum = 0;
   const Function *LastRequest = nullptr; ///< Used for shortcut/cache.
   MachineFunction *LastResult = nullptr; ///< Used for shortcut/cache.
+  /// Guards MachineFunctions and the lookup cache.
+  mutable std::mutex MachineFunctionsMutex;
 
 public:
   static char ID; // Pass identification, replacement for typeid
@@ -421,10 +421,20 @@ namespace llvm {
   /// This pass frees the memory occupied by the MachineFunction.
   FunctionPass *createFreeMachineFunctionPass();
 
+  /// This pass ends the function pass manager before it, so that the
+  /// function passes before it run on every function before the ones after
+  /// it run on any. If \p CreateFunctions is true, it also creates the
+  /// MachineFunctions of the module in module order.
+  ModulePass *createMachineFunctionBarrierPass(bool CreateFunctions);
+
   /// This pass performs outlining on machine instructions directly before
   /// printing assembly.
   ModulePass *createMachineOutlinerPass(bool RunOnAllFunctions = true);
 
+  /// This pass moves the blocks that the profile shows to be cold into a
+  /// fragment of the function that is emitted in a separate section.
+  MachineFunctionPass *createMachineFunctionSplitterPass();
+
   /// This pass expands the experimental reduction intrinsics into sequences of
   /// shuffles.
   FunctionPass *createExpandReductionsPass();
@@ -68,6 +68,9 @@ public:
   bool shouldPutJumpTableInFunctionSection(bool UsesLabelDifference,
                                            const Function &F) const override;
 
+  MCSection *getSectionForColdFragment(const Function &F,
+                                       const TargetMachine &TM) const override;
+
   /// Return an MCExpr to use for a reference to the specified type info global
   /// variable from exception handling information.
   const MCExpr *getTTypeGlobalReference(const GlobalValue *GV,
@@ -152,6 +152,16 @@ public:
   /// TargetLowering preference). It does not yet disable the postRA scheduler.
   virtual bool enableMachineScheduler() const;
 
+  /// True if the MachinePipeliner should software pipeline loops for this
+  /// subtarget, provided that the target adds the pass.
+  virtual bool enableMachinePipeliner() const { return true; }
+
+  /// True if the MachinePipeliner should reject schedules whose kernel
+  /// clobbers the registers set by the loop compare, or needs more registers
+  /// than the target provides. Targets whose loop control is a hardware loop
+  /// instruction do not need these checks.
+  virtual bool enablePipelinerKernelChecks() const { return false; }
+
   /// Support printing of [latency:throughput] comment in output .S file.
   virtual bool supportPrintSchedInfo() const { return false; }
 
@@ -0,0 +1,191 @@
+//===- llvm/IR/FlatSummaryIndex.h - Mappable summary index ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// This file declares a flat encoding of the global value summaries of a
+/// ModuleSummaryIndex. Unlike the bitcode encoding, it is made of tables of
+/// fixed-size little-endian entries that refer to each other by index, so a
+/// reader can map the file and look values up by GUID without building the
+/// in-memory index.
+///
+/// The file starts with a flatsummary::Header, which gives the position of
+/// each table:
+///
+/// - Modules: one flatsummary::ModuleEntry per module path.
+/// - Values: one flatsummary::ValueEntry per GUID, sorted by GUID, each
+///   naming a contiguous range of summaries.
+/// - Summaries: flatsummary::SummaryEntry records, each naming contiguous
+///   ranges of refs and calls.
+/// - Refs: the GUIDs referenced by the summaries.
+/// - Calls: flatsummary::CallEntry records for the call edges of functions.
+/// - Strings: the module paths.
+///
+/// Type identifier summaries and the CFI function sets are not represented.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_FLATSUMMARYINDEX_H
+#define LLVM_IR_FLATSUMMARYINDEX_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstdint>
+
+namespace llvm {
+
+class raw_ostream;
+
+namespace flatsummary {
+
+using support::ulittle32_t;
+using support::ulittle64_t;
+
+/// The file magic, "LSIX" when read as bytes.
+const uint32_t Magic = 0x5849534c;
+const uint32_t Version = 1;
+
+/// A range of entries in one of the tables.
+struct Range {
+  ulittle32_t First;
+  ulittle32_t Size;
+};
+
+struct Header {
+  ulittle32_t Magic;
+  ulittle32_t Version;
+  /// Bit 0: withGlobalValueDeadStripping(),
+  /// bit 1: skipModuleByDistributedBackend().
+  ulittle32_t Flags;
+  ulittle32_t Reserved;
+  /// Byte offset of each table from the start of the file, and its number of
+  /// entries (bytes for the string table).
+  ulittle64_t ModulesOffset, NumModules;
+  ulittle64_t ValuesOffset, NumValues;
+  ulittle64_t SummariesOffset, NumSummaries;
+  ulittle64_t RefsOffset, NumRefs;
+  ulittle64_t CallsOffset, NumCalls;
+  ulittle64_t StringsOffset, StringsSize;
+};
+
+struct ModuleEntry {
+  /// The path, as a range of the string table.
+  Range Path;
+  ulittle64_t ModuleId;
+  ulittle32_t Hash[5];
+  ulittle32_t Reserved;
+};
+
+struct ValueEntry {
+  ulittle64_t GUID;
+  Range Summaries;
+};
+
+struct SummaryEntry {
+  /// A GlobalValueSummary::SummaryKind.
+  uint8_t Kind;
+  /// A GlobalValue::LinkageTypes.
+  uint8_t Linkage;
+  /// Bit 0: NotEligibleToImport, bit 1: Live, bit 2: DSOLocal.
+  uint8_t Flags;
+  /// Bit 0: ReadNone, bit 1: ReadOnly, bit 2: NoRecurse,
+  /// bit 3: ReturnDoesNotAlias.
+  uint8_t FunctionFlags;
+  /// Index into the module table.
+  ulittle32_t Module;
+  ulittle32_t InstCount;
+  ulittle32_t Reserved;
+  ulittle64_t OriginalName;
+  /// The aliasee GUID of an alias, or the body hash of a function.
+  ulittle64_t AliaseeOrBodyHash;
+  Range Refs;
+  Range Calls;
+};
+
+struct CallEntry {
+  ulittle64_t Callee;
+  /// The CalleeInfo: hotness in bits 0-2 and the relative block frequency in
+  /// bits 3-31.
+  ulittle32_t Info;
+  ulittle32_t Reserved;
+};
+
+} // end namespace flatsummary
+
+/// A read-only view of a flat summary index held in memory, typically mapped
+/// from a file.
+class FlatSummaryIndex {
+  StringRef Buffer;
+  const flatsummary::Header *Hdr = nullptr;
+  ArrayRef<flatsummary::ModuleEntry> Modules;
+  ArrayRef<flatsummary::ValueEntry> Values;
+  ArrayRef<flatsummary::SummaryEntry> Summaries;
+  ArrayRef<flatsummary::ulittle64_t> Refs;
+  ArrayRef<flatsummary::CallEntry> Calls;
+  StringRef Strings;
+
+  FlatSummaryIndex() = default;
+
+public:
+  /// Return true if \p Buffer starts with the flat summary index magic.
+  static bool isFlatSummaryIndex(StringRef Buffer);
+
+  /// Create a view of \p Buffer, which must outlive the view. This checks
+  /// that all table entries are in bounds and that the values are sorted,
+  /// which reads each value and summary entry once but allocates nothing.
+  static Expected<FlatSummaryIndex> create(MemoryBufferRef Buffer);
+
+  bool withGlobalValueDeadStripping() const { return Hdr->Flags & 1; }
+  bool skipModuleByDistributedBackend() const { return Hdr->Flags & 2; }
+
+  ArrayRef<flatsummary::ModuleEntry> modules() const { return Modules; }
+  ArrayRef<flatsummary::ValueEntry> values() const { return Values; }
+
+  StringRef getModulePath(const flatsummary::ModuleEntry &M) const {
+    return Strings.substr(M.Path.First, M.Path.Size);
+  }
+  StringRef getModulePath(const flatsummary::SummaryEntry &S) const {
+    return getModulePath(Modules[S.Module]);
+  }
+  ModuleHash getModuleHash(const flatsummary::ModuleEntry &M) const;
+
+  /// Return the summaries of \p GUID, found by binary search.
+  ArrayRef<flatsummary::SummaryEntry>
+  findSummaries(GlobalValue::GUID GUID) const;
+
+  ArrayRef<flatsummary::SummaryEntry>
+  summaries(const flatsummary::ValueEntry &V) const {
+    return Summaries.slice(V.Summaries.First, V.Summaries.Size);
+  }
+  ArrayRef<flatsummary::ulittle64_t>
+  refs(const flatsummary::SummaryEntry &S) const {
+    return Refs.slice(S.Refs.First, S.Refs.Size);
+  }
+  ArrayRef<flatsummary::CallEntry>
+  calls(const flatsummary::SummaryEntry &S) const {
+    return Calls.slice(S.Calls.First, S.Calls.Size);
+  }
+
+  /// Add the modules and summaries of this index to \p Index, for clients
+  /// that need the in-memory representation.
+  void materialize(ModuleSummaryIndex &Index) const;
+};
+
+/// Write the global value summaries of \p Index to \p OS in the flat format.
+/// Fails if the index contains information that the format does not
+/// represent, i.e. type identifier summaries or CFI functions.
+Error writeFlatSummaryIndex(const ModuleSummaryIndex &Index, raw_ostream &OS);
+
+} // end namespace llvm
+
+#endif // LLVM_IR_FLATSUMMARYINDEX_H
@@ -0,0 +1,70 @@
+//===- llvm/IR/IRMemoryUsage.h - Measure IR memory footprint ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// This file declares utilities to measure how much memory the instructions
+/// of a module and their operand lists occupy, and to release operand space
+/// that instructions with growable operand lists have reserved but do not
+/// use.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_IRMEMORYUSAGE_H
+#define LLVM_IR_IRMEMORYUSAGE_H
+
+#include <cstdint>
+
+namespace llvm {
+
+class Function;
+class Module;
+class raw_ostream;
+
+/// The bytes allocated for the instructions of a set of functions. Sizes are
+/// those of the objects themselves and do not include allocator overhead.
+struct IRMemoryUsage {
+  uint64_t NumFunctions = 0;
+  uint64_t NumInstructions = 0;
+  /// The number of operands in use.
+  uint64_t NumOperands = 0;
+  /// The number of operand slots that are allocated but unused.
+  uint64_t NumReservedOperands = 0;
+
+  /// The instruction objects.
+  uint64_t InstructionBytes = 0;
+  /// The operand lists, including the co-allocated operand bundle
+  /// descriptors, the incoming blocks of PHI nodes and the reserved slots.
+  uint64_t OperandBytes = 0;
+  /// The part of OperandBytes taken by reserved slots.
+  uint64_t ReservedOperandBytes = 0;
+  /// The value names of arguments, basic blocks and instructions.
+  uint64_t NameBytes = 0;
+
+  void addFunction(const Function &F);
+
+  uint64_t getTotalBytes() const {
+    return InstructionBytes + OperandBytes + NameBytes;
+  }
+
+  void print(raw_ostream &OS) const;
+};
+
+/// Measure the defined functions of \p M.
+IRMemoryUsage measureIRMemoryUsage(const Module &M);
+
+/// Shrink the operand lists of the PHI nodes and switches of \p F to the
+/// operands they use. Return the number of bytes released.
+uint64_t compactOperandLists(Function &F);
+
+/// Shrink the operand lists of all functions of \p M.
+uint64_t compactOperandLists(Module &M);
+
+} // end namespace llvm
+
+#endif // LLVM_IR_IRMEMORYUSAGE_H
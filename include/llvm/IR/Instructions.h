@@ -3109,6 +3109,16 @@ public:
   /// non-undef value.
   bool hasConstantOrUndefValue() const;
 
+  /// Return the number of operands that fit in the current allocation.
+  unsigned getNumReservedOperands() const { return ReservedSpace; }
+
+  /// Release the space reserved for incoming values that were never added or
+  /// have been removed.
+  void shrinkToFit() {
+    shrinkHungoffUses(ReservedSpace, /* IsPhi */ true);
+    ReservedSpace = getNumOperands();
+  }
+
   /// Methods for support type inquiry through isa, cast, and dyn_cast:
   static bool classof(const Instruction *I) {
     return I->getOpcode() == Instruction::PHI;
@@ -3652,6 +3662,16 @@ public:
     return getNumOperands()/2 - 1;
   }
 
+  /// Return the number of operands that fit in the current allocation.
+  unsigned getNumReservedOperands() const { return ReservedSpace; }
+
+  /// Release the space reserved for cases that were never added or have been
+  /// removed.
+  void shrinkToFit() {
+    shrinkHungoffUses(ReservedSpace);
+    ReservedSpace = getNumOperands();
+  }
+
   /// Returns a read/write iterator that points to the first case in the
   /// SwitchInst.
   CaseIt case_begin() {
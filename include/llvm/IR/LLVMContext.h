@@ -161,6 +161,24 @@ public:
   /// especially in release mode.
   void setDiscardValueNames(bool Discard);
 
+  /// Return true if the names of private GlobalValues are discarded as well.
+  bool shouldDiscardPrivateGlobalNames() const;
+
+  /// Also discard the names of private GlobalValues, which never reach the
+  /// symbol table of an object file. Names starting with "llvm." are kept.
+  /// Such globals cannot be looked up by name anymore, so this is not
+  /// suitable for modules that get a ThinLTO summary.
+  void setDiscardPrivateGlobalNames(bool Discard);
+
+  /// Return true if symbol tables rename a conflicting name with the next
+  /// suffix of that name rather than the next suffix of the whole table.
+  bool hasPerNameUniqueSuffixes() const;
+
+  /// Keep a suffix counter per conflicting base name in symbol tables. This
+  /// keeps suffixes short when a few names are cloned many times, at the cost
+  /// of one counter per base name.
+  void setPerNameUniqueSuffixes(bool Enable);
+
   /// Whether there is a string map for uniquing debug info
   /// identifiers across the context.  Off by default.
   bool isODRUniquingDebugTypes() const;
@@ -463,6 +463,13 @@ public:
   bool runOnFunction(Function &F);
   bool runOnModule(Module &M) override;
 
+  /// Return true if the passes of this manager can run on several functions
+  /// of \p M at the same time.
+  bool canRunInParallel(Module &M);
+
+  /// Run the passes of this manager on the functions of \p M on a thread pool.
+  bool runInParallel(Module &M);
+
   /// cleanup - After running all passes, clean up pass manager cache.
   void cleanup();
 
@@ -502,6 +502,10 @@ private:
 
   std::unique_ptr<TypeIdInfo> TIdInfo;
 
+  /// Hash of everything that importing this function brings into another
+  /// module, or 0 if none was computed.
+  uint64_t BodyHash = 0;
+
 public:
   FunctionSummary(GVFlags Flags, unsigned NumInsts, FFlags FunFlags,
                   std::vector<ValueInfo> Refs, std::vector<EdgeTy> CGEdges,
@@ -534,6 +538,11 @@ public:
   /// Get the instruction count recorded for this function.
   unsigned instCount() const { return InstCount; }
 
+  /// Get the hash of the function body, or 0 if it is unknown. See
+  /// -module-summary-function-hashes.
+  uint64_t getBodyHash() const { return BodyHash; }
+  void setBodyHash(uint64_t Hash) { BodyHash = Hash; }
+
   /// Return the list of <CalleeValueInfo, CalleeInfo> pairs.
   ArrayRef<EdgeTy> calls() const { return CallGraphEdgeList; }
 
@@ -91,6 +91,10 @@ protected:
   /// should be called if there are no uses.
   void growHungoffUses(unsigned N, bool IsPhi = false);
 
+  /// Reallocate the hung off uses so that exactly getNumOperands() of them
+  /// remain. \p Reserved is the number of Uses in the current allocation.
+  void shrinkHungoffUses(unsigned Reserved, bool IsPhi = false);
+
 protected:
   ~User() = default; // Use deleteValue() to delete a generic Instruction.
 
@@ -131,6 +131,10 @@ private:
   ValueMap vmap;                    ///< The map that holds the symbol table.
   mutable uint32_t LastUnique = 0;  ///< Counter for tracking unique names
 
+  /// The last suffix given to each base name, when the context asks for
+  /// per-name suffixes.
+  StringMap<uint32_t> LastUniqueByName;
+
 /// @}
 };
 
@@ -220,6 +220,26 @@ ThinBackend createWriteIndexesThinBackend(std::string OldPrefix,
                                           raw_fd_ostream *LinkedObjectsFile,
                                           IndexWriteCallback OnWrite);
 
+/// This ThinBackend runs each backend job in a separate worker process, with
+/// at most ParallelismLevel workers running at a time. For each job the
+/// module's individual index is written to a temporary file and the worker is
+/// invoked as
+///
+///   WorkerPath WorkerArgs... <codegen options> -x ir <module>
+///       -fthinlto-index=<index> -o <obj>
+///
+/// which is the interface of clang's distributed ThinLTO backend. The codegen
+/// options pass the optimization level, CPU and target features of the
+/// Config on in clang's syntax. WorkerPath may also be a wrapper that ships
+/// the job to another machine. As with createWriteIndexesThinBackend, module
+/// identifiers must name bitcode files that the worker can read. Jobs whose
+/// object is found in the cache are not run. A worker that fails or crashes
+/// only fails its own job; the errors of all failed jobs are reported together
+/// once every job has finished.
+ThinBackend createOutOfProcessThinBackend(unsigned ParallelismLevel,
+                                          std::string WorkerPath,
+                                          std::vector<std::string> WorkerArgs);
+
 /// This class implements a resolution-based interface to LLVM's LTO
 /// functionality. It supports regular LTO, parallel LTO code generation and
 /// ThinLTO. You can use it from a linker in the following way:
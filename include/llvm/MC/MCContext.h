@@ -342,6 +342,11 @@ namespace llvm {
     /// \param Name - The symbol name, which must be unique across all symbols.
     MCSymbol *getOrCreateSymbol(const Twine &Name);
 
+    /// Create a new symbol named \p Name, or \p Name followed by a dot and a
+    /// number if a symbol of that name already exists. Unlike a temporary
+    /// symbol, it is kept in the symbol table of the object file.
+    MCSymbol *createUniqueSymbol(const Twine &Name);
+
     /// Gets a symbol that will be defined to the final stack offset of a local
     /// variable after codegen.
     ///
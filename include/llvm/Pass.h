@@ -294,6 +294,20 @@ public:
   /// per-function processing of the pass.
   virtual bool runOnFunction(Function &F) = 0;
 
+  /// Return true if runOnFunction may be called on several functions of a
+  /// module at the same time. FPPassManager does so under
+  /// -function-pass-threads when all of its passes return true and none of
+  /// them requires an analysis other than an immutable one, which all threads
+  /// share. Such a pass must not change anything other than the function it
+  /// runs on, including the LLVMContext.
+  virtual bool isFunctionParallelSafe() const { return false; }
+
+  /// Called before and after FPPassManager runs this pass on the functions of
+  /// \p M concurrently. A pass can use them to set up per-thread state and to
+  /// report its results in a deterministic order.
+  virtual void beginParallelRun(Module &M) {}
+  virtual void endParallelRun(Module &M) {}
+
   void assignPassManager(PMStack &PMS, PassManagerType T) override;
 
   ///  Return what kind of Pass Manager can manage this pass.
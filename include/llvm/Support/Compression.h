@@ -35,6 +35,20 @@ bool isAvailable();
 Error compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
                CompressionLevel Level = DefaultCompression);
 
+/// Compress \p InputBuffer into a single zlib stream like compress() does, but
+/// split the input into fixed-size blocks that are deflated in parallel. Each
+/// block is primed with the 32KB of input preceding it, so the compression
+/// ratio stays close to that of compress(). The output does not depend on the
+/// number of threads, and can be read back with uncompress() or any other
+/// zlib implementation. Inputs no larger than one block are handed to
+/// compress() directly. At most \p ThreadCount threads are used; 0 means one
+/// per hardware thread, which a caller that already runs in parallel should
+/// lower.
+Error compressParallel(StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       CompressionLevel Level = DefaultCompression,
+                       unsigned ThreadCount = 0);
+
 Error uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                  size_t &UncompressedSize);
 
@@ -28,6 +28,10 @@ namespace llvm {
 /// If the FileOutputBuffer is committed, the target file's content will become
 /// the buffer content at the time of the commit.  If the FileOutputBuffer is
 /// not committed, the file will be deleted in the FileOutputBuffer destructor.
+///
+/// Several threads may write to disjoint ranges of the buffer at the same time
+/// without any locking, e.g. one thread per output section. All writers must
+/// be finished before commit() is called.
 class FileOutputBuffer {
 public:
   enum {
@@ -36,7 +40,9 @@ public:
 
     /// the contents of the new file are initialized from the file that exists
     /// at the location (if present).  This allows in-place modification of an
-    /// existing file.
+    /// existing file. Where the filesystem supports it, the existing contents
+    /// are cloned rather than copied, so regions that are not modified share
+    /// storage with the old file.
     F_modify = 2
   };
 
@@ -1048,6 +1048,15 @@ public:
     priv ///< May modify via data, but changes are lost on destruction.
   };
 
+  /// Hints about how a mapping is going to be accessed.
+  enum advice {
+    normal,     ///< No particular access pattern.
+    sequential, ///< Pages are touched in order; read ahead aggressively.
+    random,     ///< Pages are touched in random order; don't read ahead.
+    willneed,   ///< Fault the whole mapping in now rather than on first use.
+    hugepage    ///< Back the mapping with transparent huge pages if possible.
+  };
+
 private:
   /// Platform-specific mapping state.
   size_t Size;
@@ -1079,10 +1088,19 @@ public:
   /// behavior.
   const char *const_data() const;
 
+  /// Tell the OS how the mapping is going to be accessed. This is only a hint;
+  /// advice that the platform does not support is silently ignored.
+  void advise(advice Advice) const;
+
   /// \returns The minimum alignment offset must be.
   static int alignment();
 };
 
+/// Tell the OS that the byte range [Offset, Offset + Len) of \a FD is about to
+/// be read from start to end, so that it can begin reading ahead right away.
+/// This is only a hint and does nothing on platforms that don't support it.
+void readAhead(int FD, uint64_t Offset, uint64_t Len);
+
 /// Return the path to the main executable, given the value of argv[0] from
 /// program startup and the address of main itself. In extremis, this function
 /// may fail and return an empty path.
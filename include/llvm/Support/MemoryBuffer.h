@@ -82,6 +82,30 @@ public:
   getFile(const Twine &Filename, int64_t FileSize = -1,
           bool RequiresNullTerminator = true, bool IsVolatile = false);
 
+  /// How the contents of a file-backed buffer are expected to be accessed.
+  enum AccessPattern { AP_Normal, AP_Sequential, AP_Random };
+
+  /// Options controlling how getFile brings a file into memory. The defaults
+  /// give the same behavior as the plain getFile overload.
+  struct FileOptions {
+    /// Expected access pattern, forwarded to the OS as a paging hint.
+    AccessPattern Access = AP_Normal;
+    /// Fault the whole buffer in up front rather than one page at a time.
+    bool Prefault = false;
+    /// Ask for transparent huge pages when mapping large files.
+    bool HugePages = false;
+    /// Never mmap the file; read it into memory with read-ahead enabled. This
+    /// is usually the fastest way to load an input that is consumed once.
+    bool Stream = false;
+  };
+
+  /// Open the specified file as a MemoryBuffer, like the overload above, but
+  /// tune how it is read according to \p Options.
+  static ErrorOr<std::unique_ptr<MemoryBuffer>>
+  getFile(const Twine &Filename, const FileOptions &Options,
+          int64_t FileSize = -1, bool RequiresNullTerminator = true,
+          bool IsVolatile = false);
+
   /// Read all of the specified file into a MemoryBuffer as a stream
   /// (i.e. until EOF reached). This is useful for special files that
   /// look like a regular file but have 0 size (e.g. /proc/cpuinfo on Linux).
@@ -38,10 +38,56 @@
 #ifndef LLVM_SUPPORT_XXHASH_H
 #define LLVM_SUPPORT_XXHASH_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 
 namespace llvm {
 uint64_t xxHash64(llvm::StringRef Data);
+
+/// Compute the 64-bit XXH3 hash of \p Data, using the default secret and a
+/// zero seed. The result matches XXH3_64bits() from the reference library.
+/// On inputs longer than a few hundred bytes this is several times faster than
+/// xxHash64, as the inner loop uses SSE2, AVX2 or NEON when the compiler
+/// targets them.
+uint64_t xxh3_64bits(ArrayRef<uint8_t> Data);
+
+inline uint64_t xxh3_64bits(StringRef Data) {
+  return xxh3_64bits(
+      ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(Data.data()),
+                        Data.size()));
 }
 
+/// Incrementally computes an XXH3 64-bit hash. Feeding the same bytes through
+/// any sequence of update() calls gives the same result as xxh3_64bits() on
+/// the concatenated input.
+class XXH3_64 {
+public:
+  XXH3_64() { init(); }
+
+  /// Reinitialize the internal state.
+  void init();
+
+  /// Digest more data.
+  void update(ArrayRef<uint8_t> Data);
+
+  /// Digest more data.
+  void update(StringRef Str) {
+    update(ArrayRef<uint8_t>((const uint8_t *)Str.data(), Str.size()));
+  }
+
+  /// Return the hash of all data digested so far. The state is not modified,
+  /// so more data can still be added afterwards.
+  uint64_t final() const;
+
+private:
+  static constexpr size_t BufferSize = 256;
+
+  alignas(64) uint64_t Acc[8];
+  alignas(64) uint8_t Buffer[BufferSize];
+  size_t BufferedSize;
+  size_t StripesSoFar;
+  uint64_t TotalLen;
+};
+} // namespace llvm
+
 #endif
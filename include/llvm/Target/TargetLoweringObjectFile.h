@@ -109,6 +109,13 @@ public:
   virtual bool shouldPutJumpTableInFunctionSection(bool UsesLabelDifference,
                                                    const Function &F) const;
 
+  /// Return the section for the cold fragment of \p F, or null if the object
+  /// format cannot place part of a function in another section.
+  virtual MCSection *getSectionForColdFragment(const Function &F,
+                                               const TargetMachine &TM) const {
+    return nullptr;
+  }
+
   /// Targets should implement this method to assign a section to globals with
   /// an explicit section specfied. The implementation of this method can
   /// assume that GO->hasSection() is true.
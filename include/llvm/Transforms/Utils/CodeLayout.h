@@ -0,0 +1,56 @@
+//===- CodeLayout.h - Code layout by the Ext-TSP model ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// Declares a basic block ordering that maximizes the Extended TSP (Ext-TSP)
+/// score of a profiled control flow graph. The score rewards fall-through
+/// jumps fully and short forward and backward jumps partially, which models
+/// how well the layout uses the instruction cache and the branch predictor.
+///
+/// The blocks are given as node indices; node 0 is the entry block, which the
+/// layout keeps first.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_CODELAYOUT_H
+#define LLVM_TRANSFORMS_UTILS_CODELAYOUT_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/// A jump of a control flow graph and the number of times it is taken.
+struct ExtTspEdge {
+  unsigned Src;
+  unsigned Dst;
+  uint64_t Count;
+};
+
+/// Find a layout of the nodes that maximizes the Ext-TSP score.
+///
+/// \p NodeSizes and \p NodeCounts give the size in bytes and the execution
+/// count of each node. Each pair of \p ForcedPairs names two nodes that must
+/// be laid out next to each other in that order, e.g. because the first falls
+/// through into the second in a way that cannot be changed. Returns the new
+/// order of the nodes, which starts with node 0.
+std::vector<unsigned>
+applyExtTspLayout(ArrayRef<uint64_t> NodeSizes, ArrayRef<uint64_t> NodeCounts,
+                  ArrayRef<ExtTspEdge> Edges,
+                  ArrayRef<std::pair<unsigned, unsigned>> ForcedPairs = {});
+
+/// Return the Ext-TSP score of laying out the nodes in \p Order.
+double calcExtTspScore(ArrayRef<unsigned> Order, ArrayRef<uint64_t> NodeSizes,
+                       ArrayRef<ExtTspEdge> Edges);
+
+} // end namespace llvm
+
+#endif // LLVM_TRANSFORMS_UTILS_CODELAYOUT_H
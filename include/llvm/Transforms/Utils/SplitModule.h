@@ -33,10 +33,17 @@ class Module;
 ///   module.
 /// - Internal symbols defined in module-level inline asm should be visible to
 ///   each partition.
+///
+/// If BalancePartitions is true, globals are assigned to partitions by their
+/// estimated codegen cost (instruction count scaled by profile hotness) so
+/// that each partition takes about as long to compile, keeping callers and
+/// callees together where that does not unbalance the split. Otherwise,
+/// globals that need not stay together are distributed by a hash of their
+/// names.
 void SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals = false);
+    bool PreserveLocals = false, bool BalancePartitions = false);
 
 } // end namespace llvm
 
@@ -20,6 +20,7 @@
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/BlockFrequencyInfo.h"
 #include "llvm/Analysis/BranchProbabilityInfo.h"
@@ -32,6 +33,7 @@
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalAlias.h"
@@ -42,6 +44,7 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ModuleSlotTracker.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
 #include "llvm/IR/Use.h"
 #include "llvm/IR/User.h"
@@ -50,6 +53,8 @@
 #include "llvm/Pass.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -71,6 +76,209 @@ cl::opt<FunctionSummary::ForceSummaryHotnessType, true> FSEC(
                           "all-non-critical", "All non-critical edges."),
                clEnumValN(FunctionSummary::FSHT_All, "all", "All edges.")));
 
+static cl::opt<bool> ComputeFunctionHashes(
+    "module-summary-function-hashes", cl::Hidden,
+    cl::desc("Record a hash of each function in the summary, so that ThinLTO "
+             "caches can be keyed on the functions a backend imports rather "
+             "than on whole modules"));
+
+namespace {
+
+/// Computes FunctionSummary body hashes. The hash of a function covers what
+/// importing the function brings into another module: its IR, the metadata
+/// reachable from it, the declarations of the globals it references, and the
+/// target and module flags of its module. It does not depend on the rest of
+/// the module, so editing one function leaves the hashes of the others alone.
+class FunctionHasher {
+  const Module &M;
+  ModuleSlotTracker MST;
+  /// Hash of the parts of the module shared by all of its functions.
+  std::string ModuleContext;
+  /// Hashes of the metadata reachable from each compile unit. Compile units
+  /// are referenced by every function with debug info, so they are summarized
+  /// once instead of being walked for each function.
+  DenseMap<const DICompileUnit *, uint64_t> CompileUnitHashes;
+
+public:
+  FunctionHasher(const Module &M)
+      : M(M), MST(&M, /*ShouldInitializeAllMetadata=*/false) {
+    std::string Text;
+    raw_string_ostream OS(Text);
+    OS << M.getTargetTriple() << '\n' << M.getDataLayoutStr() << '\n';
+    SmallPtrSet<const Metadata *, 16> Visited;
+    if (NamedMDNode *Flags = M.getModuleFlagsMetadata())
+      for (const MDNode *Flag : Flags->operands())
+        printMetadata(Flag, OS, Visited);
+    ModuleContext = utostr(hashText(OS.str()));
+  }
+
+  /// Return the hash of \p F, or 0 if it cannot be hashed independently of
+  /// its module. That is the case for local functions, and for functions that
+  /// refer to locals, because the names these get when promoted contain the
+  /// hash of the whole module.
+  uint64_t hash(const Function &F);
+
+private:
+  static uint64_t hashText(StringRef Text);
+  void printMetadata(const Metadata *MD, raw_ostream &OS,
+                     SmallPtrSetImpl<const Metadata *> &Visited);
+  uint64_t hashCompileUnit(const DICompileUnit *CU);
+  bool printGlobalDeclarations(const Function &F, raw_ostream &OS);
+};
+
+} // end anonymous namespace
+
+/// Hash \p Text after renumbering its metadata (!N) and attribute group (#N)
+/// references in order of first appearance. Slot numbers are assigned across
+/// the whole module, and would otherwise change whenever anything before the
+/// function does.
+uint64_t FunctionHasher::hashText(StringRef Text) {
+  std::string Canonical;
+  Canonical.reserve(Text.size());
+  DenseMap<unsigned, unsigned> MDSlots, AttrSlots;
+  bool InString = false;
+  for (size_t I = 0, E = Text.size(); I != E; ++I) {
+    char C = Text[I];
+    Canonical += C;
+    if (C == '"')
+      InString = !InString;
+    if (InString || (C != '!' && C != '#') || I + 1 == E ||
+        !isDigit(Text[I + 1]))
+      continue;
+    size_t End = I + 1;
+    unsigned Slot = 0;
+    while (End != E && isDigit(Text[End]))
+      Slot = Slot * 10 + (Text[End++] - '0');
+    auto &Slots = C == '!' ? MDSlots : AttrSlots;
+    Canonical += utostr(Slots.insert({Slot, Slots.size()}).first->second);
+    I = End - 1;
+  }
+  MD5 Hasher;
+  Hasher.update(Canonical);
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  // 0 means "no hash".
+  return std::max<uint64_t>(Result.low(), 1);
+}
+
+void FunctionHasher::printMetadata(const Metadata *MD, raw_ostream &OS,
+                                   SmallPtrSetImpl<const Metadata *> &Visited) {
+  const MDNode *N = dyn_cast<MDNode>(MD);
+  if (!N || !Visited.insert(N).second)
+    return;
+  if (auto *CU = dyn_cast<DICompileUnit>(N)) {
+    OS << "cu " << hashCompileUnit(CU) << '\n';
+    return;
+  }
+  N->print(OS, MST, &M);
+  OS << '\n';
+  for (const MDOperand &Op : N->operands())
+    if (Op)
+      printMetadata(Op.get(), OS, Visited);
+}
+
+uint64_t FunctionHasher::hashCompileUnit(const DICompileUnit *CU) {
+  auto Inserted = CompileUnitHashes.insert({CU, 0});
+  if (!Inserted.second)
+    return Inserted.first->second;
+  std::string Text;
+  raw_string_ostream OS(Text);
+  SmallPtrSet<const Metadata *, 32> Visited;
+  Visited.insert(CU);
+  CU->print(OS, MST, &M);
+  OS << '\n';
+  for (const MDOperand &Op : CU->operands())
+    if (Op)
+      printMetadata(Op.get(), OS, Visited);
+  uint64_t Hash = hashText(OS.str());
+  CompileUnitHashes[CU] = Hash;
+  return Hash;
+}
+
+/// Print the properties of the globals referenced by \p F that carry over to
+/// their declarations in an importing module. Returns false if \p F refers
+/// to a local.
+bool FunctionHasher::printGlobalDeclarations(const Function &F,
+                                             raw_ostream &OS) {
+  SmallPtrSet<const User *, 32> Visited;
+  SmallVector<const User *, 32> Worklist;
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB)
+      Worklist.push_back(&I);
+  Worklist.push_back(&F);
+  while (!Worklist.empty()) {
+    const User *U = Worklist.pop_back_val();
+    for (const Use &Op : U->operands()) {
+      auto *C = dyn_cast<Constant>(Op);
+      if (!C || !Visited.insert(C).second)
+        continue;
+      auto *GV = dyn_cast<GlobalValue>(C);
+      if (!GV) {
+        Worklist.push_back(C);
+        continue;
+      }
+      if (GV->hasLocalLinkage())
+        return false;
+      OS << GV->getName() << ' ' << GV->getLinkage() << ' '
+         << GV->getVisibility() << ' ' << GV->getDLLStorageClass() << ' '
+         << GV->getThreadLocalMode() << ' '
+         << unsigned(GV->getUnnamedAddr()) << ' ' << GV->isDSOLocal() << ' ';
+      GV->getValueType()->print(OS);
+      if (auto *Callee = dyn_cast<Function>(GV)) {
+        OS << ' ' << Callee->getCallingConv();
+        AttributeList Attrs = Callee->getAttributes();
+        for (unsigned I = Attrs.index_begin(), E = Attrs.index_end(); I != E;
+             ++I)
+          OS << " {" << Attrs.getAsString(I) << '}';
+      } else if (auto *Var = dyn_cast<GlobalVariable>(GV)) {
+        OS << ' ' << Var->isConstant() << ' ' << Var->getAlignment() << ' '
+           << Var->isExternallyInitialized() << ' ' << Var->getSection();
+      }
+      OS << '\n';
+    }
+  }
+  return true;
+}
+
+uint64_t FunctionHasher::hash(const Function &F) {
+  if (F.hasLocalLinkage())
+    return 0;
+  std::string Text;
+  raw_string_ostream OS(Text);
+  OS << ModuleContext << '\n';
+  if (!printGlobalDeclarations(F, OS))
+    return 0;
+
+  AttributeList Attrs = F.getAttributes();
+  for (unsigned I = Attrs.index_begin(), E = Attrs.index_end(); I != E; ++I)
+    OS << '{' << Attrs.getAsString(I) << "}\n";
+  static_cast<const Value &>(F).print(OS, MST);
+
+  SmallPtrSet<const Metadata *, 32> Visited;
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  F.getAllMetadata(MDs);
+  for (auto &MD : MDs)
+    printMetadata(MD.second, OS, Visited);
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB) {
+      if (auto CS = ImmutableCallSite(&I)) {
+        AttributeList CallAttrs = CS.getAttributes();
+        for (unsigned Idx = CallAttrs.index_begin(),
+                      E = CallAttrs.index_end();
+             Idx != E; ++Idx)
+          OS << '{' << CallAttrs.getAsString(Idx) << "}\n";
+        for (const Value *Arg : CS.args())
+          if (auto *MDV = dyn_cast<MetadataAsValue>(Arg))
+            printMetadata(MDV->getMetadata(), OS, Visited);
+      }
+      MDs.clear();
+      I.getAllMetadata(MDs);
+      for (auto &MD : MDs)
+        printMetadata(MD.second, OS, Visited);
+    }
+  return hashText(OS.str());
+}
+
 // Walk through the operands of a given User via worklist iteration and populate
 // the set of GlobalValue references encountered. Invoked either on an
 // Instruction or a GlobalVariable (which walks its initializer).
@@ -212,7 +420,8 @@ static void
 computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
                        const Function &F, BlockFrequencyInfo *BFI,
                        ProfileSummaryInfo *PSI, bool HasLocalsInUsedOrAsm,
-                       DenseSet<GlobalValue::GUID> &CantBePromoted) {
+                       DenseSet<GlobalValue::GUID> &CantBePromoted,
+                       FunctionHasher *Hasher) {
   // Summary not currently supported for anonymous functions, they should
   // have been named.
   assert(F.hasName());
@@ -361,6 +570,8 @@ computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
       TypeCheckedLoadConstVCalls.takeVector());
   if (NonRenamableLocal)
     CantBePromoted.insert(F.getGUID());
+  if (Hasher)
+    FuncSummary->setBodyHash(Hasher->hash(F));
   Index.addGlobalValueSummary(F, std::move(FuncSummary));
 }
 
@@ -484,6 +695,9 @@ ModuleSummaryIndex llvm::buildModuleSummaryIndex(
 
   // Compute summaries for all functions defined in module, and save in the
   // index.
+  std::unique_ptr<FunctionHasher> Hasher;
+  if (ComputeFunctionHashes)
+    Hasher = llvm::make_unique<FunctionHasher>(M);
   for (auto &F : M) {
     if (F.isDeclaration())
       continue;
@@ -501,7 +715,7 @@ ModuleSummaryIndex llvm::buildModuleSummaryIndex(
 
     computeFunctionSummary(Index, M, F, BFI, PSI,
                            !LocalsUsed.empty() || HasLocalInlineAsmSymbol,
-                           CantBePromoted);
+                           CantBePromoted, Hasher.get());
   }
 
   // Compute summaries for all variables defined in module, and save in the
@@ -71,6 +71,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -93,6 +94,21 @@ static cl::opt<bool> PrintSummaryGUIDs(
     cl::desc(
         "Print the global id for each value when reading the module summary"));
 
+static cl::opt<bool> LazyModuleOnDemandMetadata(
+    "bitcode-ondemand-mds-for-lazy-modules", cl::init(true), cl::Hidden,
+    cl::desc("Load the module-level metadata of a lazily loaded module on "
+             "demand, as is done for importing"));
+
+static cl::opt<bool> ParallelFunctionDecoding(
+    "bitcode-parallel-decode", cl::init(false), cl::Hidden,
+    cl::desc("When materializing a whole module, decode the records of "
+             "function blocks on multiple threads ahead of parsing them"));
+
+static cl::opt<unsigned> ParallelDecodingBatchSize(
+    "bitcode-parallel-decode-batch", cl::init(1024), cl::Hidden,
+    cl::desc("Number of function blocks to decode ahead at a time with "
+             "-bitcode-parallel-decode"));
+
 namespace {
 
 enum {
@@ -438,6 +454,85 @@ BitcodeReaderBase::readNameFromStrtab(ArrayRef<uint64_t> Record) {
 
 namespace {
 
+/// The top-level contents of a function block, decoded without reference to
+/// the LLVMContext so that this can happen on any thread. parseFunctionBody
+/// replays the decoded records instead of reading them from the stream;
+/// sub-blocks are still parsed from the stream, at their recorded positions.
+class DecodedFunctionBlock {
+  struct Entry {
+    /// The record code, or the block ID for sub-blocks.
+    unsigned ID;
+    bool IsSubBlock;
+    /// For records, the operands are Ops[OpsBegin, OpsEnd). For sub-blocks,
+    /// OpsBegin is the bit position just past the block ID.
+    uint64_t OpsBegin, OpsEnd;
+  };
+
+  std::vector<Entry> Entries;
+  std::vector<uint64_t> Ops;
+  /// The position of the END_BLOCK of the function block.
+  uint64_t EndBit = 0;
+  size_t Next = 0;
+
+public:
+  /// Decode the function block whose contents start at \p Bit in a copy of
+  /// \p Stream. Returns false if the block is malformed, in which case it is
+  /// left to parseFunctionBody to diagnose.
+  bool decode(BitstreamCursor Stream, uint64_t Bit) {
+    Stream.JumpToBit(Bit);
+    if (Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+      return false;
+    SmallVector<uint64_t, 64> Record;
+    while (true) {
+      uint64_t EntryBit = Stream.GetCurrentBitNo();
+      BitstreamEntry Entry = Stream.advance();
+      switch (Entry.Kind) {
+      case BitstreamEntry::Error:
+        return false;
+      case BitstreamEntry::EndBlock:
+        EndBit = EntryBit;
+        return true;
+      case BitstreamEntry::SubBlock:
+        Entries.push_back({Entry.ID, true, Stream.GetCurrentBitNo(), 0});
+        if (Stream.SkipBlock())
+          return false;
+        break;
+      case BitstreamEntry::Record: {
+        Record.clear();
+        unsigned Code = Stream.readRecord(Entry.ID, Record);
+        Entries.push_back(
+            {Code, false, Ops.size(), Ops.size() + Record.size()});
+        Ops.insert(Ops.end(), Record.begin(), Record.end());
+        break;
+      }
+      }
+    }
+  }
+
+  /// Return the next entry, as BitstreamCursor::advance would. \p Stream is
+  /// moved to the start of sub-blocks, and past the END_BLOCK of the function
+  /// block once all records have been replayed.
+  BitstreamEntry advance(BitstreamCursor &Stream) {
+    if (Next == Entries.size()) {
+      Stream.JumpToBit(EndBit);
+      return Stream.advance();
+    }
+    const Entry &E = Entries[Next];
+    if (!E.IsSubBlock)
+      return BitstreamEntry::getRecord(0);
+    ++Next;
+    Stream.JumpToBit(E.OpsBegin);
+    return BitstreamEntry::getSubBlock(E.ID);
+  }
+
+  /// Read the record returned by the last call to advance.
+  unsigned readRecord(SmallVectorImpl<uint64_t> &Record) {
+    const Entry &E = Entries[Next++];
+    Record.append(Ops.begin() + E.OpsBegin, Ops.begin() + E.OpsEnd);
+    return E.ID;
+  }
+};
+
 class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   LLVMContext &Context;
   Module *TheModule = nullptr;
@@ -494,6 +589,9 @@ class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   /// where to find deferred function body in the stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// Function blocks decoded ahead of time by decodeFunctionBlocks.
+  DenseMap<Function *, DecodedFunctionBlock> DecodedFunctionBlocks;
+
   /// When Metadata block is initially scanned when parsing the module, we may
   /// choose to defer parsing of the metadata. This vector contains info about
   /// which Metadata blocks are deferred.
@@ -672,6 +770,7 @@ private:
   Error rememberAndSkipMetadata();
   Error typeCheckLoadStoreInst(Type *ValType, Type *PtrType);
   Error parseFunctionBody(Function *F);
+  void decodeFunctionBlocks(ThreadPool &Pool, ArrayRef<Function *> Functions);
   Error globalCleanup();
   Error resolveGlobalAndIndirectSymbolInits();
   Error parseUseLists();
@@ -3348,7 +3447,12 @@ Error BitcodeReader::parseModule(uint64_t ResumeBit,
 Error BitcodeReader::parseBitcodeInto(Module *M, bool ShouldLazyLoadMetadata,
                                       bool IsImporting) {
   TheModule = M;
+  // Metadata that is parsed lazily can also be loaded on demand, so that
+  // records only referenced by functions that are never materialized are not
+  // loaded.
   MDLoader = MetadataLoader(Stream, *M, ValueList, IsImporting,
+                            /*LoadOnDemand=*/ShouldLazyLoadMetadata &&
+                                LazyModuleOnDemandMetadata,
                             [&](unsigned ID) { return getTypeByID(ID); });
   return parseModule(0, ShouldLazyLoadMetadata);
 }
@@ -3399,11 +3503,20 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
 
   std::vector<OperandBundleDef> OperandBundles;
 
+  // If the block was decoded ahead of time, replay its records.
+  Optional<DecodedFunctionBlock> Decoded;
+  auto DecodedI = DecodedFunctionBlocks.find(F);
+  if (DecodedI != DecodedFunctionBlocks.end()) {
+    Decoded = std::move(DecodedI->second);
+    DecodedFunctionBlocks.erase(DecodedI);
+  }
+
   // Read all the records.
   SmallVector<uint64_t, 64> Record;
 
   while (true) {
-    BitstreamEntry Entry = Stream.advance();
+    BitstreamEntry Entry =
+        Decoded ? Decoded->advance(Stream) : Stream.advance();
 
     switch (Entry.Kind) {
     case BitstreamEntry::Error:
@@ -3451,7 +3564,8 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
     // Read a record.
     Record.clear();
     Instruction *I = nullptr;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = Decoded ? Decoded->readRecord(Record)
+                               : Stream.readRecord(Entry.ID, Record);
     switch (BitCode) {
     default: // Default behavior: reject
       return error("Invalid value");
@@ -3511,12 +3625,14 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
 
       MDNode *Scope = nullptr, *IA = nullptr;
       if (ScopeID) {
-        Scope = MDLoader->getMDNodeFwdRefOrNull(ScopeID - 1);
+        Scope = dyn_cast_or_null<MDNode>(
+            MDLoader->getMetadataFwdRefOrLoad(ScopeID - 1));
         if (!Scope)
           return error("Invalid record");
       }
       if (IAID) {
-        IA = MDLoader->getMDNodeFwdRefOrNull(IAID - 1);
+        IA = dyn_cast_or_null<MDNode>(
+            MDLoader->getMetadataFwdRefOrLoad(IAID - 1));
         if (!IA)
           return error("Invalid record");
       }
@@ -4752,6 +4868,24 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
   return materializeForwardReferencedFunctions();
 }
 
+/// Decode the blocks of \p Functions on \p Pool, for parseFunctionBody to
+/// pick up.
+void BitcodeReader::decodeFunctionBlocks(ThreadPool &Pool,
+                                         ArrayRef<Function *> Functions) {
+  std::vector<DecodedFunctionBlock> Blocks(Functions.size());
+  std::unique_ptr<bool[]> Succeeded(new bool[Functions.size()]);
+  for (size_t I = 0, E = Functions.size(); I != E; ++I) {
+    uint64_t Bit = DeferredFunctionInfo.lookup(Functions[I]);
+    Pool.async([this, &Blocks, &Succeeded, I, Bit] {
+      Succeeded[I] = Blocks[I].decode(Stream, Bit);
+    });
+  }
+  Pool.wait();
+  for (size_t I = 0, E = Functions.size(); I != E; ++I)
+    if (Succeeded[I])
+      DecodedFunctionBlocks[Functions[I]] = std::move(Blocks[I]);
+}
+
 Error BitcodeReader::materializeModule() {
   if (Error Err = materializeMetadata())
     return Err;
@@ -4759,6 +4893,26 @@ Error BitcodeReader::materializeModule() {
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
+  // Decoding the records of a function block does not touch the context, so
+  // it can be done on several threads before the IR is built serially.
+  if (ParallelFunctionDecoding) {
+    std::vector<Function *> Pending;
+    for (Function &F : *TheModule)
+      if (F.isMaterializable() && DeferredFunctionInfo.lookup(&F))
+        Pending.push_back(&F);
+    ThreadPool Pool;
+    size_t BatchSize = std::max(1u, unsigned(ParallelDecodingBatchSize));
+    for (size_t Begin = 0; Begin < Pending.size(); Begin += BatchSize) {
+      ArrayRef<Function *> Batch = makeArrayRef(Pending).slice(
+          Begin, std::min(BatchSize, Pending.size() - Begin));
+      decodeFunctionBlocks(Pool, Batch);
+      for (Function *F : Batch)
+        if (Error Err = materialize(F))
+          return Err;
+      DecodedFunctionBlocks.clear();
+    }
+  }
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Function &F : *TheModule) {
@@ -5195,6 +5349,7 @@ Error ModuleSummaryIndexBitcodeReader::parseEntireSummary(unsigned ID) {
       PendingTypeCheckedLoadVCalls;
   std::vector<FunctionSummary::ConstVCall> PendingTypeTestAssumeConstVCalls,
       PendingTypeCheckedLoadConstVCalls;
+  uint64_t PendingBodyHash = 0;
 
   while (true) {
     BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
@@ -5293,6 +5448,8 @@ Error ModuleSummaryIndexBitcodeReader::parseEntireSummary(unsigned ID) {
       PendingTypeCheckedLoadVCalls.clear();
       PendingTypeTestAssumeConstVCalls.clear();
       PendingTypeCheckedLoadConstVCalls.clear();
+      FS->setBodyHash(PendingBodyHash);
+      PendingBodyHash = 0;
       auto VIAndOriginalGUID = getValueInfoFromValueId(ValueID);
       FS->setModulePath(getThisModule()->first());
       FS->setOriginalName(VIAndOriginalGUID.second);
@@ -5386,6 +5543,8 @@ Error ModuleSummaryIndexBitcodeReader::parseEntireSummary(unsigned ID) {
       PendingTypeCheckedLoadVCalls.clear();
       PendingTypeTestAssumeConstVCalls.clear();
       PendingTypeCheckedLoadConstVCalls.clear();
+      FS->setBodyHash(PendingBodyHash);
+      PendingBodyHash = 0;
       LastSeenSummary = FS.get();
       LastSeenGUID = VI.getGUID();
       FS->setModulePath(ModuleIdMap[ModuleId]);
@@ -5445,6 +5604,10 @@ Error ModuleSummaryIndexBitcodeReader::parseEntireSummary(unsigned ID) {
       LastSeenGUID = 0;
       break;
     }
+    case bitc::FS_FUNCTION_HASH:
+      PendingBodyHash = Record[0];
+      break;
+
     case bitc::FS_TYPE_TESTS:
       assert(PendingTypeTests.empty());
       PendingTypeTests.insert(PendingTypeTests.end(), Record.begin(),
@@ -90,6 +90,11 @@ using namespace llvm;
 STATISTIC(NumMDStringLoaded, "Number of MDStrings loaded");
 STATISTIC(NumMDNodeTemporary, "Number of MDNode::Temporary created");
 STATISTIC(NumMDRecordLoaded, "Number of Metadata records loaded");
+STATISTIC(NumMDRecordLoadedOnDemand,
+          "Number of Metadata records of lazily loaded modules loaded on "
+          "demand");
+STATISTIC(NumMDRecordNeverLoaded,
+          "Number of Metadata records of lazily loaded modules never loaded");
 
 /// Flag whether we need to import full type definitions for ThinLTO.
 /// Currently needed for Darwin and LLDB.
@@ -100,7 +105,7 @@ static cl::opt<bool> ImportFullTypeDefinitions(
 static cl::opt<bool> DisableLazyLoading(
     "disable-ondemand-mds-loading", cl::init(false), cl::Hidden,
     cl::desc("Force disable the lazy-loading on-demand of metadata when "
-             "loading bitcode for importing."));
+             "loading bitcode for importing or lazily loading a module."));
 
 namespace {
 
@@ -459,6 +464,10 @@ class MetadataLoader::MetadataLoaderImpl {
   /// True if metadata is being parsed for a module being ThinLTO imported.
   bool IsImporting = false;
 
+  /// True if module-level metadata records should only be loaded when they
+  /// are referenced, rather than all at once.
+  bool LoadOnDemand = false;
+
   Error parseOneMetadata(SmallVectorImpl<uint64_t> &Record, unsigned Code,
                          PlaceholderQueue &Placeholders, StringRef Blob,
                          unsigned &NextMetadataNo);
@@ -625,10 +634,22 @@ public:
   MetadataLoaderImpl(BitstreamCursor &Stream, Module &TheModule,
                      BitcodeReaderValueList &ValueList,
                      std::function<Type *(unsigned)> getTypeByID,
-                     bool IsImporting)
+                     bool IsImporting, bool LoadOnDemand)
       : MetadataList(TheModule.getContext()), ValueList(ValueList),
         Stream(Stream), Context(TheModule.getContext()), TheModule(TheModule),
-        getTypeByID(std::move(getTypeByID)), IsImporting(IsImporting) {}
+        getTypeByID(std::move(getTypeByID)), IsImporting(IsImporting),
+        LoadOnDemand(LoadOnDemand) {}
+
+  ~MetadataLoaderImpl() {
+    // Importing only ever loads what the imported functions reference.
+    if (!AreStatisticsEnabled() || IsImporting || !LoadOnDemand)
+      return;
+    for (unsigned ID = MDStringRef.size(),
+                  E = MDStringRef.size() + GlobalMetadataBitPosIndex.size();
+         ID != E; ++ID)
+      if (!MetadataList.lookup(ID))
+        ++NumMDRecordNeverLoaded;
+  }
 
   Error parseMetadata(bool ModuleLevel);
 
@@ -857,7 +878,7 @@ Error MetadataLoader::MetadataLoaderImpl::parseMetadata(bool ModuleLevel) {
 
   // We lazy-load module-level metadata: we build an index for each record, and
   // then load individual record as needed, starting with the named metadata.
-  if (ModuleLevel && IsImporting && MetadataList.empty() &&
+  if (ModuleLevel && (IsImporting || LoadOnDemand) && MetadataList.empty() &&
       !DisableLazyLoading) {
     auto SuccessOrErr = lazyLoadModuleMetadataBlock();
     if (!SuccessOrErr)
@@ -937,6 +958,8 @@ void MetadataLoader::MetadataLoaderImpl::lazyLoadOneMetadata(
   IndexCursor.JumpToBit(GlobalMetadataBitPosIndex[ID - MDStringRef.size()]);
   auto Entry = IndexCursor.advanceSkippingSubblocks();
   ++NumMDRecordLoaded;
+  if (!IsImporting)
+    ++NumMDRecordLoadedOnDemand;
   unsigned Code = IndexCursor.readRecord(Entry.ID, Record, &Blob);
   if (Error Err = parseOneMetadata(Record, Code, Placeholders, Blob, ID))
     report_fatal_error("Can't lazyload MD");
@@ -1967,10 +1990,11 @@ MetadataLoader::MetadataLoader(MetadataLoader &&RHS)
 MetadataLoader::~MetadataLoader() = default;
 MetadataLoader::MetadataLoader(BitstreamCursor &Stream, Module &TheModule,
                                BitcodeReaderValueList &ValueList,
-                               bool IsImporting,
+                               bool IsImporting, bool LoadOnDemand,
                                std::function<Type *(unsigned)> getTypeByID)
-    : Pimpl(llvm::make_unique<MetadataLoaderImpl>(
-          Stream, TheModule, ValueList, std::move(getTypeByID), IsImporting)) {}
+    : Pimpl(llvm::make_unique<MetadataLoaderImpl>(Stream, TheModule, ValueList,
+                                                  std::move(getTypeByID),
+                                                  IsImporting, LoadOnDemand)) {}
 
 Error MetadataLoader::parseMetadata(bool ModuleLevel) {
   return Pimpl->parseMetadata(ModuleLevel);
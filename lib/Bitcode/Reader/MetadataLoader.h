@@ -40,8 +40,11 @@ class MetadataLoader {
 
 public:
   ~MetadataLoader();
+  /// If \p IsImporting or \p LoadOnDemand is true, module-level metadata
+  /// records are only loaded once something references them.
   MetadataLoader(BitstreamCursor &Stream, Module &TheModule,
                  BitcodeReaderValueList &ValueList, bool IsImporting,
+                 bool LoadOnDemand,
                  std::function<Type *(unsigned)> getTypeByID);
   MetadataLoader &operator=(MetadataLoader &&);
   MetadataLoader(MetadataLoader &&);
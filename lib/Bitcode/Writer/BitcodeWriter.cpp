@@ -3455,6 +3455,8 @@ void ModuleBitcodeWriterBase::writePerModuleFunctionSummaryRecord(
   FunctionSummary *FS = cast<FunctionSummary>(Summary);
   std::set<GlobalValue::GUID> ReferencedTypeIds;
   writeFunctionTypeMetadataRecords(Stream, FS, ReferencedTypeIds);
+  if (uint64_t Hash = FS->getBodyHash())
+    Stream.EmitRecord(bitc::FS_FUNCTION_HASH, ArrayRef<uint64_t>{Hash});
 
   NameVals.push_back(getEncodedGVSummaryFlags(FS->flags()));
   NameVals.push_back(FS->instCount());
@@ -3765,6 +3767,8 @@ void IndexBitcodeWriter::writeCombinedGlobalValueSummary() {
 
     auto *FS = cast<FunctionSummary>(S);
     writeFunctionTypeMetadataRecords(Stream, FS, ReferencedTypeIds);
+    if (uint64_t Hash = FS->getBodyHash())
+      Stream.EmitRecord(bitc::FS_FUNCTION_HASH, ArrayRef<uint64_t>{Hash});
 
     NameVals.push_back(*ValueId);
     NameVals.push_back(Index.getModuleId(FS->modulePath()));
@@ -965,8 +965,10 @@ void AsmPrinter::emitCFIInstruction(const MachineInstr &MI) {
   auto I = std::next(MI.getIterator());
   while (I != MBB->end() && I->isTransient())
     ++I;
+  auto NextMBB = std::next(MBB->getIterator());
   if (I == MBB->instr_end() &&
-      MBB->getReverseIterator() == MBB->getParent()->rbegin())
+      (NextMBB == MBB->getParent()->end() ||
+       NextMBB->isInColdFragment() != MBB->isInColdFragment()))
     return;
 
   const std::vector<MCCFIInstruction> &Instrs = MF->getFrameInstructions();
@@ -1051,10 +1053,11 @@ void AsmPrinter::EmitFunctionBody() {
     }
   }
 
-  // Print out code for the function.
+  // Print out code for the function. The blocks of the cold fragment, if
+  // any, are printed in their own section after the rest of the function.
   bool HasAnyRealCode = false;
   int NumInstsInFunction = 0;
-  for (auto &MBB : *MF) {
+  auto EmitBlock = [&](const MachineBasicBlock &MBB) {
     // Print a label for the basic block.
     EmitBasicBlockStart(MBB);
     for (auto &MI : MBB) {
@@ -1127,15 +1130,13 @@ void AsmPrinter::EmitFunctionBody() {
     }
 
     EmitBasicBlockEnd(MBB);
-  }
+  };
 
-  EmittedInsts += NumInstsInFunction;
-  MachineOptimizationRemarkAnalysis R(DEBUG_TYPE, "InstructionCount",
-                                      MF->getFunction().getSubprogram(),
-                                      &MF->front());
-  R << ore::NV("NumInstructions", NumInstsInFunction)
-    << " instructions in function";
-  ORE->emit(R);
+  auto ColdBegin = find_if(*MF, [](const MachineBasicBlock &MBB) {
+    return MBB.isInColdFragment();
+  });
+  for (const MachineBasicBlock &MBB : make_range(MF->begin(), ColdBegin))
+    EmitBlock(MBB);
 
   // If the function is empty and the object file uses .subsections_via_symbols,
   // then we need to emit *something* to the function body to prevent the
@@ -1197,6 +1198,66 @@ void AsmPrinter::EmitFunctionBody() {
     HI.Handler->markFunctionEnd();
   }
 
+  // Emit the cold fragment in a section of its own.
+  if (ColdBegin != MF->end()) {
+    MCSection *Section =
+        getObjFileLowering().getSectionForColdFragment(MF->getFunction(), TM);
+    assert(Section && "The object format does not support cold fragments");
+    OutStreamer->SwitchSection(Section);
+    EmitAlignment(MF->getAlignment());
+
+    // The fragment starts at a local function symbol of its own, so that
+    // profilers and symbolizers attribute its code to the function.
+    CurrentFnColdBegin =
+        OutContext.createUniqueSymbol(CurrentFnSym->getName() + ".cold");
+    if (MAI->hasDotTypeDotSizeDirective())
+      OutStreamer->EmitSymbolAttribute(CurrentFnColdBegin,
+                                       MCSA_ELF_TypeFunction);
+    OutStreamer->EmitLabel(CurrentFnColdBegin);
+
+    for (const HandlerInfo &HI : Handlers) {
+      NamedRegionTimer T(HI.TimerName, HI.TimerDescription, HI.TimerGroupName,
+                         HI.TimerGroupDescription, TimePassesIsEnabled);
+      HI.Handler->beginFragment(&*ColdBegin, [](AsmPrinter *Asm) {
+        return Asm->getCurExceptionSym();
+      });
+    }
+
+    // The frame of the fragment starts in the state that the frame of the hot
+    // part ends in, which is the state that the CFI of the fragment assumes.
+    for (const MachineBasicBlock &MBB : make_range(MF->begin(), ColdBegin))
+      for (const MachineInstr &MI : MBB)
+        if (MI.isCFIInstruction())
+          emitCFIInstruction(MI);
+
+    for (const MachineBasicBlock &MBB : make_range(ColdBegin, MF->end()))
+      EmitBlock(MBB);
+
+    CurrentFnColdEnd = createTempSymbol("func_cold_end");
+    OutStreamer->EmitLabel(CurrentFnColdEnd);
+    if (MAI->hasDotTypeDotSizeDirective())
+      OutStreamer->emitELFSize(
+          CurrentFnColdBegin,
+          MCBinaryExpr::createSub(
+              MCSymbolRefExpr::create(CurrentFnColdEnd, OutContext),
+              MCSymbolRefExpr::create(CurrentFnColdBegin, OutContext),
+              OutContext));
+
+    for (const HandlerInfo &HI : Handlers) {
+      NamedRegionTimer T(HI.TimerName, HI.TimerDescription, HI.TimerGroupName,
+                         HI.TimerGroupDescription, TimePassesIsEnabled);
+      HI.Handler->endFragment();
+    }
+  }
+
+  EmittedInsts += NumInstsInFunction;
+  MachineOptimizationRemarkAnalysis R(DEBUG_TYPE, "InstructionCount",
+                                      MF->getFunction().getSubprogram(),
+                                      &MF->front());
+  R << ore::NV("NumInstructions", NumInstsInFunction)
+    << " instructions in function";
+  ORE->emit(R);
+
   // Print out jump tables referenced by the function.
   EmitJumpTableInfo();
 
@@ -1564,6 +1625,8 @@ void AsmPrinter::SetupMachineFunction(MachineFunction &MF) {
   CurrentFnSym = getSymbol(&MF.getFunction());
   CurrentFnSymForSize = CurrentFnSym;
   CurrentFnBegin = nullptr;
+  CurrentFnColdBegin = nullptr;
+  CurrentFnColdEnd = nullptr;
   CurExceptionSym = nullptr;
   bool NeedsLocalForSize = MAI->needsLocalForSize();
   if (needFuncLabelsForEHOrDebugInfo(MF, MMI) || NeedsLocalForSize ||
@@ -234,6 +234,14 @@ void DebugHandlerBase::beginFunction(const MachineFunction *MF) {
   beginFunctionImpl(MF);
 }
 
+void DebugHandlerBase::beginFragment(const MachineBasicBlock *MBB,
+                                     ExceptionSymbolProvider ESP) {
+  // Labels and line entries of the hot part do not describe the fragment,
+  // which starts in another section.
+  PrevInstLoc = DebugLoc();
+  PrevLabel = Asm->getColdFragmentBegin();
+}
+
 void DebugHandlerBase::beginInstruction(const MachineInstr *MI) {
   if (!MMI->hasDebugInfo())
     return;
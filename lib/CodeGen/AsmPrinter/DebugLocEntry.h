@@ -125,6 +125,15 @@ public:
     return false;
   }
 
+  /// Split this entry into one that ends at \p NewEnd and one, which is
+  /// returned, that begins at \p NewBegin. Both keep the values.
+  DebugLocEntry splitAt(const MCSymbol *NewEnd, const MCSymbol *NewBegin) {
+    DebugLocEntry Rest = *this;
+    Rest.Begin = NewBegin;
+    End = NewEnd;
+    return Rest;
+  }
+
   const MCSymbol *getBeginSym() const { return Begin; }
   const MCSymbol *getEndSym() const { return End; }
   ArrayRef<Value> getValues() const { return Values; }
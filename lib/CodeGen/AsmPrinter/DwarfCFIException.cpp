@@ -139,8 +139,9 @@ void DwarfCFIException::beginFragment(const MachineBasicBlock *MBB,
 
   Asm->OutStreamer->EmitCFIStartProc(/*IsSimple=*/false);
 
-  // Indicate personality routine, if any.
-  if (!shouldEmitPersonality)
+  // Indicate personality routine, if any. The cold fragment has neither
+  // landing pads nor invokes, so exceptions unwind through it unhandled.
+  if (!shouldEmitPersonality || MBB->isInColdFragment())
     return;
 
   auto &F = MBB->getParent()->getFunction();
@@ -319,7 +319,16 @@ void DwarfCompileUnit::attachLowHighPC(DIE &D, const MCSymbol *Begin,
 DIE &DwarfCompileUnit::updateSubprogramScopeDIE(const DISubprogram *SP) {
   DIE *SPDie = getOrCreateSubprogramDIE(SP, includeMinimalInlineScopes());
 
-  attachLowHighPC(*SPDie, Asm->getFunctionBegin(), Asm->getFunctionEnd());
+  if (MCSymbol *ColdBegin = Asm->getColdFragmentBegin()) {
+    // The cold fragment is in another section, so the subprogram covers two
+    // ranges. The range list leaves no label behind for the aranges.
+    DD->addArangeLabel(SymbolCU(this, Asm->getFunctionBegin()));
+    DD->addArangeLabel(SymbolCU(this, ColdBegin));
+    attachRangesOrLowHighPC(
+        *SPDie, {RangeSpan(Asm->getFunctionBegin(), Asm->getFunctionEnd()),
+                 RangeSpan(ColdBegin, Asm->getColdFragmentEnd())});
+  } else
+    attachLowHighPC(*SPDie, Asm->getFunctionBegin(), Asm->getFunctionEnd());
   if (DD->useAppleExtensionAttributes() &&
       !DD->getCurrentFunction()->getTarget().Options.DisableFramePointerElim(
           *DD->getCurrentFunction()))
@@ -442,9 +451,18 @@ void DwarfCompileUnit::attachRangesOrLowHighPC(
     DIE &Die, const SmallVectorImpl<InsnRange> &Ranges) {
   SmallVector<RangeSpan, 2> List;
   List.reserve(Ranges.size());
-  for (const InsnRange &R : Ranges)
-    List.push_back(RangeSpan(DD->getLabelBeforeInsn(R.first),
-                             DD->getLabelAfterInsn(R.second)));
+  for (const InsnRange &R : Ranges) {
+    MCSymbol *Begin = DD->getLabelBeforeInsn(R.first);
+    MCSymbol *End = DD->getLabelAfterInsn(R.second);
+    // A range that runs from the hot part into the cold fragment of the
+    // function covers the end of the one and the start of the other.
+    if (R.first->getParent()->isInColdFragment() !=
+        R.second->getParent()->isInColdFragment()) {
+      List.push_back(RangeSpan(Begin, Asm->getFunctionEnd()));
+      Begin = Asm->getColdFragmentBegin();
+    }
+    List.push_back(RangeSpan(Begin, End));
+  }
   attachRangesOrLowHighPC(Die, std::move(List));
 }
 
@@ -65,6 +65,7 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Target/TargetLoweringObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
@@ -99,6 +100,18 @@ static cl::opt<bool>
                            cl::desc("Generate DWARF4 type units."),
                            cl::init(false));
 
+enum TypeSignatureHashKind { MD5Signature, XXH3Signature };
+
+static cl::opt<TypeSignatureHashKind> TypeSignatureHash(
+    "dwarf-type-signature-hash", cl::Hidden,
+    cl::desc("Hash function used to compute DWARF type unit signatures. All "
+             "objects in a link must use the same one for type units to be "
+             "deduplicated."),
+    cl::values(clEnumValN(MD5Signature, "md5",
+                          "Low 64 bits of MD5, as suggested by DWARF 4"),
+               clEnumValN(XXH3Signature, "xxh3", "64-bit XXH3 (faster)")),
+    cl::init(MD5Signature));
+
 static cl::opt<bool> SplitDwarfCrossCuReferences(
     "split-dwarf-cross-cu-references", cl::Hidden,
     cl::desc("Enable cross-cu references in DWO files"), cl::init(false));
@@ -1074,7 +1087,8 @@ DwarfDebug::buildLocationList(SmallVectorImpl<DebugLocEntry> &DebugLoc,
     if (End != nullptr)
       EndLabel = getLabelAfterInsn(End);
     else if (std::next(I) == Ranges.end())
-      EndLabel = Asm->getFunctionEnd();
+      EndLabel = Asm->getColdFragmentEnd() ? Asm->getColdFragmentEnd()
+                                           : Asm->getFunctionEnd();
     else
       EndLabel = getLabelBeforeInsn(std::next(I)->first);
     assert(EndLabel && "Forgot label after instruction ending a range!");
@@ -1119,6 +1133,19 @@ DwarfDebug::buildLocationList(SmallVectorImpl<DebugLocEntry> &DebugLoc,
     if (PrevEntry != DebugLoc.rend() && PrevEntry->MergeRanges(*CurEntry))
       DebugLoc.pop_back();
   }
+
+  // An entry that runs from the hot part into the cold fragment of the
+  // function covers the end of the one and the start of the other.
+  MCSymbol *ColdBegin = Asm->getColdFragmentBegin();
+  if (!ColdBegin)
+    return;
+  for (auto I = DebugLoc.begin(); I != DebugLoc.end(); ++I) {
+    if (&I->getBeginSym()->getSection() == &I->getEndSym()->getSection())
+      continue;
+    DebugLocEntry Rest = I->splitAt(Asm->getFunctionEnd(), ColdBegin);
+    if (Rest.getEndSym() != ColdBegin)
+      I = DebugLoc.insert(std::next(I), std::move(Rest));
+  }
 }
 
 DbgVariable *DwarfDebug::createConcreteVariable(DwarfCompileUnit &TheCU,
@@ -1417,6 +1444,8 @@ void DwarfDebug::endFunctionImpl(const MachineFunction *MF) {
 
   // Add the range of this function to the list of ranges for the CU.
   TheCU.addRange(RangeSpan(Asm->getFunctionBegin(), Asm->getFunctionEnd()));
+  if (MCSymbol *ColdBegin = Asm->getColdFragmentBegin())
+    TheCU.addRange(RangeSpan(ColdBegin, Asm->getColdFragmentEnd()));
 
   // Under -gmlt, skip building the subprogram if there are no inlined
   // subroutines inside it. But with -fdebug-info-for-profiling, the subprogram
@@ -2319,6 +2348,9 @@ MCDwarfDwoLineTable *DwarfDebug::getDwoLineTable(const DwarfCompileUnit &CU) {
 }
 
 uint64_t DwarfDebug::makeTypeSignature(StringRef Identifier) {
+  if (TypeSignatureHash == XXH3Signature)
+    return xxh3_64bits(Identifier);
+
   MD5 Hash;
   Hash.update(Identifier);
   // ... take the least significant 8 bytes and return those. Our MD5
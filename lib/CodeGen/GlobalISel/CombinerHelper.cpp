@@ -11,6 +11,7 @@
 #include "llvm/CodeGen/GlobalISel/Utils.h"
 #include "llvm/CodeGen/MachineInstr.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Constants.h"
 
 #define DEBUG_TYPE "gi-combine"
 
@@ -19,7 +20,14 @@ using namespace llvm;
 CombinerHelper::CombinerHelper(MachineIRBuilder &B) :
   Builder(B), MRI(Builder.getMF().getRegInfo()) {}
 
-bool CombinerHelper::tryCombineCopy(MachineInstr &MI) {
+void CombinerHelper::replaceInstWithReg(MachineInstr &MI, unsigned Reg) {
+  unsigned DstReg = MI.getOperand(0).getReg();
+  assert(MRI.getType(DstReg) == MRI.getType(Reg) && "Mismatched types");
+  MI.eraseFromParent();
+  MRI.replaceRegWith(DstReg, Reg);
+}
+
+bool CombinerHelper::matchCombineCopy(MachineInstr &MI) {
   if (MI.getOpcode() != TargetOpcode::COPY)
     return false;
   unsigned DstReg = MI.getOperand(0).getReg();
@@ -28,12 +36,44 @@ bool CombinerHelper::tryCombineCopy(MachineInstr &MI) {
   LLT SrcTy = MRI.getType(SrcReg);
   // Simple Copy Propagation.
   // a(sx) = COPY b(sx) -> Replace all uses of a with b.
-  if (DstTy.isValid() && SrcTy.isValid() && DstTy == SrcTy) {
-    MI.eraseFromParent();
-    MRI.replaceRegWith(DstReg, SrcReg);
-    return true;
-  }
-  return false;
+  return DstTy.isValid() && SrcTy.isValid() && DstTy == SrcTy;
+}
+
+void CombinerHelper::applyCombineCopy(MachineInstr &MI) {
+  replaceInstWithReg(MI, MI.getOperand(1).getReg());
+}
+
+bool CombinerHelper::tryCombineCopy(MachineInstr &MI) {
+  if (!matchCombineCopy(MI))
+    return false;
+  applyCombineCopy(MI);
+  return true;
+}
+
+bool CombinerHelper::matchMulByPowerOf2(MachineInstr &MI,
+                                        const MachineOperand &Imm,
+                                        int64_t &ShiftAmt) {
+  if (!MRI.getType(MI.getOperand(0).getReg()).isScalar() || !Imm.isCImm())
+    return false;
+  const APInt &Val = Imm.getCImm()->getValue();
+  if (!Val.isPowerOf2() || Val.isOneValue())
+    return false;
+  ShiftAmt = Val.logBase2();
+  return true;
+}
+
+void CombinerHelper::applyMulByPowerOf2(MachineInstr &MI, int64_t ShiftAmt) {
+  unsigned DstReg = MI.getOperand(0).getReg();
+  unsigned SrcReg = MI.getOperand(1).getReg();
+  Builder.setInstr(MI);
+  unsigned ShiftReg =
+      Builder.buildConstant(MRI.getType(SrcReg), ShiftAmt)->getOperand(0)
+          .getReg();
+  Builder.buildInstr(TargetOpcode::G_SHL)
+      .addDef(DstReg)
+      .addUse(SrcReg)
+      .addUse(ShiftReg);
+  MI.eraseFromParent();
 }
 
 bool CombinerHelper::tryCombine(MachineInstr &MI) {
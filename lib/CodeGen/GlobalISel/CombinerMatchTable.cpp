@@ -0,0 +1,202 @@
+//===- lib/CodeGen/GlobalISel/CombinerMatchTable.cpp ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file This file implements the interpreter for the match tables of the
+/// TableGen-erated combiner helpers.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/GlobalISel/CombinerMatchTable.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/TargetRegisterInfo.h"
+#include "llvm/Support/CodeGenCoverage.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "gi-combiner-matchtable"
+
+using namespace llvm;
+
+#ifdef LLVM_GISEL_COV_PREFIX
+static cl::opt<std::string>
+    CoveragePrefix("gicombiner-coverage-prefix",
+                   cl::init(LLVM_GISEL_COV_PREFIX),
+                   cl::desc("Record GlobalISel combiner rule coverage files "
+                            "of this prefix if instrumentation was generated"));
+#else
+static const std::string CoveragePrefix = "";
+#endif
+
+bool GICombinerMatcher::executeMatchTable(const int64_t *MatchTable,
+                                          MachineInstr &MI,
+                                          MachineRegisterInfo &MRI,
+                                          CombinerHelper &Helper,
+                                          CodeGenCoverage &CoverageInfo) const {
+  uint64_t CurrentIdx = 0;
+  SmallVector<uint64_t, 4> OnFailResumeAt;
+  GICombinerMatchState State(MI);
+
+  enum RejectAction { RejectAndGiveUp, RejectAndResume };
+  auto handleReject = [&]() -> RejectAction {
+    LLVM_DEBUG(dbgs() << CurrentIdx << ": Rejected\n");
+    // Forget whatever the failed rule bound so far.
+    State.MIs.resize(1);
+    State.MatchInfo = 0;
+    if (OnFailResumeAt.empty())
+      return RejectAndGiveUp;
+    CurrentIdx = OnFailResumeAt.pop_back_val();
+    LLVM_DEBUG(dbgs() << CurrentIdx << ": Resume at " << CurrentIdx << " ("
+                      << OnFailResumeAt.size() << " try-blocks remain)\n");
+    return RejectAndResume;
+  };
+
+  while (true) {
+    assert(CurrentIdx != ~0u && "Invalid MatchTable index");
+    int64_t MatcherOpcode = MatchTable[CurrentIdx++];
+    switch (MatcherOpcode) {
+    case GICM_Try: {
+      LLVM_DEBUG(dbgs() << CurrentIdx << ": Begin try-block\n");
+      OnFailResumeAt.push_back(MatchTable[CurrentIdx++]);
+      break;
+    }
+
+    case GICM_CheckOpcode: {
+      int64_t InsnID = MatchTable[CurrentIdx++];
+      int64_t Expected = MatchTable[CurrentIdx++];
+      assert(State.MIs[InsnID] != nullptr && "Used insn before defined");
+      unsigned Opcode = State.MIs[InsnID]->getOpcode();
+      LLVM_DEBUG(dbgs() << CurrentIdx << ": GICM_CheckOpcode(MIs[" << InsnID
+                        << "], ExpectedOpcode=" << Expected
+                        << ") // Got=" << Opcode << "\n");
+      if (Opcode != Expected) {
+        if (handleReject() == RejectAndGiveUp)
+          return false;
+      }
+      break;
+    }
+
+    case GICM_CheckNumOperands: {
+      int64_t InsnID = MatchTable[CurrentIdx++];
+      int64_t Expected = MatchTable[CurrentIdx++];
+      LLVM_DEBUG(dbgs() << CurrentIdx << ": GICM_CheckNumOperands(MIs["
+                        << InsnID << "], Expected=" << Expected << ")\n");
+      assert(State.MIs[InsnID] != nullptr && "Used insn before defined");
+      if (State.MIs[InsnID]->getNumOperands() != Expected) {
+        if (handleReject() == RejectAndGiveUp)
+          return false;
+      }
+      break;
+    }
+
+    case GICM_RecordDefInsn: {
+      int64_t NewInsnID = MatchTable[CurrentIdx++];
+      int64_t InsnID = MatchTable[CurrentIdx++];
+      int64_t OpIdx = MatchTable[CurrentIdx++];
+
+      // MIs[0] is always the root. Refuse any attempt to modify it.
+      assert(NewInsnID != 0 && "Refusing to modify MIs[0]");
+
+      MachineOperand &MO = State.MIs[InsnID]->getOperand(OpIdx);
+      MachineInstr *NewMI = nullptr;
+      if (MO.isReg() && TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+        NewMI = MRI.getVRegDef(MO.getReg());
+      // Patterns bind the register to the first operand of its definition.
+      if (NewMI && (!NewMI->getOperand(0).isReg() ||
+                    NewMI->getOperand(0).getReg() != MO.getReg()))
+        NewMI = nullptr;
+      if (!NewMI) {
+        LLVM_DEBUG(dbgs() << CurrentIdx << ": No unique vreg def\n");
+        if (handleReject() == RejectAndGiveUp)
+          return false;
+        break;
+      }
+      if ((size_t)NewInsnID < State.MIs.size())
+        State.MIs[NewInsnID] = NewMI;
+      else {
+        assert((size_t)NewInsnID == State.MIs.size() &&
+               "Expected to store MIs in order");
+        State.MIs.push_back(NewMI);
+      }
+      LLVM_DEBUG(dbgs() << CurrentIdx << ": MIs[" << NewInsnID
+                        << "] = GICM_RecordDefInsn(" << InsnID << ", " << OpIdx
+                        << ")\n");
+      break;
+    }
+
+    case GICM_CheckIsSameOperand: {
+      int64_t InsnID = MatchTable[CurrentIdx++];
+      int64_t OpIdx = MatchTable[CurrentIdx++];
+      int64_t OtherInsnID = MatchTable[CurrentIdx++];
+      int64_t OtherOpIdx = MatchTable[CurrentIdx++];
+      LLVM_DEBUG(dbgs() << CurrentIdx << ": GICM_CheckIsSameOperand(MIs["
+                        << InsnID << "][" << OpIdx << "], MIs[" << OtherInsnID
+                        << "][" << OtherOpIdx << "])\n");
+      assert(State.MIs[InsnID] != nullptr && "Used insn before defined");
+      assert(State.MIs[OtherInsnID] != nullptr && "Used insn before defined");
+      if (!State.MIs[InsnID]->getOperand(OpIdx).isIdenticalTo(
+              State.MIs[OtherInsnID]->getOperand(OtherOpIdx))) {
+        if (handleReject() == RejectAndGiveUp)
+          return false;
+      }
+      break;
+    }
+
+    case GICM_CheckPredicate: {
+      int64_t PredicateID = MatchTable[CurrentIdx++];
+      LLVM_DEBUG(dbgs() << CurrentIdx << ": GICM_CheckPredicate(Predicate="
+                        << PredicateID << ")\n");
+      if (!testPredicate(PredicateID, MI, State, MRI, Helper)) {
+        if (handleReject() == RejectAndGiveUp)
+          return false;
+      }
+      break;
+    }
+
+    case GICM_Apply: {
+      int64_t RuleID = MatchTable[CurrentIdx++];
+      int64_t ApplyID = MatchTable[CurrentIdx++];
+      if (isRuleDisabled(RuleID)) {
+        LLVM_DEBUG(dbgs() << CurrentIdx << ": Rule " << RuleID
+                          << " is disabled\n");
+        if (handleReject() == RejectAndGiveUp)
+          return false;
+        break;
+      }
+      LLVM_DEBUG(dbgs() << CurrentIdx << ": GICM_Apply(Rule=" << RuleID
+                        << ")\n");
+      runApply(ApplyID, MI, State, MRI, Helper);
+      CoverageInfo.setCovered(RuleID);
+      return true;
+    }
+
+    case GICM_Reject:
+      LLVM_DEBUG(dbgs() << CurrentIdx << ": GICM_Reject\n");
+      if (handleReject() == RejectAndGiveUp)
+        return false;
+      break;
+
+    default:
+      llvm_unreachable("Unexpected command");
+    }
+  }
+}
+
+void llvm::emitGICombinerCoverage(const CodeGenCoverage &CoverageInfo,
+                                  StringRef CombinerName) {
+  LLVM_DEBUG({
+    dbgs() << "Rules covered by " << CombinerName << ":";
+    for (auto RuleID : CoverageInfo.covered())
+      dbgs() << " id" << RuleID;
+    dbgs() << "\n";
+  });
+  CoverageInfo.emit(CoveragePrefix, CombinerName);
+}
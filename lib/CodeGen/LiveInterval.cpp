@@ -814,6 +814,20 @@ void LiveRange::flushSegmentSet() {
   verify();
 }
 
+/// Replace \p V by a copy, which only allocates what the elements need.
+template <typename VectorT> static void shrinkToFit(VectorT &V) {
+  if (V.capacity() == V.size())
+    return;
+  VectorT Compacted(V.begin(), V.end());
+  V.swap(Compacted);
+}
+
+void LiveRange::compact() {
+  assert(!segmentSet && "compact() requires the segment vector");
+  shrinkToFit(segments);
+  shrinkToFit(valnos);
+}
+
 bool LiveRange::isLiveAtIndexes(ArrayRef<SlotIndex> Slots) const {
   ArrayRef<SlotIndex>::iterator SlotI = Slots.begin();
   ArrayRef<SlotIndex>::iterator SlotE = Slots.end();
@@ -20,6 +20,7 @@
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveInterval.h"
@@ -58,6 +59,12 @@ using namespace llvm;
 
 #define DEBUG_TYPE "regalloc"
 
+STATISTIC(NumVirtRegIntervals, "Number of virtual register intervals computed");
+STATISTIC(NumIntervalBytes, "Bytes of segment and value number vectors in "
+                            "computed intervals");
+STATISTIC(NumCompactedBytes, "Bytes released by compacting computed intervals");
+STATISTIC(NumVNInfoBytes, "Bytes allocated for value numbers");
+
 char LiveIntervals::ID = 0;
 char &llvm::LiveIntervalsID = LiveIntervals::ID;
 INITIALIZE_PASS_BEGIN(LiveIntervals, "liveintervals",
@@ -76,6 +83,10 @@ static cl::opt<bool> EnablePrecomputePhysRegs(
 static bool EnablePrecomputePhysRegs = false;
 #endif // NDEBUG
 
+static cl::opt<bool> CompactIntervals(
+    "compact-live-intervals", cl::Hidden, cl::init(false),
+    cl::desc("Release the unused capacity of computed live intervals"));
+
 namespace llvm {
 
 cl::opt<bool> UseSegmentSetForPhysRegs(
@@ -141,6 +152,7 @@ bool LiveIntervals::runOnMachineFunction(MachineFunction &fn) {
   computeVirtRegs();
   computeRegMasks();
   computeLiveInRegUnits();
+  NumVNInfoBytes.addSaturating(VNInfoAllocator.getBytesAllocated());
 
   if (EnablePrecomputePhysRegs) {
     // For stress testing, precompute live ranges of all physical register
@@ -200,13 +212,47 @@ void LiveIntervals::computeVirtRegInterval(LiveInterval &LI) {
   computeDeadValues(LI, nullptr);
 }
 
+/// Returns the bytes allocated for the vectors of \p LI and its subranges.
+static size_t getAllocatedBytes(const LiveInterval &LI) {
+  size_t Bytes = LI.getAllocatedBytes();
+  for (const LiveInterval::SubRange &SR : LI.subranges())
+    Bytes += SR.getAllocatedBytes();
+  return Bytes;
+}
+
 void LiveIntervals::computeVirtRegs() {
+  size_t Bytes = 0, Released = 0;
+  unsigned NumIntervals = 0;
   for (unsigned i = 0, e = MRI->getNumVirtRegs(); i != e; ++i) {
     unsigned Reg = TargetRegisterInfo::index2VirtReg(i);
     if (MRI->reg_nodbg_empty(Reg))
       continue;
-    createAndComputeVirtRegInterval(Reg);
+    LiveInterval &LI = createAndComputeVirtRegInterval(Reg);
+    ++NumIntervals;
+    size_t IntervalBytes = getAllocatedBytes(LI);
+    if (CompactIntervals) {
+      // The intervals of huge functions stay allocated through register
+      // allocation, so give back what vector growth over-allocated.
+      LI.compact();
+      for (LiveInterval::SubRange &SR : LI.subranges())
+        SR.compact();
+      size_t CompactedBytes = getAllocatedBytes(LI);
+      Released += IntervalBytes - CompactedBytes;
+      IntervalBytes = CompactedBytes;
+    }
+    Bytes += IntervalBytes;
   }
+
+  NumVirtRegIntervals += NumIntervals;
+  NumIntervalBytes.addSaturating(Bytes);
+  NumCompactedBytes.addSaturating(Released);
+  LLVM_DEBUG({
+    if (NumIntervals)
+      dbgs() << "Computed " << NumIntervals << " intervals using " << Bytes
+             << " bytes, " << Bytes / NumIntervals
+             << " per interval. Compaction released " << Released
+             << " bytes.\n";
+  });
 }
 
 void LiveIntervals::computeRegMasks() {
@@ -59,6 +59,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/CodeLayout.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -182,6 +183,27 @@ static cl::opt<unsigned> TriangleChainCount(
     cl::init(2),
     cl::Hidden);
 
+// Use the Ext-TSP layout for profiled functions.
+static cl::opt<bool> EnableExtTspBlockPlacement(
+    "enable-ext-tsp-block-placement",
+    cl::desc("Reorder the blocks of profiled functions to maximize the "
+             "Ext-TSP score of the layout, which models fall-throughs and "
+             "short jumps."), cl::init(false),
+    cl::Hidden);
+
+static cl::opt<unsigned> ExtTspBlockPlacementMaxBlocks(
+    "ext-tsp-block-placement-max-blocks",
+    cl::desc("Maximum number of basic blocks in a function to use the "
+             "Ext-TSP layout for."), cl::init(1000),
+    cl::Hidden);
+
+static cl::opt<unsigned> ExtTspMinProfileCoverage(
+    "ext-tsp-min-profile-coverage",
+    cl::desc("Minimum percentage of the basic blocks of a function that the "
+             "profile shows to execute to use the Ext-TSP layout for it."),
+    cl::init(0),
+    cl::Hidden);
+
 extern cl::opt<unsigned> StaticLikelyProb;
 extern cl::opt<unsigned> ProfileLikelyProb;
 
@@ -467,6 +489,13 @@ class MachineBlockPlacement : public MachineFunctionPass {
   void buildCFGChains();
   void optimizeBranches();
   void alignBlocks();
+  /// Returns true if the Ext-TSP layout should be tried for the function.
+  bool shouldApplyExtTsp() const;
+  /// Reorder the blocks to improve the Ext-TSP score of the layout. Returns
+  /// true if the layout changed.
+  bool applyExtTsp();
+  /// Replace the chains by a single chain holding the blocks in layout order.
+  void createCFGChainExtTsp();
   /// Returns true if a block should be tail-duplicated to increase fallthrough
   /// opportunities.
   bool shouldTailDuplicate(MachineBasicBlock *BB);
@@ -2457,6 +2486,121 @@ void MachineBlockPlacement::buildCFGChains() {
   EHPadWorkList.clear();
 }
 
+bool MachineBlockPlacement::shouldApplyExtTsp() const {
+  if (F->size() < 3 || F->size() > ExtTspBlockPlacementMaxBlocks)
+    return false;
+  const Function &Fn = F->getFunction();
+  if (!Fn.hasProfileData() || Fn.optForSize())
+    return false;
+  // The wrapper knows the frequencies of the blocks that tail merging
+  // created; the analysis converts them to counts.
+  auto &MBFIInfo = getAnalysis<MachineBlockFrequencyInfo>();
+  auto GetCount = [&](const MachineBasicBlock *MBB) -> uint64_t {
+    uint64_t Freq = MBFI->getBlockFreq(MBB).getFrequency();
+    Optional<uint64_t> Count = MBFIInfo.getProfileCountFromFreq(Freq);
+    return Count ? *Count : 0;
+  };
+  if (!GetCount(&F->front()))
+    return false;
+  if (!ExtTspMinProfileCoverage)
+    return true;
+
+  unsigned NumExecuted = 0;
+  for (const MachineBasicBlock &MBB : *F)
+    if (GetCount(&MBB))
+      ++NumExecuted;
+  return NumExecuted * 100 >= ExtTspMinProfileCoverage * F->size();
+}
+
+bool MachineBlockPlacement::applyExtTsp() {
+  // Number the blocks by their position in the chain-based layout.
+  DenseMap<const MachineBasicBlock *, unsigned> BlockIndex;
+  std::vector<MachineBasicBlock *> Blocks;
+  Blocks.reserve(F->size());
+  for (MachineBasicBlock &MBB : *F) {
+    BlockIndex[&MBB] = Blocks.size();
+    Blocks.push_back(&MBB);
+  }
+
+  std::vector<uint64_t> BlockSizes(Blocks.size());
+  std::vector<uint64_t> BlockCounts(Blocks.size());
+  std::vector<ExtTspEdge> JumpCounts;
+  std::vector<std::pair<unsigned, unsigned>> ForcedPairs;
+  SmallVector<MachineOperand, 4> Cond; // For AnalyzeBranch.
+  for (unsigned Index = 0, E = Blocks.size(); Index != E; ++Index) {
+    MachineBasicBlock *MBB = Blocks[Index];
+    BlockFrequency BlockFreq = MBFI->getBlockFreq(MBB);
+    BlockCounts[Index] = BlockFreq.getFrequency();
+
+    // The exact sizes are only known after branch relaxation; assume that an
+    // instruction takes 4 bytes.
+    unsigned NumInsts = 0;
+    for (const MachineInstr &MI : *MBB)
+      if (!MI.isMetaInstruction())
+        ++NumInsts;
+    BlockSizes[Index] = 4 * NumInsts;
+
+    for (MachineBasicBlock *Succ : MBB->successors()) {
+      BlockFrequency JumpFreq =
+          BlockFreq * MBPI->getEdgeProbability(MBB, Succ);
+      JumpCounts.push_back({Index, BlockIndex[Succ], JumpFreq.getFrequency()});
+    }
+
+    // A block that falls through without analyzable branches has to stay in
+    // front of its layout successor.
+    Cond.clear();
+    MachineBasicBlock *TBB = nullptr, *FBB = nullptr; // For AnalyzeBranch.
+    if (MBB->canFallThrough() && TII->analyzeBranch(*MBB, TBB, FBB, Cond))
+      ForcedPairs.push_back({Index, Index + 1});
+  }
+
+  std::vector<unsigned> CurrentOrder(Blocks.size());
+  for (unsigned Index = 0, E = Blocks.size(); Index != E; ++Index)
+    CurrentOrder[Index] = Index;
+  std::vector<unsigned> NewOrder =
+      applyExtTspLayout(BlockSizes, BlockCounts, JumpCounts, ForcedPairs);
+  double CurrentScore = calcExtTspScore(CurrentOrder, BlockSizes, JumpCounts);
+  double NewScore = calcExtTspScore(NewOrder, BlockSizes, JumpCounts);
+  LLVM_DEBUG(dbgs() << "[MBP] Ext-TSP layout of " << F->getName() << " ("
+                    << Blocks.size() << " blocks): score " << CurrentScore
+                    << " -> " << NewScore << "\n");
+  // Keep the chain-based layout unless the new one is better by the same
+  // measure.
+  if (NewScore <= CurrentScore || NewOrder == CurrentOrder)
+    return false;
+
+  MachineFunction::iterator InsertPos = F->begin();
+  for (unsigned Index : NewOrder) {
+    MachineBasicBlock *MBB = Blocks[Index];
+    if (InsertPos != MachineFunction::iterator(MBB))
+      F->splice(InsertPos, MBB);
+    else
+      ++InsertPos;
+  }
+
+  // Update the terminators now that the layout successors have changed.
+  for (MachineBasicBlock &MBB : *F) {
+    Cond.clear();
+    MachineBasicBlock *TBB = nullptr, *FBB = nullptr; // For AnalyzeBranch.
+    if (!TII->analyzeBranch(MBB, TBB, FBB, Cond))
+      MBB.updateTerminator();
+  }
+  return true;
+}
+
+void MachineBlockPlacement::createCFGChainExtTsp() {
+  BlockToChain.clear();
+  ComputedEdges.clear();
+  ChainAllocator.DestroyAll();
+
+  MachineBasicBlock *HeadBB = &F->front();
+  BlockChain *FunctionChain =
+      new (ChainAllocator.Allocate()) BlockChain(BlockToChain, HeadBB);
+  for (MachineBasicBlock &MBB : *F)
+    if (&MBB != HeadBB)
+      FunctionChain->merge(&MBB, nullptr);
+}
+
 void MachineBlockPlacement::optimizeBranches() {
   BlockChain &FunctionChain = *BlockToChain[&F->front()];
   SmallVector<MachineOperand, 4> Cond; // For AnalyzeBranch.
@@ -2807,6 +2951,9 @@ bool MachineBlockPlacement::runOnMachineFunction(MachineFunction &MF) {
     }
   }
 
+  if (EnableExtTspBlockPlacement && shouldApplyExtTsp() && applyExtTsp())
+    createCFGChainExtTsp();
+
   optimizeBranches();
   alignBlocks();
 
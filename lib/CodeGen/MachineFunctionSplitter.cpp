@@ -0,0 +1,224 @@
+//===- MachineFunctionSplitter.cpp - Split out cold blocks ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass moves the blocks that the profile shows to be (nearly) never
+// executed to the end of the function and marks them as its cold fragment.
+// AsmPrinter emits the cold fragment in a section of its own, next to the
+// functions that are cold as a whole, so that the hot code of the function
+// occupies fewer cache lines and pages.
+//
+// The pass runs after block placement and the other passes that change the
+// layout. It only changes the terminators needed to keep the control flow of
+// the moved blocks and their former layout neighbours intact.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/EHPersonalities.h"
+#include "llvm/CodeGen/MachineBasicBlock.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineJumpTableInfo.h"
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/CodeGen/TargetInstrInfo.h"
+#include "llvm/CodeGen/TargetSubtargetInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Target/TargetMachine.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "machine-function-splitter"
+
+STATISTIC(NumFunctionsSplit, "Number of functions split");
+STATISTIC(NumColdBlocks, "Number of blocks moved to a cold fragment");
+
+static cl::opt<unsigned> ColdCountThreshold(
+    "mfs-count-threshold", cl::init(1), cl::Hidden,
+    cl::desc("Move the blocks whose profile count is below this threshold "
+             "to the cold fragment of their function"));
+
+namespace {
+
+class MachineFunctionSplitter : public MachineFunctionPass {
+public:
+  static char ID;
+
+  MachineFunctionSplitter() : MachineFunctionPass(ID) {
+    initializeMachineFunctionSplitterPass(*PassRegistry::getPassRegistry());
+  }
+
+  StringRef getPassName() const override {
+    return "Machine Function Splitter";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<MachineBlockFrequencyInfo>();
+    AU.setPreservesCFG();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+};
+
+} // end anonymous namespace
+
+char MachineFunctionSplitter::ID = 0;
+
+INITIALIZE_PASS_BEGIN(MachineFunctionSplitter, DEBUG_TYPE,
+                      "Split machine functions using profile information",
+                      false, false)
+INITIALIZE_PASS_DEPENDENCY(MachineBlockFrequencyInfo)
+INITIALIZE_PASS_END(MachineFunctionSplitter, DEBUG_TYPE,
+                    "Split machine functions using profile information",
+                    false, false)
+
+/// Return true if AsmPrinter can emit a cold fragment for \p MF.
+static bool canSplit(const MachineFunction &MF) {
+  // The fragment gets a frame of its own in .eh_frame, which requires ELF.
+  // Other targets emit unwind information that is not split into fragments.
+  const Triple &TT = MF.getTarget().getTargetTriple();
+  if (!TT.isOSBinFormatELF() ||
+      (TT.getArch() != Triple::x86 && TT.getArch() != Triple::x86_64))
+    return false;
+
+  // The frame of the fragment has neither personality nor LSDA. The blocks
+  // with invokes stay in the hot part, and without them the personalities
+  // of DWARF EH do nothing for the fragment anyway.
+  const Function &F = MF.getFunction();
+  if (F.hasPersonalityFn()) {
+    EHPersonality Per = classifyEHPersonality(F.getPersonalityFn());
+    if (isScopedEHPersonality(Per) || !isNoOpWithoutInvoke(Per) ||
+        MF.getTarget().getMCAsmInfo()->getExceptionHandlingType() !=
+            ExceptionHandling::DwarfCFI)
+      return false;
+  }
+
+  // Respect an explicitly requested section.
+  return !F.hasSection();
+}
+
+/// Return true if \p MBB holds a label of the call-site table, which
+/// describes the hot part of the function only.
+static bool hasEHLabel(const MachineBasicBlock &MBB) {
+  return any_of(MBB, [](const MachineInstr &MI) { return MI.isEHLabel(); });
+}
+
+/// Return true if the branches of \p MBB can be rewritten.
+static bool isAnalyzable(const TargetInstrInfo &TII, MachineBasicBlock &MBB) {
+  MachineBasicBlock *TBB = nullptr, *FBB = nullptr;
+  SmallVector<MachineOperand, 4> Cond;
+  return !TII.analyzeBranch(MBB, TBB, FBB, Cond);
+}
+
+/// Make the fall-through of \p MBB into the next block an explicit branch.
+static void makeFallThroughExplicit(const TargetInstrInfo &TII,
+                                    MachineBasicBlock &MBB) {
+  if (!MBB.canFallThrough())
+    return;
+  MachineBasicBlock *Next = &*std::next(MBB.getIterator());
+
+  MachineBasicBlock *TBB = nullptr, *FBB = nullptr;
+  SmallVector<MachineOperand, 4> Cond;
+  bool Unanalyzable = TII.analyzeBranch(MBB, TBB, FBB, Cond);
+  assert(!Unanalyzable && "Fall-through out of an unanalyzable block");
+  (void)Unanalyzable;
+
+  DebugLoc DL = MBB.findBranchDebugLoc();
+  if (!TBB) {
+    TII.insertBranch(MBB, Next, nullptr, Cond, DL);
+  } else {
+    assert(!Cond.empty() && !FBB && "Block does not fall through");
+    TII.removeBranch(MBB);
+    TII.insertBranch(MBB, TBB, Next, Cond, DL);
+  }
+}
+
+bool MachineFunctionSplitter::runOnMachineFunction(MachineFunction &MF) {
+  if (skipFunction(MF.getFunction()) || !MF.getFunction().hasProfileData() ||
+      !canSplit(MF))
+    return false;
+
+  const TargetInstrInfo &TII = *MF.getSubtarget().getInstrInfo();
+  auto &MBFI = getAnalysis<MachineBlockFrequencyInfo>();
+
+  // Jump table entries may be emitted as differences between the block and
+  // a label next to the table, which must not span sections.
+  SmallPtrSet<const MachineBasicBlock *, 16> JumpTableTargets;
+  if (const MachineJumpTableInfo *JTI = MF.getJumpTableInfo())
+    for (const MachineJumpTableEntry &JTE : JTI->getJumpTables())
+      JumpTableTargets.insert(JTE.MBBs.begin(), JTE.MBBs.end());
+
+  SmallVector<MachineBasicBlock *, 16> ColdBlocks;
+  MachineBasicBlock *Prev = nullptr;
+  for (MachineBasicBlock &MBB : MF) {
+    MachineBasicBlock *LayoutPred = Prev;
+    Prev = &MBB;
+    // The entry block has to stay at the function symbol.
+    if (!LayoutPred)
+      continue;
+
+    Optional<uint64_t> Count = MBFI.getBlockProfileCount(&MBB);
+    if (!Count || *Count >= ColdCountThreshold)
+      continue;
+    if (MBB.isEHPad() || MBB.hasAddressTaken() ||
+        JumpTableTargets.count(&MBB) || hasEHLabel(MBB))
+      continue;
+
+    // Moving the block changes its own layout successor and the one of its
+    // layout predecessor; both need new branches if they fall through.
+    if (MBB.canFallThrough() && !isAnalyzable(TII, MBB))
+      continue;
+    if (LayoutPred->canFallThrough() && !isAnalyzable(TII, *LayoutPred))
+      continue;
+
+    ColdBlocks.push_back(&MBB);
+  }
+  if (ColdBlocks.empty())
+    return false;
+
+  LLVM_DEBUG(dbgs() << "Moving " << ColdBlocks.size()
+                    << " blocks to the cold fragment of " << MF.getName()
+                    << "\n");
+
+  // Remember which blocks may fall through before the layout changes; the
+  // branches are analyzable for all of the blocks whose successor changes.
+  SmallVector<MachineBasicBlock *, 16> FallThroughs;
+  for (MachineBasicBlock &MBB : MF)
+    if (MBB.canFallThrough())
+      FallThroughs.push_back(&MBB);
+
+  for (MachineBasicBlock *MBB : ColdBlocks) {
+    MF.splice(MF.end(), MBB);
+    MBB->setIsInColdFragment();
+  }
+  for (MachineBasicBlock *MBB : FallThroughs)
+    if (isAnalyzable(TII, *MBB))
+      MBB->updateTerminator();
+
+  // Control cannot fall from the hot part into the cold fragment.
+  makeFallThroughExplicit(TII, *std::prev(ColdBlocks.front()->getIterator()));
+
+  ++NumFunctionsSplit;
+  NumColdBlocks += ColdBlocks.size();
+  return true;
+}
+
+MachineFunctionPass *llvm::createMachineFunctionSplitterPass() {
+  return new MachineFunctionSplitter();
+}
@@ -260,12 +260,16 @@ void MachineModuleInfo::addPersonality(const Function *Personality) {
 
 MachineFunction *
 MachineModuleInfo::getMachineFunction(const Function &F) const {
+  std::lock_guard<std::mutex> Lock(MachineFunctionsMutex);
   auto I = MachineFunctions.find(&F);
   return I != MachineFunctions.end() ? I->second.get() : nullptr;
 }
 
 MachineFunction &
 MachineModuleInfo::getOrCreateMachineFunction(const Function &F) {
+  // Function passes may look their MachineFunction up from several threads.
+  std::lock_guard<std::mutex> Lock(MachineFunctionsMutex);
+
   // Shortcut for the common case where a sequence of MachineFunctionPasses
   // all query for the same Function.
   if (LastRequest == &F)
@@ -290,6 +294,7 @@ MachineModuleInfo::getOrCreateMachineFunction(const Function &F) {
 }
 
 void MachineModuleInfo::deleteMachineFunctionFor(Function &F) {
+  std::lock_guard<std::mutex> Lock(MachineFunctionsMutex);
   MachineFunctions.erase(&F);
   LastRequest = nullptr;
   LastResult = nullptr;
@@ -328,6 +333,51 @@ FunctionPass *llvm::createFreeMachineFunctionPass() {
   return new FreeMachineFunction();
 }
 
+namespace {
+
+/// This pass separates the function passes before it from the ones after it.
+/// Creating the MachineFunctions up front numbers them in module order, so
+/// the labels derived from the function numbers do not depend on the order
+/// in which the passes before the next barrier visit the functions.
+class MachineFunctionBarrier : public ModulePass {
+  bool CreateFunctions;
+
+public:
+  static char ID;
+
+  MachineFunctionBarrier(bool CreateFunctions = false)
+      : ModulePass(ID), CreateFunctions(CreateFunctions) {}
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<MachineModuleInfo>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnModule(Module &M) override {
+    if (!CreateFunctions)
+      return false;
+    // This also looks up the subtarget of each function, which the target
+    // caches, before the functions are processed concurrently.
+    MachineModuleInfo &MMI = getAnalysis<MachineModuleInfo>();
+    for (const Function &F : M)
+      if (!F.isDeclaration())
+        MMI.getOrCreateMachineFunction(F);
+    return false;
+  }
+
+  StringRef getPassName() const override {
+    return "Machine Function Barrier";
+  }
+};
+
+} // end anonymous namespace
+
+char MachineFunctionBarrier::ID;
+
+ModulePass *llvm::createMachineFunctionBarrierPass(bool CreateFunctions) {
+  return new MachineFunctionBarrier(CreateFunctions);
+}
+
 //===- MMI building helpers -----------------------------------------------===//
 
 void llvm::computeUsesVAFloatArgument(const CallInst &I,
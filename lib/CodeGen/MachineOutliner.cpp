@@ -58,6 +58,7 @@
 #include "llvm/CodeGen/MachineOutliner.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/Triple.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineModuleInfo.h"
@@ -72,6 +73,8 @@
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
 #include <functional>
 #include <map>
@@ -87,6 +90,8 @@ using namespace outliner;
 
 STATISTIC(NumOutlined, "Number of candidates outlined");
 STATISTIC(FunctionsCreated, "Number of functions created");
+STATISTIC(SharedFunctionsCreated,
+          "Number of functions created that the linker can deduplicate");
 
 // Set to true if the user wants the outliner to run on linkonceodr linkage
 // functions. This is false by default because the linker can dedupe linkonceodr
@@ -99,6 +104,17 @@ static cl::opt<bool> EnableLinkOnceODROutlining(
     cl::desc("Enable the machine outliner on linkonceodr functions"),
     cl::init(false));
 
+// Set to true to emit the outlined functions as linkonce_odr functions that
+// are named by a hash of their contents. The linker then keeps one copy of
+// the functions that separately compiled modules, such as the ThinLTO
+// backends, outline from the same instruction sequence.
+static cl::opt<bool> EnableSharedOutlinedFunctions(
+    "enable-shared-outlined-functions",
+    cl::Hidden,
+    cl::desc("Name outlined functions by their contents and give them "
+             "linkonce_odr linkage so that the linker can deduplicate them"),
+    cl::init(false));
+
 namespace {
 
 /// Represents an undefined index in the suffix tree.
@@ -1111,15 +1127,104 @@ unsigned MachineOutliner::buildCandidateList(
   return MaxCandidateLen;
 }
 
+/// Compute a hash of the function that outlines \p OF which is the same in
+/// every module that outlines the same instructions. Returns false if the
+/// instructions refer to something that is local to the module, such as a
+/// global with local linkage, a constant pool entry or a basic block.
+static bool getSharedFunctionHash(const Module &M, const OutlinedFunction &OF,
+                                  InstructionMapper &Mapper,
+                                  MD5::MD5Result &Result) {
+  MD5 Hash;
+  auto AddInt = [&Hash](uint64_t V) {
+    uint8_t Bytes[8];
+    support::endian::write64le(Bytes, V);
+    Hash.update(Bytes);
+  };
+  auto AddString = [&](StringRef Str) {
+    AddInt(Str.size());
+    Hash.update(Str);
+  };
+
+  AddString(M.getTargetTriple());
+  AddInt(OF.TCI.FrameConstructionID);
+  AddInt(OF.Sequence.size());
+  for (unsigned Str : OF.Sequence) {
+    const MachineInstr &MI = *Mapper.IntegerInstructionMap.find(Str)->second;
+    AddInt(MI.getOpcode());
+    AddInt(MI.getFlags());
+    AddInt(MI.getNumOperands());
+    for (const MachineOperand &MO : MI.operands()) {
+      AddInt(MO.getType());
+      AddInt(MO.getTargetFlags());
+      switch (MO.getType()) {
+      case MachineOperand::MO_Register:
+        AddInt(MO.getReg());
+        AddInt(MO.getSubReg());
+        AddInt(MO.isDef() | MO.isImplicit() << 1 | MO.isUndef() << 2);
+        break;
+      case MachineOperand::MO_Immediate:
+        AddInt(MO.getImm());
+        break;
+      case MachineOperand::MO_FPImmediate: {
+        APInt Bits = MO.getFPImm()->getValueAPF().bitcastToAPInt();
+        AddInt(Bits.getBitWidth());
+        for (unsigned I = 0, E = Bits.getNumWords(); I != E; ++I)
+          AddInt(Bits.getRawData()[I]);
+        break;
+      }
+      case MachineOperand::MO_GlobalAddress: {
+        const GlobalValue *GV = MO.getGlobal();
+        if (GV->hasLocalLinkage() || !GV->hasName())
+          return false;
+        AddString(GV->getName());
+        AddInt(MO.getOffset());
+        break;
+      }
+      case MachineOperand::MO_ExternalSymbol:
+        AddString(MO.getSymbolName());
+        AddInt(MO.getOffset());
+        break;
+      case MachineOperand::MO_MCSymbol:
+        if (MO.getMCSymbol()->isTemporary())
+          return false;
+        AddString(MO.getMCSymbol()->getName());
+        break;
+      case MachineOperand::MO_RegisterMask: {
+        const TargetRegisterInfo &TRI =
+            *MI.getMF()->getSubtarget().getRegisterInfo();
+        for (unsigned I = 0, E = (TRI.getNumRegs() + 31) / 32; I != E; ++I)
+          AddInt(MO.getRegMask()[I]);
+        break;
+      }
+      default:
+        return false;
+      }
+    }
+  }
+  Hash.final(Result);
+  return true;
+}
+
 MachineFunction *
 MachineOutliner::createOutlinedFunction(Module &M, const OutlinedFunction &OF,
                                         InstructionMapper &Mapper) {
 
   // Create the function name. This should be unique. For now, just hash the
   // module name and include it in the function name plus the number of this
-  // function.
+  // function. Shared functions are named by their contents instead, which
+  // makes them identical in all modules that create them.
   std::ostringstream NameStream;
-  NameStream << "OUTLINED_FUNCTION_" << OF.Name;
+  bool Shared = false;
+  MD5::MD5Result Hash;
+  if (EnableSharedOutlinedFunctions &&
+      getSharedFunctionHash(M, OF, Mapper, Hash)) {
+    NameStream << "OUTLINED_FUNCTION_" << Hash.digest().str().str();
+    Shared = !M.getNamedValue(NameStream.str());
+  }
+  if (!Shared) {
+    NameStream.str("");
+    NameStream << "OUTLINED_FUNCTION_" << OF.Name;
+  }
 
   // Create the function using an IR-level function.
   LLVMContext &C = M.getContext();
@@ -1131,6 +1236,14 @@ MachineOutliner::createOutlinedFunction(Module &M, const OutlinedFunction &OF,
   // which gives us better results when we outline from linkonceodr functions.
   F->setLinkage(GlobalValue::InternalLinkage);
   F->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+  if (Shared) {
+    // Only the linker sees the copies of the other modules.
+    F->setLinkage(GlobalValue::LinkOnceODRLinkage);
+    F->setVisibility(GlobalValue::HiddenVisibility);
+    if (Triple(M.getTargetTriple()).supportsCOMDAT())
+      F->setComdat(M.getOrInsertComdat(F->getName()));
+    ++SharedFunctionsCreated;
+  }
 
   // FIXME: Set nounwind, so we don't generate eh_frame? Haven't verified it's
   // necessary.
@@ -50,7 +50,9 @@
 // nodes. We also perform several passes over the DAG to eliminate unnecessary
 // edges that inhibit the ability to pipeline. The implementation uses the
 // DFAPacketizer class to compute the minimum initiation interval and the check
-// where an instruction may be inserted in the pipelined schedule.
+// where an instruction may be inserted in the pipelined schedule. Targets
+// without a DFA use the processor resources of their machine scheduling model
+// instead.
 //
 // In order for the SMS pass to work, several target specific hooks need to be
 // implemented to get information about the loop structure and to rewrite
@@ -83,6 +85,7 @@
 #include "llvm/CodeGen/MachineLoopInfo.h"
 #include "llvm/CodeGen/MachineMemOperand.h"
 #include "llvm/CodeGen/MachineOperand.h"
+#include "llvm/CodeGen/MachineOptimizationRemarkEmitter.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
 #include "llvm/CodeGen/RegisterClassInfo.h"
 #include "llvm/CodeGen/RegisterPressure.h"
@@ -92,6 +95,7 @@
 #include "llvm/CodeGen/TargetInstrInfo.h"
 #include "llvm/CodeGen/TargetOpcodes.h"
 #include "llvm/CodeGen/TargetRegisterInfo.h"
+#include "llvm/CodeGen/TargetSchedule.h"
 #include "llvm/CodeGen/TargetSubtargetInfo.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/IR/Attributes.h"
@@ -101,6 +105,7 @@
 #include "llvm/MC/MCInstrDesc.h"
 #include "llvm/MC/MCInstrItineraries.h"
 #include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSchedule.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
@@ -127,6 +132,8 @@ using namespace llvm;
 STATISTIC(NumTrytoPipeline, "Number of loops that we attempt to pipeline");
 STATISTIC(NumPipelined, "Number of loops software pipelined");
 STATISTIC(NumNodeOrderIssues, "Number of node order issues found");
+STATISTIC(NumFailRegPressure,
+          "Number of schedules rejected due to register pressure");
 
 /// A command line option to turn software pipelining on or off.
 static cl::opt<bool> EnableSWP("enable-pipeliner", cl::Hidden, cl::init(true),
@@ -171,11 +178,43 @@ static cl::opt<bool> SwpIgnoreRecMII("pipeliner-ignore-recmii",
                                      cl::ReallyHidden, cl::init(false),
                                      cl::ZeroOrMore, cl::desc("Ignore RecMII"));
 
+/// A command line option to disable the register pressure check of the final
+/// schedule, on targets that enable the kernel checks.
+static cl::opt<bool>
+    SwpRegPressure("pipeliner-register-pressure", cl::Hidden, cl::init(true),
+                   cl::desc("Reject schedules whose kernel needs more "
+                            "registers than the target provides."));
+
 namespace {
 
 class NodeSet;
 class SMSchedule;
 
+/// Keep track of the resources used by the instructions in one cycle of the
+/// schedule. Targets that provide a DFA packetizer use it to model their
+/// functional units. For the other targets, each instruction occupies one
+/// unit of the processor resources it uses in its machine scheduling model,
+/// and at most IssueWidth micro-ops issue in a cycle.
+class ResourceManager {
+  TargetSchedModel SchedModel;
+  std::unique_ptr<DFAPacketizer> DFAResources;
+  /// The number of units in use, indexed by processor resource.
+  SmallVector<unsigned, 16> ProcResourceCount;
+  /// The number of micro-ops issued.
+  unsigned NumMicroOps = 0;
+
+public:
+  ResourceManager(const TargetSubtargetInfo &ST)
+      : DFAResources(ST.getInstrInfo()->CreateTargetScheduleState(ST)) {
+    SchedModel.init(&ST);
+    ProcResourceCount.resize(SchedModel.getNumProcResourceKinds());
+  }
+
+  bool canReserveResources(MachineInstr &MI) const;
+  void reserveResources(MachineInstr &MI);
+  void clearResources();
+};
+
 /// The main class in the implementation of the target independent
 /// software pipeliner pass.
 class MachinePipeliner : public MachineFunctionPass {
@@ -185,6 +224,7 @@ public:
   const MachineDominatorTree *MDT = nullptr;
   const InstrItineraryData *InstrItins;
   const TargetInstrInfo *TII = nullptr;
+  MachineOptimizationRemarkEmitter *ORE = nullptr;
   RegisterClassInfo RegClassInfo;
 
 #ifndef NDEBUG
@@ -215,6 +255,7 @@ public:
     AU.addRequired<MachineLoopInfo>();
     AU.addRequired<MachineDominatorTree>();
     AU.addRequired<LiveIntervals>();
+    AU.addRequired<MachineOptimizationRemarkEmitterPass>();
     MachineFunctionPass::getAnalysisUsage(AU);
   }
 
@@ -387,6 +428,7 @@ private:
   void updatePhiDependences();
   void changeDependences();
   unsigned calculateResMII();
+  unsigned calculateResMIIFromSchedModel();
   unsigned calculateRecMII(NodeSetType &RecNodeSets);
   void findCircuits(NodeSetType &NodeSets);
   void fuseRecs(NodeSetType &NodeSets);
@@ -401,6 +443,11 @@ private:
   void computeNodeOrder(NodeSetType &NodeSets);
   void checkValidNodeOrder(const NodeSetType &Circuits) const;
   bool schedulePipeline(SMSchedule &Schedule);
+  void sinkLoopCompare(SMSchedule &Schedule);
+  bool keepsLoopCompareLast(SMSchedule &Schedule);
+  bool exceedsRegisterPressure(SMSchedule &Schedule);
+  void emitMissedRemark(StringRef Name, const Twine &Msg, unsigned ResMII,
+                        unsigned RecMII);
   void generatePipelinedLoop(SMSchedule &Schedule);
   void generateProlog(SMSchedule &Schedule, unsigned LastStage,
                       MachineBasicBlock *KernelBB, ValueMapTy *VRMap,
@@ -608,12 +655,11 @@ private:
   /// Virtual register information.
   MachineRegisterInfo &MRI;
 
-  std::unique_ptr<DFAPacketizer> Resources;
+  ResourceManager Resources;
 
 public:
   SMSchedule(MachineFunction *mf)
-      : ST(mf->getSubtarget()), MRI(mf->getRegInfo()),
-        Resources(ST.getInstrInfo()->CreateTargetScheduleState(ST)) {}
+      : ST(mf->getSubtarget()), MRI(mf->getRegInfo()), Resources(ST) {}
 
   void reset() {
     ScheduledInstrs.clear();
@@ -627,6 +673,9 @@ public:
   /// Set the initiation interval for this schedule.
   void setInitiationInterval(int ii) { InitiationInterval = ii; }
 
+  /// Return the initiation interval (II) of the schedule.
+  int getInitiationInterval() const { return InitiationInterval; }
+
   /// Return the first cycle in the completed schedule.  This
   /// can be a negative value.
   int getFirstCycle() const { return FirstCycle; }
@@ -707,6 +756,7 @@ public:
 
   bool isValidSchedule(SwingSchedulerDAG *SSD);
   void finalizeSchedule(SwingSchedulerDAG *SSD);
+  void moveToFinalCycle(SUnit *SU);
   void orderDependence(SwingSchedulerDAG *SSD, SUnit *SU,
                        std::deque<SUnit *> &Insts);
   bool isLoopCarried(SwingSchedulerDAG *SSD, MachineInstr &Phi);
@@ -731,6 +781,7 @@ INITIALIZE_PASS_DEPENDENCY(AAResultsWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(MachineLoopInfo)
 INITIALIZE_PASS_DEPENDENCY(MachineDominatorTree)
 INITIALIZE_PASS_DEPENDENCY(LiveIntervals)
+INITIALIZE_PASS_DEPENDENCY(MachineOptimizationRemarkEmitterPass)
 INITIALIZE_PASS_END(MachinePipeliner, DEBUG_TYPE,
                     "Modulo Software Pipelining", false, false)
 
@@ -747,9 +798,23 @@ bool MachinePipeliner::runOnMachineFunction(MachineFunction &mf) {
       !EnableSWPOptSize.getPosition())
     return false;
 
+  if (!mf.getSubtarget().enableMachinePipeliner())
+    return false;
+
+  // The schedule is built from the target's model of its resources, either a
+  // DFA packetizer or the processor resources of the machine model.
+  const TargetSubtargetInfo &ST = mf.getSubtarget();
+  TargetSchedModel SchedModel;
+  SchedModel.init(&ST);
+  if (!SchedModel.hasInstrSchedModel() &&
+      !std::unique_ptr<DFAPacketizer>(
+          ST.getInstrInfo()->CreateTargetScheduleState(ST)))
+    return false;
+
   MF = &mf;
   MLI = &getAnalysis<MachineLoopInfo>();
   MDT = &getAnalysis<MachineDominatorTree>();
+  ORE = &getAnalysis<MachineOptimizationRemarkEmitterPass>().getORE();
   TII = MF->getSubtarget().getInstrInfo();
   RegClassInfo.runOnMachineFunction(*MF);
 
@@ -792,8 +857,17 @@ bool MachinePipeliner::scheduleLoop(MachineLoop &L) {
 /// restricted to loops with a single basic block.  Make sure that the
 /// branch in the loop can be analyzed.
 bool MachinePipeliner::canPipelineLoop(MachineLoop &L) {
-  if (L.getNumBlocks() != 1)
+  auto missed = [&](StringRef Name, StringRef Msg) {
+    ORE->emit([&]() {
+      return MachineOptimizationRemarkMissed(DEBUG_TYPE, Name, L.getStartLoc(),
+                                             L.getHeader())
+             << "loop not pipelined: " << Msg;
+    });
     return false;
+  };
+
+  if (L.getNumBlocks() != 1)
+    return missed("NotSingleBlock", "the loop has more than one block");
 
   // Check if the branch can't be understood because we can't do pipelining
   // if that's the case.
@@ -801,15 +875,16 @@ bool MachinePipeliner::canPipelineLoop(MachineLoop &L) {
   LI.FBB = nullptr;
   LI.BrCond.clear();
   if (TII->analyzeBranch(*L.getHeader(), LI.TBB, LI.FBB, LI.BrCond))
-    return false;
+    return missed("UnknownBranch", "the loop branch cannot be analyzed");
 
   LI.LoopInductionVar = nullptr;
   LI.LoopCompare = nullptr;
   if (TII->analyzeLoop(L, LI.LoopInductionVar, LI.LoopCompare))
-    return false;
+    return missed("UnknownLoop",
+                  "the loop control cannot be analyzed by the target");
 
   if (!L.getLoopPreheader())
-    return false;
+    return missed("NoPreheader", "the loop has no preheader");
 
   // Remove any subregisters from inputs to phi nodes.
   preprocessPhiNodes(*L.getHeader());
@@ -914,8 +989,11 @@ void SwingSchedulerDAG::schedule() {
     return;
 
   // Don't pipeline large loops.
-  if (SwpMaxMii != -1 && (int)MII > SwpMaxMii)
+  if (SwpMaxMii != -1 && (int)MII > SwpMaxMii) {
+    emitMissedRemark("MIITooLarge", "the MII exceeds the limit", ResMII,
+                     RecMII);
     return;
+  }
 
   computeNodeFunctions(NodeSets);
 
@@ -953,8 +1031,16 @@ void SwingSchedulerDAG::schedule() {
   SMSchedule Schedule(Pass.MF);
   Scheduled = schedulePipeline(Schedule);
 
-  if (!Scheduled)
+  if (!Scheduled) {
+    // A schedule that fits in one stage keeps its initiation interval, but
+    // does not overlap iterations and gains nothing.
+    if (Schedule.getInitiationInterval())
+      emitMissedRemark("NoOverlap", "the schedule does not overlap iterations",
+                       ResMII, RecMII);
+    else
+      emitMissedRemark("NoSchedule", "no schedule found", ResMII, RecMII);
     return;
+  }
 
   unsigned numStages = Schedule.getMaxStageCount();
   // No need to generate pipeline if there are no overlapped iterations.
@@ -965,10 +1051,176 @@ void SwingSchedulerDAG::schedule() {
   if (SwpMaxStages > -1 && (int)numStages > SwpMaxStages)
     return;
 
+  if (MF.getSubtarget().enablePipelinerKernelChecks()) {
+    sinkLoopCompare(Schedule);
+    if (!keepsLoopCompareLast(Schedule)) {
+      Scheduled = false;
+      emitMissedRemark("LoopCompareMoved",
+                       "the loop compare is not last in the kernel", ResMII,
+                       RecMII);
+      return;
+    }
+
+    if (SwpRegPressure && exceedsRegisterPressure(Schedule)) {
+      Scheduled = false;
+      ++NumFailRegPressure;
+      emitMissedRemark("RegisterPressure",
+                       "the kernel needs more registers than available",
+                       ResMII, RecMII);
+      return;
+    }
+  }
+
+  unsigned II = Schedule.getInitiationInterval();
+  Pass.ORE->emit([&]() {
+    return MachineOptimizationRemark(DEBUG_TYPE, "Pipelined",
+                                     Loop.getStartLoc(), Loop.getHeader())
+           << "pipelined loop with II " << ore::NV("II", II) << " (ResMII "
+           << ore::NV("ResMII", ResMII) << ", RecMII "
+           << ore::NV("RecMII", RecMII) << ") in "
+           << ore::NV("Stages", numStages + 1) << " stages";
+  });
+
   generatePipelinedLoop(Schedule);
   ++NumPipelined;
 }
 
+/// Report why a loop with a computed MII was not pipelined.
+void SwingSchedulerDAG::emitMissedRemark(StringRef Name, const Twine &Msg,
+                                         unsigned ResMII, unsigned RecMII) {
+  Pass.ORE->emit([&]() {
+    return MachineOptimizationRemarkMissed(DEBUG_TYPE, Name,
+                                           Loop.getStartLoc(),
+                                           Loop.getHeader())
+           << "loop not pipelined: " << Msg.str() << " (ResMII "
+           << ore::NV("ResMII", ResMII) << ", RecMII "
+           << ore::NV("RecMII", RecMII) << ")";
+  });
+}
+
+/// Move the loop compare to the end of the kernel when nothing in the
+/// schedule depends on its position. Instructions of later stages that
+/// clobber the condition flags are then all placed before it.
+void SwingSchedulerDAG::sinkLoopCompare(SMSchedule &Schedule) {
+  MachineInstr *Cmp = Pass.LI.LoopCompare;
+  if (!Cmp || Cmp->isTerminator())
+    return;
+  SUnit *CmpSU = getSUnit(Cmp);
+  if (!CmpSU || Schedule.stageScheduled(CmpSU) != 0)
+    return;
+  for (const SDep &Succ : CmpSU->Succs)
+    if (Schedule.stageScheduled(Succ.getSUnit()) != -1)
+      return;
+  for (const SDep &Pred : CmpSU->Preds)
+    if (isBackedge(CmpSU, Pred) || isLoopCarriedDep(CmpSU, Pred, false))
+      return;
+  Schedule.moveToFinalCycle(CmpSU);
+}
+
+/// The loop compare sets the physical registers, such as condition flags,
+/// that the branch at the end of the kernel reads. Pipelining is only correct
+/// if the compare belongs to the newest iteration in the kernel, i.e. it is
+/// scheduled in the first stage, and if no instruction after it in the
+/// kernel clobbers those registers. Loop controls that are terminators, such
+/// as hardware loop instructions, are not part of the schedule.
+bool SwingSchedulerDAG::keepsLoopCompareLast(SMSchedule &Schedule) {
+  MachineInstr *Cmp = Pass.LI.LoopCompare;
+  if (!Cmp || Cmp->isTerminator())
+    return true;
+  SUnit *CmpSU = getSUnit(Cmp);
+  if (!CmpSU || Schedule.stageScheduled(CmpSU) != 0)
+    return false;
+
+  bool SeenCmp = false;
+  for (int Cycle = Schedule.getFirstCycle(), E = Schedule.getFinalCycle();
+       Cycle <= E; ++Cycle) {
+    for (SUnit *SU : Schedule.getInstructions(Cycle)) {
+      if (SU == CmpSU) {
+        SeenCmp = true;
+        continue;
+      }
+      if (!SeenCmp)
+        continue;
+      for (const MachineOperand &MO : Cmp->operands())
+        if (MO.isReg() && MO.isDef() && !MO.isDead() &&
+            TargetRegisterInfo::isPhysicalRegister(MO.getReg()) &&
+            SU->getInstr()->modifiesRegister(MO.getReg(), TRI))
+          return false;
+    }
+  }
+  return true;
+}
+
+/// Estimate the register pressure of the kernel. The kernel needs at least
+/// the total lifetime of its values, in cycles, divided by the initiation
+/// interval, and each loop invariant needs one register. A value that feeds a
+/// Phi lives on until the uses of the Phi in the next iteration. Return true
+/// if the estimate exceeds the limit of a register pressure set.
+bool SwingSchedulerDAG::exceedsRegisterPressure(SMSchedule &Schedule) {
+  unsigned II = Schedule.getInitiationInterval();
+  auto getCycle = [&](SUnit *SU) -> int {
+    return Schedule.stageScheduled(SU) * II + Schedule.cycleScheduled(SU);
+  };
+
+  std::vector<unsigned> Lifetimes(TRI->getNumRegPressureSets(), 0);
+  std::vector<unsigned> Pressure(TRI->getNumRegPressureSets(), 0);
+  auto addPressure = [&](std::vector<unsigned> &Sets, unsigned Reg,
+                         unsigned Amount) {
+    const TargetRegisterClass *RC = MRI.getRegClass(Reg);
+    unsigned Weight = TRI->getRegClassWeight(RC).RegWeight * Amount;
+    for (const int *PSet = TRI->getRegClassPressureSets(RC); *PSet != -1;
+         ++PSet)
+      Sets[*PSet] += Weight;
+  };
+
+  SmallSet<unsigned, 16> Invariants;
+  for (SUnit &SU : SUnits) {
+    MachineInstr *MI = SU.getInstr();
+    for (const MachineOperand &MO : MI->operands()) {
+      if (!MO.isReg() || !TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+        continue;
+      unsigned Reg = MO.getReg();
+      if (!MO.isDef()) {
+        MachineInstr *Def = MRI.getVRegDef(Reg);
+        if ((!Def || Def->getParent() != BB) && Invariants.insert(Reg).second)
+          addPressure(Pressure, Reg, 1);
+        continue;
+      }
+      if (MI->isPHI())
+        continue;
+      int DefCycle = getCycle(&SU);
+      int LastUse = DefCycle + 1;
+      for (MachineInstr &UseMI : MRI.use_nodbg_instructions(Reg)) {
+        if (UseMI.getParent() != BB)
+          continue;
+        if (!UseMI.isPHI()) {
+          if (SUnit *UseSU = getSUnit(&UseMI))
+            LastUse = std::max(LastUse, getCycle(UseSU));
+          continue;
+        }
+        for (MachineInstr &PhiUseMI :
+             MRI.use_nodbg_instructions(UseMI.getOperand(0).getReg()))
+          if (SUnit *UseSU = getSUnit(&PhiUseMI))
+            LastUse = std::max(LastUse, getCycle(UseSU) + (int)II);
+      }
+      addPressure(Lifetimes, Reg, LastUse - DefCycle);
+    }
+  }
+  for (unsigned PSet = 0, E = Pressure.size(); PSet != E; ++PSet)
+    Pressure[PSet] += (Lifetimes[PSet] + II - 1) / II;
+
+  for (unsigned PSet = 0, E = Pressure.size(); PSet != E; ++PSet) {
+    unsigned Limit = RegClassInfo.getRegPressureSetLimit(PSet);
+    if (Pressure[PSet] > Limit) {
+      LLVM_DEBUG(dbgs() << "Register pressure " << Pressure[PSet] << " in "
+                        << TRI->getRegPressureSetName(PSet)
+                        << " exceeds the limit " << Limit << "\n");
+      return true;
+    }
+  }
+  return false;
+}
+
 /// Clean up after the software pipeliner runs.
 void SwingSchedulerDAG::finishBlock() {
   for (MachineInstr *I : NewMIs)
@@ -1312,9 +1564,15 @@ namespace {
 // the number of functional unit choices.
 struct FuncUnitSorter {
   const InstrItineraryData *InstrItins;
+  const TargetSchedModel &SchedModel;
   DenseMap<unsigned, unsigned> Resources;
 
-  FuncUnitSorter(const InstrItineraryData *IID) : InstrItins(IID) {}
+  FuncUnitSorter(const InstrItineraryData *IID, const TargetSchedModel &SM)
+      : InstrItins(IID), SchedModel(SM) {}
+
+  /// Return true if the functional units are described by itineraries rather
+  /// than by the processor resources of the machine model.
+  bool useItineraries() const { return InstrItins && !InstrItins->isEmpty(); }
 
   // Compute the number of functional unit alternatives needed
   // at each stage, and take the minimum value. We prioritize the
@@ -1322,6 +1580,25 @@ struct FuncUnitSorter {
   unsigned minFuncUnits(const MachineInstr *Inst, unsigned &F) const {
     unsigned schedClass = Inst->getDesc().getSchedClass();
     unsigned min = UINT_MAX;
+    if (!useItineraries()) {
+      // The alternatives are the units of each processor resource.
+      const MCSchedClassDesc *SC = SchedModel.resolveSchedClass(Inst);
+      if (!SC->isValid())
+        return min;
+      for (const MCWriteProcResEntry &PRE :
+           make_range(SchedModel.getWriteProcResBegin(SC),
+                      SchedModel.getWriteProcResEnd(SC))) {
+        if (!PRE.Cycles)
+          continue;
+        unsigned NumUnits =
+            SchedModel.getProcResource(PRE.ProcResourceIdx)->NumUnits;
+        if (NumUnits < min) {
+          min = NumUnits;
+          F = PRE.ProcResourceIdx;
+        }
+      }
+      return min;
+    }
     for (const InstrStage *IS = InstrItins->beginStage(schedClass),
                           *IE = InstrItins->endStage(schedClass);
          IS != IE; ++IS) {
@@ -1341,6 +1618,18 @@ struct FuncUnitSorter {
   // for computing the resource MII. The instrutions that require
   // the same, highly used, functional unit have high priority.
   void calcCriticalResources(MachineInstr &MI) {
+    if (!useItineraries()) {
+      const MCSchedClassDesc *SC = SchedModel.resolveSchedClass(&MI);
+      if (!SC->isValid())
+        return;
+      for (const MCWriteProcResEntry &PRE :
+           make_range(SchedModel.getWriteProcResBegin(SC),
+                      SchedModel.getWriteProcResEnd(SC)))
+        if (PRE.Cycles &&
+            SchedModel.getProcResource(PRE.ProcResourceIdx)->NumUnits == 1)
+          Resources[PRE.ProcResourceIdx]++;
+      return;
+    }
     unsigned SchedClass = MI.getDesc().getSchedClass();
     for (const InstrStage *IS = InstrItins->beginStage(SchedClass),
                           *IE = InstrItins->endStage(SchedClass);
@@ -1370,15 +1659,19 @@ struct FuncUnitSorter {
 /// for each cycle that is required. When adding a new instruction, we attempt
 /// to add it to each existing DFA, until a legal space is found. If the
 /// instruction cannot be reserved in an existing DFA, we create a new one.
+/// Without a DFA, the resource usage of the machine model bounds the II.
 unsigned SwingSchedulerDAG::calculateResMII() {
   SmallVector<DFAPacketizer *, 8> Resources;
   MachineBasicBlock *MBB = Loop.getHeader();
-  Resources.push_back(TII->CreateTargetScheduleState(MF.getSubtarget()));
+  DFAPacketizer *DFA = TII->CreateTargetScheduleState(MF.getSubtarget());
+  if (!DFA)
+    return calculateResMIIFromSchedModel();
+  Resources.push_back(DFA);
 
   // Sort the instructions by the number of available choices for scheduling,
   // least to most. Use the number of critical resources as the tie breaker.
   FuncUnitSorter FUS =
-      FuncUnitSorter(MF.getSubtarget().getInstrItineraryData());
+      FuncUnitSorter(MF.getSubtarget().getInstrItineraryData(), SchedModel);
   for (MachineBasicBlock::iterator I = MBB->getFirstNonPHI(),
                                    E = MBB->getFirstTerminator();
        I != E; ++I)
@@ -1433,6 +1726,81 @@ unsigned SwingSchedulerDAG::calculateResMII() {
   return Resmii;
 }
 
+/// Calculate the resource constrained minimum initiation interval from the
+/// machine scheduling model. Each processor resource is busy for the cycles
+/// that the loop body uses it, spread over its units, and the issue width
+/// limits the number of micro-ops per cycle.
+unsigned SwingSchedulerDAG::calculateResMIIFromSchedModel() {
+  SmallVector<uint64_t, 16> ResourceCycles(
+      SchedModel.getNumProcResourceKinds());
+  uint64_t NumMicroOps = 0;
+  MachineBasicBlock *MBB = Loop.getHeader();
+  for (MachineBasicBlock::iterator I = MBB->getFirstNonPHI(),
+                                   E = MBB->getFirstTerminator();
+       I != E; ++I) {
+    if (TII->isZeroCost(I->getOpcode()))
+      continue;
+    const MCSchedClassDesc *SC = SchedModel.resolveSchedClass(&*I);
+    if (!SC->isValid())
+      continue;
+    NumMicroOps += SC->NumMicroOps;
+    for (const MCWriteProcResEntry &PRE :
+         make_range(SchedModel.getWriteProcResBegin(SC),
+                    SchedModel.getWriteProcResEnd(SC)))
+      ResourceCycles[PRE.ProcResourceIdx] += PRE.Cycles;
+  }
+
+  uint64_t ResMII = divideCeil(NumMicroOps, SchedModel.getIssueWidth());
+  for (unsigned Idx = 1, E = ResourceCycles.size(); Idx != E; ++Idx) {
+    unsigned NumUnits = SchedModel.getProcResource(Idx)->NumUnits;
+    if (NumUnits)
+      ResMII = std::max(ResMII, divideCeil(ResourceCycles[Idx], NumUnits));
+  }
+  return ResMII;
+}
+
+bool ResourceManager::canReserveResources(MachineInstr &MI) const {
+  if (DFAResources)
+    return DFAResources->canReserveResources(MI);
+
+  const MCSchedClassDesc *SC = SchedModel.resolveSchedClass(&MI);
+  if (!SC->isValid())
+    return true;
+  // An instruction wider than the machine still issues on its own.
+  if (NumMicroOps && NumMicroOps + SC->NumMicroOps > SchedModel.getIssueWidth())
+    return false;
+  for (const MCWriteProcResEntry &PRE :
+       make_range(SchedModel.getWriteProcResBegin(SC),
+                  SchedModel.getWriteProcResEnd(SC)))
+    if (PRE.Cycles && ProcResourceCount[PRE.ProcResourceIdx] >=
+                          SchedModel.getProcResource(PRE.ProcResourceIdx)
+                              ->NumUnits)
+      return false;
+  return true;
+}
+
+void ResourceManager::reserveResources(MachineInstr &MI) {
+  if (DFAResources)
+    return DFAResources->reserveResources(MI);
+
+  const MCSchedClassDesc *SC = SchedModel.resolveSchedClass(&MI);
+  if (!SC->isValid())
+    return;
+  NumMicroOps += SC->NumMicroOps;
+  for (const MCWriteProcResEntry &PRE :
+       make_range(SchedModel.getWriteProcResBegin(SC),
+                  SchedModel.getWriteProcResEnd(SC)))
+    if (PRE.Cycles)
+      ++ProcResourceCount[PRE.ProcResourceIdx];
+}
+
+void ResourceManager::clearResources() {
+  if (DFAResources)
+    return DFAResources->clearResources();
+  std::fill(ProcResourceCount.begin(), ProcResourceCount.end(), 0);
+  NumMicroOps = 0;
+}
+
 /// Calculate the recurrence-constrainted minimum initiation interval.
 /// Iterate over each circuit.  Compute the delay(c) and distance(c)
 /// for each circuit. The II needs to satisfy the inequality
@@ -3609,7 +3977,7 @@ bool SMSchedule::insert(SUnit *SU, int StartCycle, int EndCycle, int II) {
        forward ? ++curCycle : --curCycle) {
 
     // Add the already scheduled instructions at the specified cycle to the DFA.
-    Resources->clearResources();
+    Resources.clearResources();
     for (int checkCycle = FirstCycle + ((curCycle - FirstCycle) % II);
          checkCycle <= LastCycle; checkCycle += II) {
       std::deque<SUnit *> &cycleInstrs = ScheduledInstrs[checkCycle];
@@ -3619,13 +3987,13 @@ bool SMSchedule::insert(SUnit *SU, int StartCycle, int EndCycle, int II) {
            I != E; ++I) {
         if (ST.getInstrInfo()->isZeroCost((*I)->getInstr()->getOpcode()))
           continue;
-        assert(Resources->canReserveResources(*(*I)->getInstr()) &&
+        assert(Resources.canReserveResources(*(*I)->getInstr()) &&
                "These instructions have already been scheduled.");
-        Resources->reserveResources(*(*I)->getInstr());
+        Resources.reserveResources(*(*I)->getInstr());
       }
     }
     if (ST.getInstrInfo()->isZeroCost(SU->getInstr()->getOpcode()) ||
-        Resources->canReserveResources(*SU->getInstr())) {
+        Resources.canReserveResources(*SU->getInstr())) {
       LLVM_DEBUG({
         dbgs() << "\tinsert at cycle " << curCycle << " ";
         SU->getInstr()->dump();
@@ -4105,6 +4473,17 @@ void SwingSchedulerDAG::fixupRegisterOverlaps(std::deque<SUnit *> &Instrs) {
   }
 }
 
+/// Move an instruction of the first stage of a finalized schedule to the end
+/// of the last cycle of the kernel.
+void SMSchedule::moveToFinalCycle(SUnit *SU) {
+  assert(stageScheduled(SU) == 0 && "Expected an instruction of stage 0");
+  int &Cycle = InstrToCycle[SU];
+  std::deque<SUnit *> &CycleInstrs = ScheduledInstrs[Cycle];
+  CycleInstrs.erase(std::find(CycleInstrs.begin(), CycleInstrs.end(), SU));
+  Cycle = getFinalCycle();
+  ScheduledInstrs[Cycle].push_back(SU);
+}
+
 /// After the schedule has been formed, call this function to combine
 /// the instructions from the different stages/cycles.  That is, this
 /// function creates a schedule that represents a single iteration.
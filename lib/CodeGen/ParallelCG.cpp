@@ -92,7 +92,7 @@ std::unique_ptr<Module> llvm::splitCodeGen(
               // copied into the thread's context.
               std::move(BC));
         },
-        PreserveLocals);
+        PreserveLocals, /*BalancePartitions=*/true);
   }
 
   return {};
@@ -126,6 +126,18 @@ namespace {
     /// One of the RegState enums, or a virtreg.
     std::vector<unsigned> PhysRegState;
 
+    /// Registers that may have left the regDisabled state in the current
+    /// block. Only these are reset for the next block, which keeps the cost of
+    /// a block independent of the number of target registers. A register
+    /// that is enabled again after being disabled is recorded once.
+    SparseSet<unsigned> EnabledPhysRegs;
+
+    void setPhysRegState(MCPhysReg PhysReg, unsigned NewState) {
+      if (PhysRegState[PhysReg] == regDisabled && NewState != regDisabled)
+        EnabledPhysRegs.insert(PhysReg);
+      PhysRegState[PhysReg] = NewState;
+    }
+
     SmallVector<unsigned, 16> VirtDead;
     SmallVector<MachineInstr *, 32> Coalesced;
 
@@ -285,7 +297,7 @@ void RegAllocFast::killVirtReg(LiveRegMap::iterator LRI) {
   addKillFlag(*LRI);
   assert(PhysRegState[LRI->PhysReg] == LRI->VirtReg &&
          "Broken RegState mapping");
-  PhysRegState[LRI->PhysReg] = regFree;
+  setPhysRegState(LRI->PhysReg, regFree);
   // Erase from LiveVirtRegs unless we're spilling in bulk.
   if (!isBulkSpilling)
     LiveVirtRegs.erase(LRI);
@@ -333,20 +345,22 @@ void RegAllocFast::spillVirtReg(MachineBasicBlock::iterator MI,
     // If this register is used by DBG_VALUE then insert new DBG_VALUE to
     // identify spilled location as the place to find corresponding variable's
     // value.
-    SmallVectorImpl<MachineInstr *> &LRIDbgValues =
-      LiveDbgValueMap[LRI->VirtReg];
-    for (MachineInstr *DBG : LRIDbgValues) {
-      MachineInstr *NewDV = buildDbgValueForSpill(*MBB, MI, *DBG, FI);
-      assert(NewDV->getParent() == MBB && "dangling parent pointer");
-      (void)NewDV;
-      LLVM_DEBUG(dbgs() << "Inserting debug info due to spill:"
-                        << "\n"
-                        << *NewDV);
+    // Only look the register up, most spilled registers have no DBG_VALUEs.
+    auto DbgValues = LiveDbgValueMap.find(LRI->VirtReg);
+    if (DbgValues != LiveDbgValueMap.end()) {
+      for (MachineInstr *DBG : DbgValues->second) {
+        MachineInstr *NewDV = buildDbgValueForSpill(*MBB, MI, *DBG, FI);
+        assert(NewDV->getParent() == MBB && "dangling parent pointer");
+        (void)NewDV;
+        LLVM_DEBUG(dbgs() << "Inserting debug info due to spill:"
+                          << "\n"
+                          << *NewDV);
+      }
+      // Now this register is spilled there is should not be any DBG_VALUE
+      // pointing to this register because they are all pointing to spilled
+      // value now.
+      LiveDbgValueMap.erase(DbgValues);
     }
-    // Now this register is spilled there is should not be any DBG_VALUE
-    // pointing to this register because they are all pointing to spilled value
-    // now.
-    LRIDbgValues.clear();
     if (SpillKill)
       LR.LastUse = nullptr; // Don't kill register again
   }
@@ -383,7 +397,7 @@ void RegAllocFast::usePhysReg(MachineOperand &MO) {
   case regDisabled:
     break;
   case regReserved:
-    PhysRegState[PhysReg] = regFree;
+    setPhysRegState(PhysReg, regFree);
     LLVM_FALLTHROUGH;
   case regFree:
     MO.setIsKill();
@@ -417,12 +431,12 @@ void RegAllocFast::usePhysReg(MachineOperand &MO) {
     case regFree:
       if (TRI->isSuperRegister(PhysReg, Alias)) {
         // Leave the superregister in the working set.
-        PhysRegState[Alias] = regFree;
+        setPhysRegState(Alias, regFree);
         MO.getParent()->addRegisterKilled(Alias, TRI, true);
         return;
       }
       // Some other alias was in the working set - clear it.
-      PhysRegState[Alias] = regDisabled;
+      setPhysRegState(Alias, regDisabled);
       break;
     default:
       llvm_unreachable("Instruction uses an alias of an allocated register");
@@ -430,7 +444,7 @@ void RegAllocFast::usePhysReg(MachineOperand &MO) {
   }
 
   // All aliases are disabled, bring register into working set.
-  PhysRegState[PhysReg] = regFree;
+  setPhysRegState(PhysReg, regFree);
   MO.setIsKill();
 }
 
@@ -448,12 +462,12 @@ void RegAllocFast::definePhysReg(MachineBasicBlock::iterator MI,
     LLVM_FALLTHROUGH;
   case regFree:
   case regReserved:
-    PhysRegState[PhysReg] = NewState;
+    setPhysRegState(PhysReg, NewState);
     return;
   }
 
   // This is a disabled register, disable all aliases.
-  PhysRegState[PhysReg] = NewState;
+  setPhysRegState(PhysReg, NewState);
   for (MCRegAliasIterator AI(PhysReg, TRI, false); AI.isValid(); ++AI) {
     MCPhysReg Alias = *AI;
     switch (unsigned VirtReg = PhysRegState[Alias]) {
@@ -464,7 +478,7 @@ void RegAllocFast::definePhysReg(MachineBasicBlock::iterator MI,
       LLVM_FALLTHROUGH;
     case regFree:
     case regReserved:
-      PhysRegState[Alias] = regDisabled;
+      setPhysRegState(Alias, regDisabled);
       if (TRI->isSuperRegister(PhysReg, Alias))
         return;
       break;
@@ -528,7 +542,7 @@ unsigned RegAllocFast::calcSpillCost(MCPhysReg PhysReg) const {
 void RegAllocFast::assignVirtToPhysReg(LiveReg &LR, MCPhysReg PhysReg) {
   LLVM_DEBUG(dbgs() << "Assigning " << printReg(LR.VirtReg, TRI) << " to "
                     << printReg(PhysReg, TRI) << "\n");
-  PhysRegState[PhysReg] = LR.VirtReg;
+  setPhysRegState(PhysReg, LR.VirtReg);
   assert(!LR.PhysReg && "Already assigned a physreg");
   LR.PhysReg = PhysReg;
 }
@@ -854,7 +868,9 @@ void RegAllocFast::allocateBasicBlock(MachineBasicBlock &MBB) {
   this->MBB = &MBB;
   LLVM_DEBUG(dbgs() << "\nAllocating " << MBB);
 
-  PhysRegState.assign(TRI->getNumRegs(), regDisabled);
+  for (MCPhysReg PhysReg : EnabledPhysRegs)
+    PhysRegState[PhysReg] = regDisabled;
+  EnabledPhysRegs.clear();
   assert(LiveVirtRegs.empty() && "Mapping not cleared from last block?");
 
   MachineBasicBlock::iterator MII = MBB.begin();
@@ -1097,6 +1113,9 @@ bool RegAllocFast::runOnMachineFunction(MachineFunction &MF) {
   RegClassInfo.runOnMachineFunction(MF);
   UsedInInstr.clear();
   UsedInInstr.setUniverse(TRI->getNumRegUnits());
+  PhysRegState.assign(TRI->getNumRegs(), regDisabled);
+  EnabledPhysRegs.clear();
+  EnabledPhysRegs.setUniverse(TRI->getNumRegs());
 
   // initialize the virtual->physical register map to have a 'null'
   // mapping for all virtual registers
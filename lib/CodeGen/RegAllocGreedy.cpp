@@ -85,6 +85,9 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumOverBudget,   "Number of functions that exhausted the work budget");
+STATISTIC(NumCheapDecisions, "Number of cheaper decisions made over budget");
+STATISTIC(NumSplitQueriesReused, "Number of region split queries reused");
 
 static cl::opt<SplitEditor::ComplementSpillMode> SplitSpillMode(
     "split-spill-mode", cl::Hidden,
@@ -137,6 +140,13 @@ CSRFirstTimeCost("regalloc-csr-first-time-cost",
               cl::desc("Cost for first time use of callee-saved register."),
               cl::init(0), cl::Hidden);
 
+static cl::opt<unsigned> WorkBudget(
+    "regalloc-greedy-work-budget", cl::Hidden,
+    cl::desc("Amount of eviction and region splitting work per function "
+             "after which cheaper allocation decisions are made (0 = no "
+             "limit)"),
+    cl::init(20000000));
+
 static cl::opt<bool> ConsiderLocalIntervalCost(
     "condsider-local-interval-cost", cl::Hidden,
     cl::desc("Consider the cost of local intervals created by a split "
@@ -412,6 +422,27 @@ class RAGreedy : public MachineFunctionPass,
   /// Set of broken hints that may be reconciled later because of eviction.
   SmallSetVector<LiveInterval *, 8> SetOfBrokenHints;
 
+  /// Amount of eviction and splitting work done in the current function,
+  /// measured in interference queries and visited blocks.
+  uint64_t WorkUnits;
+
+  /// Number of decisions made with the cheaper strategies because the work
+  /// budget was exhausted.
+  unsigned NumBudgetFallbacks;
+
+  /// A region split candidate that had no positive bundles, together with the
+  /// tags of the interference unions it was computed against.
+  struct UnsplittableCand {
+    unsigned PhysReg;
+    SmallVector<unsigned, 4> Tags;
+  };
+
+  /// Region split queries that found no positive bundles, per virtual
+  /// register. The answer stays valid until the interference in one of the
+  /// register units changes or the live range is modified, so split attempts
+  /// after evictions and requeues don't have to repeat it.
+  DenseMap<unsigned, SmallVector<UnsplittableCand, 4>> Unsplittable;
+
 public:
   RAGreedy();
 
@@ -537,6 +568,13 @@ private:
 
   bool isUnusedCalleeSavedReg(unsigned PhysReg) const;
 
+  /// Return true when the current function has used up its work budget.
+  bool isOverBudget() const { return WorkBudget && WorkUnits > WorkBudget; }
+  void getUnionTags(unsigned PhysReg, SmallVectorImpl<unsigned> &Tags) const;
+  bool isKnownUnsplittable(unsigned VirtReg, unsigned PhysReg) const;
+  void setKnownUnsplittable(unsigned VirtReg, unsigned PhysReg);
+  void reportWorkBudgetExceeded();
+
   /// Compute and report the number of spills and reloads for a loop.
   void reportNumberOfSplillsReloads(MachineLoop *L, unsigned &Reloads,
                                     unsigned &FoldedReloads, unsigned &Spills,
@@ -632,6 +670,7 @@ void RAGreedy::getAnalysisUsage(AnalysisUsage &AU) const {
 
 bool RAGreedy::LRE_CanEraseVirtReg(unsigned VirtReg) {
   LiveInterval &LI = LIS->getInterval(VirtReg);
+  Unsplittable.erase(VirtReg);
   if (VRM->hasPhys(VirtReg)) {
     Matrix->unassign(LI);
     aboutToRemoveInterval(LI);
@@ -646,6 +685,7 @@ bool RAGreedy::LRE_CanEraseVirtReg(unsigned VirtReg) {
 }
 
 void RAGreedy::LRE_WillShrinkVirtReg(unsigned VirtReg) {
+  Unsplittable.erase(VirtReg);
   if (!VRM->hasPhys(VirtReg))
     return;
 
@@ -673,6 +713,7 @@ void RAGreedy::releaseMemory() {
   SpillerInstance.reset();
   ExtraRegInfo.clear();
   GlobalCand.clear();
+  Unsplittable.clear();
 }
 
 void RAGreedy::enqueue(LiveInterval *LI) { enqueue(Queue, LI); }
@@ -888,7 +929,9 @@ bool RAGreedy::canEvictInterference(LiveInterval &VirtReg, unsigned PhysReg,
   for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
     LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
     // If there is 10 or more interferences, chances are one is heavier.
-    if (Q.collectInterferingVRegs(10) >= 10)
+    unsigned NumIntf = Q.collectInterferingVRegs(10);
+    WorkUnits += 1 + NumIntf;
+    if (NumIntf >= 10)
       return false;
 
     // Check if any interfering live range is heavier than MaxWeight.
@@ -918,6 +961,10 @@ bool RAGreedy::canEvictInterference(LiveInterval &VirtReg, unsigned PhysReg,
         // last resort, though, so make it really expensive.
         Cost.BrokenHints += 10;
       }
+      // Over budget, don't extend eviction chains. A live range that was
+      // already evicted once is split or spilled instead.
+      if (IntfCascade && !Urgent && isOverBudget())
+        return false;
       // Would this break a satisfied hint?
       bool BreaksHint = VRM->hasPreferredPhys(Intf->reg);
       // Update eviction cost.
@@ -1151,6 +1198,13 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
     // Stop if the hint can be used.
     if (Order.isHint())
       break;
+
+    // Over budget, settle for the first register that can be evicted instead
+    // of searching for the cheapest one.
+    if (isOverBudget()) {
+      ++NumBudgetFallbacks;
+      break;
+    }
   }
 
   if (!BestPhys)
@@ -1832,6 +1886,46 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
   return doRegionSplit(VirtReg, BestCand, HasCompact, NewVRegs);
 }
 
+/// getUnionTags - Collect the current tags of the interference unions of the
+/// register units in PhysReg.
+void RAGreedy::getUnionTags(unsigned PhysReg,
+                            SmallVectorImpl<unsigned> &Tags) const {
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units)
+    Tags.push_back(Matrix->getLiveUnions()[*Units].getTag());
+}
+
+/// isKnownUnsplittable - Return true if an earlier split attempt found that
+/// PhysReg has no positive bundles for VirtReg, and none of the interference
+/// it was computed against has changed since.
+bool RAGreedy::isKnownUnsplittable(unsigned VirtReg, unsigned PhysReg) const {
+  auto I = Unsplittable.find(VirtReg);
+  if (I == Unsplittable.end())
+    return false;
+  for (const UnsplittableCand &C : I->second) {
+    if (C.PhysReg != PhysReg)
+      continue;
+    SmallVector<unsigned, 4> Tags;
+    getUnionTags(PhysReg, Tags);
+    return C.Tags == Tags;
+  }
+  return false;
+}
+
+void RAGreedy::setKnownUnsplittable(unsigned VirtReg, unsigned PhysReg) {
+  SmallVectorImpl<UnsplittableCand> &Cands = Unsplittable[VirtReg];
+  UnsplittableCand *C = nullptr;
+  for (UnsplittableCand &Cand : Cands)
+    if (Cand.PhysReg == PhysReg)
+      C = &Cand;
+  if (!C) {
+    Cands.emplace_back();
+    C = &Cands.back();
+    C->PhysReg = PhysReg;
+  }
+  C->Tags.clear();
+  getUnionTags(PhysReg, C->Tags);
+}
+
 unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
                                             AllocationOrder &Order,
                                             BlockFrequency &BestCost,
@@ -1866,12 +1960,20 @@ unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
     if (GlobalCand.size() <= NumCands)
       GlobalCand.resize(NumCands+1);
     GlobalSplitCandidate &Cand = GlobalCand[NumCands];
+    if (isKnownUnsplittable(VirtReg.reg, PhysReg)) {
+      LLVM_DEBUG(dbgs() << printReg(PhysReg, TRI)
+                        << "\tno positive bundles (cached)\n");
+      ++NumSplitQueriesReused;
+      continue;
+    }
     Cand.reset(IntfCache, PhysReg);
+    WorkUnits += SA->getUseBlocks().size() + SA->getNumThroughBlocks();
 
     SpillPlacer->prepare(Cand.LiveBundles);
     BlockFrequency Cost;
     if (!addSplitConstraints(Cand.Intf, Cost)) {
       LLVM_DEBUG(dbgs() << printReg(PhysReg, TRI) << "\tno positive bundles\n");
+      setKnownUnsplittable(VirtReg.reg, PhysReg);
       continue;
     }
     LLVM_DEBUG(dbgs() << printReg(PhysReg, TRI) << "\tstatic = ";
@@ -2442,14 +2544,18 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
   if (SA->didRepairRange()) {
     // VirtReg has changed, so all cached queries are invalid.
     Matrix->invalidateVirtRegs();
+    Unsplittable.erase(VirtReg.reg);
     if (unsigned PhysReg = tryAssign(VirtReg, Order, NewVRegs))
       return PhysReg;
   }
 
   // First try to split around a region spanning multiple blocks. RS_Split2
   // ranges already made dubious progress with region splitting, so they go
-  // straight to single block splitting.
-  if (getStage(VirtReg) < RS_Split2) {
+  // straight to single block splitting. Region splitting is also skipped once
+  // the work budget is used up.
+  if (getStage(VirtReg) < RS_Split2 && isOverBudget()) {
+    ++NumBudgetFallbacks;
+  } else if (getStage(VirtReg) < RS_Split2) {
     unsigned PhysReg = tryRegionSplit(VirtReg, Order, NewVRegs);
     if (PhysReg || !NewVRegs.empty())
       return PhysReg;
@@ -2772,6 +2878,11 @@ unsigned RAGreedy::tryAssignCSRFirstTime(LiveInterval &VirtReg,
     return 0;
   }
   if (getStage(VirtReg) < RS_Split) {
+    // Over budget, don't look for a pre-split.
+    if (isOverBudget()) {
+      ++NumBudgetFallbacks;
+      return PhysReg;
+    }
     // We choose pre-splitting over using the CSR for the first time if
     // the cost of splitting is lower than CSRCost.
     SA->analyze(&VirtReg);
@@ -3155,6 +3266,25 @@ void RAGreedy::reportNumberOfSplillsReloads(MachineLoop *L, unsigned &Reloads,
   }
 }
 
+void RAGreedy::reportWorkBudgetExceeded() {
+  using namespace ore;
+
+  ++NumOverBudget;
+  NumCheapDecisions += NumBudgetFallbacks;
+  LLVM_DEBUG(dbgs() << "Work budget exceeded: " << WorkUnits << " units, "
+                    << NumBudgetFallbacks << " cheaper decisions\n");
+  ORE->emit([&]() {
+    MachineOptimizationRemarkMissed R(DEBUG_TYPE, "WorkBudgetExceeded",
+                                      MF->getFunction().getSubprogram(),
+                                      &MF->front());
+    R << "register allocation exceeded its work budget of "
+      << NV("WorkBudget", WorkBudget) << " units; made "
+      << NV("NumFallbacks", NumBudgetFallbacks)
+      << " cheaper eviction and splitting decisions";
+    return R;
+  });
+}
+
 bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   LLVM_DEBUG(dbgs() << "********** GREEDY REGISTER ALLOCATION **********\n"
                     << "********** Function: " << mf.getName() << '\n');
@@ -3203,11 +3333,16 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   GlobalCand.resize(32);  // This will grow as needed.
   SetOfBrokenHints.clear();
   LastEvicted.clear();
+  Unsplittable.clear();
+  WorkUnits = 0;
+  NumBudgetFallbacks = 0;
 
   allocatePhysRegs();
   tryHintsRecoloring();
   postOptimization();
   reportNumberOfSplillsReloads();
+  if (isOverBudget())
+    reportWorkBudgetExceeded();
 
   releaseMemory();
   return true;
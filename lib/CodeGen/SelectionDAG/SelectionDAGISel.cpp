@@ -111,6 +111,8 @@ STATISTIC(NumDAGIselRetries,"Number of times dag isel has to try another path");
 STATISTIC(NumEntryBlocks, "Number of entry blocks encountered");
 STATISTIC(NumFastIselFailLowerArguments,
           "Number of entry blocks where fast isel failed to lower arguments");
+STATISTIC(NumHugeBlocksSplit,
+          "Number of basic blocks split to bound their DAG size");
 
 static cl::opt<int> EnableFastISelAbort(
     "fast-isel-abort", cl::Hidden,
@@ -130,6 +132,13 @@ UseMBPI("use-mbpi",
         cl::desc("use Machine Branch Probability Info"),
         cl::init(true), cl::Hidden);
 
+static cl::opt<unsigned>
+DAGMaxBlockSize("dag-max-block-size", cl::init(20000), cl::Hidden,
+                cl::desc("Split basic blocks with more instructions than "
+                         "this before building their SelectionDAGs, which "
+                         "bounds the time spent on huge blocks "
+                         "(0 = unlimited)"));
+
 #ifndef NDEBUG
 static cl::opt<std::string>
 FilterDAGBasicBlockName("filter-view-dags", cl::Hidden,
@@ -377,6 +386,93 @@ static void SplitCriticalSideEffectEdges(Function &Fn, DominatorTree *DT,
   }
 }
 
+/// Return true if \p BB may be split before \p I without changing how the
+/// instructions around the split point are lowered.
+static bool isSafeBlockSplitPoint(const Instruction &I) {
+  if (I.isTerminator() || isa<DbgInfoIntrinsic>(I) || isa<AllocaInst>(I))
+    return false;
+  // A tail call has to stay next to the return that follows it.
+  if (const auto *CI = dyn_cast_or_null<CallInst>(I.getPrevNode()))
+    if (CI->isTailCall())
+      return false;
+  return true;
+}
+
+/// Split the basic blocks of \p Fn that have more than \p MaxSize
+/// instructions, since the DAG combiner, the legalizer and the scheduler take
+/// super-linear time in the size of a block. Values that are live across the
+/// new block boundaries are exported in virtual registers, which only blocks
+/// some folding across them.
+static void SplitHugeBlocks(Function &Fn, unsigned MaxSize, DominatorTree *DT,
+                            LoopInfo *LI, BranchProbabilityInfo *BPI,
+                            OptimizationRemarkEmitter &ORE) {
+  SmallVector<BasicBlock *, 4> HugeBlocks;
+  for (BasicBlock &BB : Fn)
+    if (BB.size() > MaxSize)
+      HugeBlocks.push_back(&BB);
+
+  for (BasicBlock *BB : HugeBlocks) {
+    // Token values cannot be exported to other blocks.
+    if (any_of(*BB, [](const Instruction &I) {
+          return I.getType()->isTokenTy();
+        }))
+      continue;
+
+    // Static allocas have to stay in the entry block.
+    BasicBlock::iterator Begin = BB->getFirstInsertionPt();
+    if (BB == &Fn.getEntryBlock())
+      for (auto I = Begin, E = BB->end(); I != E; ++I)
+        if (isa<AllocaInst>(*I))
+          Begin = std::next(I);
+
+    unsigned Size = 0, PieceSize = 0;
+    SmallVector<Instruction *, 4> SplitPoints;
+    for (Instruction &I : make_range(Begin, BB->end())) {
+      if (isa<DbgInfoIntrinsic>(I))
+        continue;
+      ++Size;
+      if (PieceSize >= MaxSize && isSafeBlockSplitPoint(I)) {
+        SplitPoints.push_back(&I);
+        PieceSize = 0;
+      }
+      ++PieceSize;
+    }
+    if (SplitPoints.empty())
+      continue;
+
+    // The last piece takes the terminator and its edge probabilities.
+    SmallVector<BranchProbability, 4> Probs;
+    if (BPI)
+      for (unsigned I = 0, E = BB->getTerminator()->getNumSuccessors(); I != E;
+           ++I)
+        Probs.push_back(BPI->getEdgeProbability(BB, I));
+
+    BasicBlock *Piece = BB;
+    for (Instruction *SplitPt : SplitPoints) {
+      BasicBlock *Next = SplitBlock(Piece, SplitPt, DT, LI);
+      if (BPI)
+        BPI->setEdgeProbability(Piece, 0, BranchProbability::getOne());
+      Piece = Next;
+    }
+    if (BPI)
+      for (unsigned I = 0, E = Probs.size(); I != E; ++I)
+        BPI->setEdgeProbability(Piece, I, Probs[I]);
+
+    ++NumHugeBlocksSplit;
+    LLVM_DEBUG(dbgs() << "Split " << BB->getName() << " with " << Size
+                      << " instructions into " << SplitPoints.size() + 1
+                      << " blocks\n");
+    ORE.emit([&]() {
+      return OptimizationRemarkAnalysis(DEBUG_TYPE, "HugeBlockSplit",
+                                        BB->getFirstNonPHI())
+             << "split basic block with " << ore::NV("NumInstructions", Size)
+             << " instructions into "
+             << ore::NV("NumBlocks", unsigned(SplitPoints.size() + 1))
+             << " blocks to bound instruction selection time";
+    });
+  }
+}
+
 bool SelectionDAGISel::runOnMachineFunction(MachineFunction &mf) {
   // If we already selected that function, we do not need to run SDISel.
   if (mf.getProperties().hasProperty(
@@ -416,6 +512,14 @@ bool SelectionDAGISel::runOnMachineFunction(MachineFunction &mf) {
 
   SplitCriticalSideEffectEdges(const_cast<Function &>(Fn), DT, LI);
 
+  if (DAGMaxBlockSize) {
+    BranchProbabilityInfo *BPI = nullptr;
+    if (UseMBPI && OptLevel != CodeGenOpt::None)
+      BPI = &getAnalysis<BranchProbabilityInfoWrapperPass>().getBPI();
+    SplitHugeBlocks(const_cast<Function &>(Fn), DAGMaxBlockSize, DT, LI, BPI,
+                    *ORE);
+  }
+
   CurDAG->init(*MF, *ORE, this, LibInfo,
    getAnalysisIfAvailable<DivergenceAnalysis>());
   FuncInfo->set(Fn, *MF, CurDAG);
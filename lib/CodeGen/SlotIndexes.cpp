@@ -24,6 +24,7 @@ INITIALIZE_PASS(SlotIndexes, DEBUG_TYPE,
 
 STATISTIC(NumLocalRenum,  "Number of local renumberings");
 STATISTIC(NumGlobalRenum, "Number of global renumberings");
+STATISTIC(NumIndexBytes, "Bytes allocated for index list entries");
 
 void SlotIndexes::getAnalysisUsage(AnalysisUsage &au) const {
   au.setPreservesAll();
@@ -96,6 +97,7 @@ bool SlotIndexes::runOnMachineFunction(MachineFunction &fn) {
 
   // Sort the Idx2MBBMap
   llvm::sort(idx2MBBMap.begin(), idx2MBBMap.end(), Idx2MBBCompare());
+  NumIndexBytes.addSaturating(ileAllocator.getBytesAllocated());
 
   LLVM_DEBUG(mf->print(dbgs(), this));
 
@@ -545,6 +545,33 @@ bool TargetLoweringObjectFileELF::shouldPutJumpTableInFunctionSection(
   return false;
 }
 
+MCSection *TargetLoweringObjectFileELF::getSectionForColdFragment(
+    const Function &F, const TargetMachine &TM) const {
+  // Put the fragment next to the functions that are cold as a whole. It has
+  // to be in the COMDAT group of the function, so that it is discarded along
+  // with it.
+  unsigned Flags = ELF::SHF_ALLOC | ELF::SHF_EXECINSTR;
+  StringRef Group = "";
+  if (const Comdat *C = getELFComdat(&F)) {
+    Flags |= ELF::SHF_GROUP;
+    Group = C->getName();
+  }
+
+  SmallString<128> Name(".text.unlikely");
+  unsigned UniqueID = MCContext::GenericSectionID;
+  if (TM.getFunctionSections() || F.hasComdat()) {
+    if (TM.getUniqueSectionNames()) {
+      Name.push_back('.');
+      TM.getNameWithPrefix(Name, &F, getMangler(), true);
+    } else {
+      UniqueID = NextUniqueID++;
+    }
+  }
+  return getContext().getELFSection(Name, ELF::SHT_PROGBITS, Flags,
+                                    /*EntrySize=*/0, Group, UniqueID,
+                                    /*AssociatedSymbol=*/nullptr);
+}
+
 /// Given a mergeable constant with the specified size and relocation
 /// information, return a section that it should be placed in.
 MCSection *TargetLoweringObjectFileELF::getSectionForConstant(
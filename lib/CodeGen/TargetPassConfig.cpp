@@ -14,6 +14,7 @@
 
 #include "llvm/CodeGen/TargetPassConfig.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/BasicAliasAnalysis.h"
@@ -121,6 +122,11 @@ static cl::opt<RunOutliner> EnableMachineOutliner(
                clEnumValN(NeverOutline, "never", "Disable all outlining"),
                // Sentinel value for unspecified option.
                clEnumValN(AlwaysOutline, "", "")));
+// Split cold blocks out of functions with profile data.
+static cl::opt<bool> EnableMachineFunctionSplitter(
+    "split-machine-functions", cl::Hidden,
+    cl::desc("Move the cold blocks of functions with profile data to a "
+             "separate section"));
 // Enable or disable FastISel. Both options are needed, because
 // FastISel is enabled by default with -fast, and we wish to be
 // able to enable or disable fast-isel independently from -O0.
@@ -152,6 +158,14 @@ static cl::opt<int> EnableGlobalISelAbort(
 cl::opt<bool> MISchedPostRA("misched-postra", cl::Hidden,
   cl::desc("Run MachineScheduler post regalloc (independent of preRA sched)"));
 
+// Experimental option to run the machine passes of all functions before
+// printing any. With -verify-machineinstrs, the finished functions are then
+// verified on -function-pass-threads threads.
+static cl::opt<bool> MachineFunctionBarriers(
+    "machine-function-barriers", cl::Hidden,
+    cl::desc("Run instruction selection through the pre-emit passes on every "
+             "function before printing the first one"));
+
 // Experimental option to run live interval analysis early.
 static cl::opt<bool> EarlyLiveIntervals("early-live-intervals", cl::Hidden,
     cl::desc("Run live interval analysis earlier in the pipeline"));
@@ -316,6 +330,18 @@ public:
   /// Store the pairs of <AnalysisID, AnalysisID> of which the second pass
   /// is inserted after each instance of the first one.
   SmallVector<InsertedPass, 4> InsertedPasses;
+
+  /// With -machine-function-barriers, the banner of the machine verifier that
+  /// is held back until the next pass is added. The one left after the last
+  /// machine pass runs between the barriers instead.
+  Optional<std::string> DeferredVerifyBanner;
+
+  void addDeferredVerifyPass(PassManagerBase &PM) {
+    if (!DeferredVerifyBanner)
+      return;
+    PM.add(createMachineVerifierPass(*DeferredVerifyBanner));
+    DeferredVerifyBanner = None;
+  }
 };
 
 } // end namespace llvm
@@ -491,6 +517,7 @@ void TargetPassConfig::addPass(Pass *P, bool verifyAfter, bool printAfter) {
     // Construct banner message before PM->add() as that may delete the pass.
     if (AddingMachinePasses && (printAfter || verifyAfter))
       Banner = std::string("After ") + std::string(P->getPassName());
+    Impl->addDeferredVerifyPass(*PM);
     PM->add(P);
     if (AddingMachinePasses) {
       if (printAfter)
@@ -547,8 +574,10 @@ void TargetPassConfig::printAndVerify(const std::string &Banner) {
 }
 
 void TargetPassConfig::addPrintPass(const std::string &Banner) {
-  if (TM->shouldPrintMachineCode())
+  if (TM->shouldPrintMachineCode()) {
+    Impl->addDeferredVerifyPass(*PM);
     PM->add(createMachineFunctionPrinterPass(dbgs(), Banner));
+  }
 }
 
 void TargetPassConfig::addVerifyPass(const std::string &Banner) {
@@ -557,7 +586,12 @@ void TargetPassConfig::addVerifyPass(const std::string &Banner) {
   if (VerifyMachineCode == cl::BOU_UNSET)
     Verify = TM->isMachineVerifierClean();
 #endif
-  if (Verify)
+  if (!Verify)
+    return;
+  Impl->addDeferredVerifyPass(*PM);
+  if (MachineFunctionBarriers && AddingMachinePasses)
+    Impl->DeferredVerifyBanner = Banner;
+  else
     PM->add(createMachineVerifierPass(Banner));
 }
 
@@ -699,6 +733,11 @@ void TargetPassConfig::addISelPrepare() {
   // Add both the safe stack and the stack protection passes: each of them will
   // only protect functions that have corresponding attributes.
   addPass(createSafeStackPass());
+
+  // Instruction selection reads the results of the stack protector, so they
+  // must run in the same function pass manager.
+  if (MachineFunctionBarriers)
+    addPass(createMachineFunctionBarrierPass(/*CreateFunctions=*/true));
   addPass(createStackProtectorPass());
 
   if (PrintISelInput)
@@ -922,10 +961,26 @@ void TargetPassConfig::addMachinePasses() {
       addPass(createMachineOutlinerPass(RunOnAllFunctions));
   }
 
+  if (EnableMachineFunctionSplitter && getOptLevel() != CodeGenOpt::None)
+    addPass(createMachineFunctionSplitterPass());
+
   // Add passes that directly emit MI after all other MI passes.
   addPreEmitPass2();
 
   AddingMachinePasses = false;
+
+  if (MachineFunctionBarriers) {
+    // The verifier of the last machine pass runs between the barriers. There
+    // it is the only pass of its function pass manager, which therefore runs
+    // on -function-pass-threads threads.
+    Optional<std::string> VerifyBanner = std::move(Impl->DeferredVerifyBanner);
+    Impl->DeferredVerifyBanner = None;
+    addPass(createMachineFunctionBarrierPass(/*CreateFunctions=*/false));
+    if (VerifyBanner) {
+      PM->add(createMachineVerifierPass(*VerifyBanner));
+      addPass(createMachineFunctionBarrierPass(/*CreateFunctions=*/false));
+    }
+  }
 }
 
 /// Add passes that optimize machine instructions in SSA form.
@@ -0,0 +1,361 @@
+//===- FlatSummaryIndex.cpp - Mappable summary index ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the reader and writer of the flat summary index format.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/FlatSummaryIndex.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::flatsummary;
+
+static Error error(const Twine &Message) {
+  return make_error<StringError>("malformed flat summary index: " + Message,
+                                 inconvertibleErrorCode());
+}
+
+/// Point \p Table at \p Count entries of type T at \p Offset in \p Buffer.
+template <typename T>
+static Error getTable(StringRef Buffer, uint64_t Offset, uint64_t Count,
+                      ArrayRef<T> &Table, const char *Name) {
+  if (Offset > Buffer.size() || Count > (Buffer.size() - Offset) / sizeof(T))
+    return error(Twine(Name) + " table out of bounds");
+  Table = makeArrayRef(reinterpret_cast<const T *>(Buffer.data() + Offset),
+                       Count);
+  return Error::success();
+}
+
+static bool inBounds(const Range &R, size_t Size) {
+  return R.First <= Size && R.Size <= Size - R.First;
+}
+
+bool FlatSummaryIndex::isFlatSummaryIndex(StringRef Buffer) {
+  return Buffer.size() >= sizeof(Header) &&
+         reinterpret_cast<const Header *>(Buffer.data())->Magic == Magic;
+}
+
+Expected<FlatSummaryIndex> FlatSummaryIndex::create(MemoryBufferRef Buffer) {
+  StringRef Data = Buffer.getBuffer();
+  if (!isFlatSummaryIndex(Data))
+    return error("bad magic");
+
+  FlatSummaryIndex Index;
+  Index.Buffer = Data;
+  Index.Hdr = reinterpret_cast<const Header *>(Data.data());
+  const Header &H = *Index.Hdr;
+  if (H.Version != Version)
+    return error("unsupported version " + Twine(H.Version));
+
+  if (Error Err = getTable(Data, H.ModulesOffset, H.NumModules, Index.Modules,
+                           "module"))
+    return std::move(Err);
+  if (Error Err =
+          getTable(Data, H.ValuesOffset, H.NumValues, Index.Values, "value"))
+    return std::move(Err);
+  if (Error Err = getTable(Data, H.SummariesOffset, H.NumSummaries,
+                           Index.Summaries, "summary"))
+    return std::move(Err);
+  if (Error Err = getTable(Data, H.RefsOffset, H.NumRefs, Index.Refs, "ref"))
+    return std::move(Err);
+  if (Error Err =
+          getTable(Data, H.CallsOffset, H.NumCalls, Index.Calls, "call"))
+    return std::move(Err);
+  ArrayRef<char> Strings;
+  if (Error Err = getTable(Data, H.StringsOffset, H.StringsSize, Strings,
+                           "string"))
+    return std::move(Err);
+  Index.Strings = StringRef(Strings.data(), Strings.size());
+
+  for (const ModuleEntry &M : Index.Modules)
+    if (!inBounds(M.Path, Index.Strings.size()))
+      return error("module path out of bounds");
+  for (size_t I = 0, E = Index.Values.size(); I != E; ++I) {
+    if (I && Index.Values[I - 1].GUID >= Index.Values[I].GUID)
+      return error("values not sorted by GUID");
+    if (!inBounds(Index.Values[I].Summaries, Index.Summaries.size()))
+      return error("summary range out of bounds");
+  }
+  for (const SummaryEntry &S : Index.Summaries) {
+    if (S.Kind > GlobalValueSummary::GlobalVarKind ||
+        S.Linkage > GlobalValue::CommonLinkage ||
+        S.Module >= Index.Modules.size())
+      return error("invalid summary");
+    if (!inBounds(S.Refs, Index.Refs.size()) ||
+        !inBounds(S.Calls, Index.Calls.size()))
+      return error("edge range out of bounds");
+  }
+  // materialize() resolves an alias to the summary of its aliasee in the
+  // alias's own module.
+  for (const SummaryEntry &S : Index.Summaries) {
+    if (S.Kind != GlobalValueSummary::AliasKind)
+      continue;
+    ArrayRef<SummaryEntry> Aliasees = Index.findSummaries(S.AliaseeOrBodyHash);
+    if (none_of(Aliasees, [&](const SummaryEntry &A) {
+          return A.Module == S.Module;
+        }))
+      return error("unknown aliasee");
+  }
+  return std::move(Index);
+}
+
+ModuleHash FlatSummaryIndex::getModuleHash(const ModuleEntry &M) const {
+  ModuleHash Hash;
+  for (unsigned I = 0; I != 5; ++I)
+    Hash[I] = M.Hash[I];
+  return Hash;
+}
+
+ArrayRef<SummaryEntry>
+FlatSummaryIndex::findSummaries(GlobalValue::GUID GUID) const {
+  auto I = std::lower_bound(
+      Values.begin(), Values.end(), GUID,
+      [](const ValueEntry &V, GlobalValue::GUID G) { return V.GUID < G; });
+  if (I == Values.end() || I->GUID != GUID)
+    return None;
+  return summaries(*I);
+}
+
+void FlatSummaryIndex::materialize(ModuleSummaryIndex &Index) const {
+  if (withGlobalValueDeadStripping())
+    Index.setWithGlobalValueDeadStripping();
+  if (skipModuleByDistributedBackend())
+    Index.setSkipModuleByDistributedBackend();
+
+  // The summaries refer to their module by the path owned by the index.
+  std::vector<StringRef> ModulePaths;
+  ModulePaths.reserve(Modules.size());
+  for (const ModuleEntry &M : Modules)
+    ModulePaths.push_back(
+        Index.addModule(getModulePath(M), M.ModuleId, getModuleHash(M))
+            ->first());
+
+  std::vector<std::pair<AliasSummary *, const SummaryEntry *>> Aliases;
+  for (const ValueEntry &V : Values) {
+    ValueInfo VI = Index.getOrInsertValueInfo(GlobalValue::GUID(V.GUID));
+    for (const SummaryEntry &S : summaries(V)) {
+      GlobalValueSummary::GVFlags Flags(
+          GlobalValue::LinkageTypes(S.Linkage), S.Flags & 1, S.Flags & 2,
+          S.Flags & 4);
+      std::vector<ValueInfo> SummaryRefs;
+      for (uint64_t Ref : refs(S))
+        SummaryRefs.push_back(Index.getOrInsertValueInfo(Ref));
+
+      std::unique_ptr<GlobalValueSummary> Summary;
+      switch (GlobalValueSummary::SummaryKind(S.Kind)) {
+      case GlobalValueSummary::AliasKind: {
+        auto AS = llvm::make_unique<AliasSummary>(Flags);
+        AS->setAliaseeGUID(S.AliaseeOrBodyHash);
+        Aliases.push_back({AS.get(), &S});
+        Summary = std::move(AS);
+        break;
+      }
+      case GlobalValueSummary::FunctionKind: {
+        FunctionSummary::FFlags FunFlags;
+        FunFlags.ReadNone = S.FunctionFlags & 1;
+        FunFlags.ReadOnly = (S.FunctionFlags >> 1) & 1;
+        FunFlags.NoRecurse = (S.FunctionFlags >> 2) & 1;
+        FunFlags.ReturnDoesNotAlias = (S.FunctionFlags >> 3) & 1;
+        std::vector<FunctionSummary::EdgeTy> Edges;
+        for (const CallEntry &C : calls(S))
+          Edges.push_back(
+              {Index.getOrInsertValueInfo(GlobalValue::GUID(C.Callee)),
+               CalleeInfo(CalleeInfo::HotnessType(C.Info & 7), C.Info >> 3)});
+        auto FS = llvm::make_unique<FunctionSummary>(
+            Flags, S.InstCount, FunFlags, std::move(SummaryRefs),
+            std::move(Edges), std::vector<GlobalValue::GUID>(),
+            std::vector<FunctionSummary::VFuncId>(),
+            std::vector<FunctionSummary::VFuncId>(),
+            std::vector<FunctionSummary::ConstVCall>(),
+            std::vector<FunctionSummary::ConstVCall>());
+        FS->setBodyHash(S.AliaseeOrBodyHash);
+        Summary = std::move(FS);
+        break;
+      }
+      case GlobalValueSummary::GlobalVarKind:
+        Summary =
+            llvm::make_unique<GlobalVarSummary>(Flags, std::move(SummaryRefs));
+        break;
+      }
+      Summary->setModulePath(ModulePaths[S.Module]);
+      Summary->setOriginalName(S.OriginalName);
+      Index.addGlobalValueSummary(VI, std::move(Summary));
+    }
+  }
+
+  // Aliasees can only be resolved once all summaries are in the index.
+  for (auto &A : Aliases)
+    A.first->setAliasee(Index.findSummaryInModule(
+        A.second->AliaseeOrBodyHash, ModulePaths[A.second->Module]));
+}
+
+namespace {
+
+/// Lays out the tables of the flat format.
+class FlatSummaryIndexWriter {
+  const ModuleSummaryIndex &Index;
+  std::vector<ModuleEntry> Modules;
+  std::vector<ValueEntry> Values;
+  std::vector<SummaryEntry> Summaries;
+  std::vector<ulittle64_t> Refs;
+  std::vector<CallEntry> Calls;
+  std::string Strings;
+  StringMap<uint32_t> ModuleIndices;
+
+  static Range makeRange(size_t First, size_t End) {
+    Range R;
+    R.First = First;
+    R.Size = End - First;
+    return R;
+  }
+
+  Error addSummary(const GlobalValueSummary &GVS);
+
+public:
+  FlatSummaryIndexWriter(const ModuleSummaryIndex &Index) : Index(Index) {}
+
+  Error write(raw_ostream &OS);
+};
+
+} // end anonymous namespace
+
+Error FlatSummaryIndexWriter::addSummary(const GlobalValueSummary &GVS) {
+  SummaryEntry S;
+  memset(&S, 0, sizeof(S));
+  S.Kind = GVS.getSummaryKind();
+  S.Linkage = GVS.linkage();
+  S.Flags = GVS.notEligibleToImport() | GVS.isLive() << 1 |
+            GVS.isDSOLocal() << 2;
+  auto ModuleI = ModuleIndices.find(GVS.modulePath());
+  if (ModuleI == ModuleIndices.end())
+    return make_error<StringError>("summary for unknown module '" +
+                                       GVS.modulePath() + "'",
+                                   inconvertibleErrorCode());
+  S.Module = ModuleI->second;
+  S.OriginalName = GVS.getOriginalName();
+
+  size_t FirstRef = Refs.size();
+  for (ValueInfo VI : GVS.refs())
+    Refs.emplace_back(VI.getGUID());
+  S.Refs = makeRange(FirstRef, Refs.size());
+
+  size_t FirstCall = Calls.size();
+  if (auto *AS = dyn_cast<AliasSummary>(&GVS)) {
+    S.AliaseeOrBodyHash = AS->getAliaseeGUID();
+  } else if (auto *FS = dyn_cast<FunctionSummary>(&GVS)) {
+    if (FS->getTypeIdInfo())
+      return make_error<StringError>(
+          "type identifier information cannot be encoded in a flat summary "
+          "index",
+          inconvertibleErrorCode());
+    FunctionSummary::FFlags FunFlags = FS->fflags();
+    S.FunctionFlags = FunFlags.ReadNone | FunFlags.ReadOnly << 1 |
+                      FunFlags.NoRecurse << 2 |
+                      FunFlags.ReturnDoesNotAlias << 3;
+    S.InstCount = FS->instCount();
+    S.AliaseeOrBodyHash = FS->getBodyHash();
+    for (const FunctionSummary::EdgeTy &Edge : FS->calls()) {
+      CallEntry C;
+      C.Callee = Edge.first.getGUID();
+      C.Info = Edge.second.Hotness | Edge.second.RelBlockFreq << 3;
+      C.Reserved = 0;
+      Calls.push_back(C);
+    }
+  }
+  S.Calls = makeRange(FirstCall, Calls.size());
+  Summaries.push_back(S);
+  return Error::success();
+}
+
+Error FlatSummaryIndexWriter::write(raw_ostream &OS) {
+  if (!Index.typeIds().empty() || !Index.cfiFunctionDefs().empty() ||
+      !Index.cfiFunctionDecls().empty())
+    return make_error<StringError>(
+        "type identifier summaries and CFI functions cannot be encoded in a "
+        "flat summary index",
+        inconvertibleErrorCode());
+
+  // Number the modules in the order of their IDs, so that the output does not
+  // depend on the iteration order of the StringMap.
+  std::vector<const ModuleSummaryIndex::ModuleInfo *> ModuleInfos;
+  for (const auto &MI : Index.modulePaths())
+    ModuleInfos.push_back(&MI);
+  llvm::sort(ModuleInfos.begin(), ModuleInfos.end(),
+             [](const ModuleSummaryIndex::ModuleInfo *A,
+                const ModuleSummaryIndex::ModuleInfo *B) {
+               return std::make_pair(A->second.first, A->first()) <
+                      std::make_pair(B->second.first, B->first());
+             });
+  for (const ModuleSummaryIndex::ModuleInfo *MI : ModuleInfos) {
+    ModuleEntry M;
+    M.Path = makeRange(Strings.size(), Strings.size() + MI->first().size());
+    Strings += MI->first();
+    M.ModuleId = MI->second.first;
+    for (unsigned I = 0; I != 5; ++I)
+      M.Hash[I] = MI->second.second[I];
+    M.Reserved = 0;
+    ModuleIndices[MI->first()] = Modules.size();
+    Modules.push_back(M);
+  }
+
+  // The index is a std::map, so the values come out sorted by GUID.
+  for (const auto &GlobalList : Index) {
+    ValueEntry V;
+    V.GUID = GlobalList.first;
+    size_t FirstSummary = Summaries.size();
+    for (const auto &Summary : GlobalList.second.SummaryList)
+      if (Error Err = addSummary(*Summary))
+        return Err;
+    V.Summaries = makeRange(FirstSummary, Summaries.size());
+    Values.push_back(V);
+  }
+
+  Header H;
+  memset(&H, 0, sizeof(H));
+  H.Magic = Magic;
+  H.Version = Version;
+  H.Flags = Index.withGlobalValueDeadStripping() |
+            Index.skipModuleByDistributedBackend() << 1;
+  uint64_t Offset = sizeof(Header);
+  auto Place = [&](ulittle64_t &TableOffset, ulittle64_t &TableSize,
+                   size_t Count, size_t EntrySize) {
+    TableOffset = Offset;
+    TableSize = Count;
+    Offset += Count * EntrySize;
+  };
+  Place(H.ModulesOffset, H.NumModules, Modules.size(), sizeof(ModuleEntry));
+  Place(H.ValuesOffset, H.NumValues, Values.size(), sizeof(ValueEntry));
+  Place(H.SummariesOffset, H.NumSummaries, Summaries.size(),
+        sizeof(SummaryEntry));
+  Place(H.RefsOffset, H.NumRefs, Refs.size(), sizeof(ulittle64_t));
+  Place(H.CallsOffset, H.NumCalls, Calls.size(), sizeof(CallEntry));
+  Place(H.StringsOffset, H.StringsSize, Strings.size(), 1);
+
+  auto WriteTable = [&](const void *Data, size_t Size) {
+    OS.write(reinterpret_cast<const char *>(Data), Size);
+  };
+  WriteTable(&H, sizeof(H));
+  WriteTable(Modules.data(), Modules.size() * sizeof(ModuleEntry));
+  WriteTable(Values.data(), Values.size() * sizeof(ValueEntry));
+  WriteTable(Summaries.data(), Summaries.size() * sizeof(SummaryEntry));
+  WriteTable(Refs.data(), Refs.size() * sizeof(ulittle64_t));
+  WriteTable(Calls.data(), Calls.size() * sizeof(CallEntry));
+  OS << Strings;
+  return Error::success();
+}
+
+Error llvm::writeFlatSummaryIndex(const ModuleSummaryIndex &Index,
+                                  raw_ostream &OS) {
+  return FlatSummaryIndexWriter(Index).write(OS);
+}
@@ -0,0 +1,153 @@
+//===- IRMemoryUsage.cpp - Measure IR memory footprint --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the measurement of the memory taken by instructions
+// and their operand lists, and the release of unused operand space.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/IRMemoryUsage.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "ir-memory-usage"
+
+STATISTIC(NumOperandListsCompacted, "Number of operand lists shrunk");
+STATISTIC(NumOperandBytesReleased, "Number of operand list bytes released");
+
+static uint64_t getInstructionSize(const Instruction &I) {
+  switch (I.getOpcode()) {
+#define HANDLE_INST(N, OPC, CLASS)                                             \
+  case Instruction::OPC:                                                       \
+    return sizeof(CLASS);
+#include "llvm/IR/Instruction.def"
+  }
+  llvm_unreachable("Unknown instruction opcode");
+}
+
+static uint64_t getNameSize(const Value &V) {
+  if (!V.hasName())
+    return 0;
+  return sizeof(ValueName) + V.getName().size() + 1;
+}
+
+/// Return the number of operand slots allocated for \p I.
+static unsigned getNumAllocatedOperands(const Instruction &I) {
+  if (auto *PN = dyn_cast<PHINode>(&I))
+    return PN->getNumReservedOperands();
+  if (auto *SI = dyn_cast<SwitchInst>(&I))
+    return SI->getNumReservedOperands();
+  // The other instructions with growable operand lists do not track their
+  // reserved space publicly; they are rare enough not to matter.
+  return I.getNumOperands();
+}
+
+/// Return the bytes of the operand list of \p I holding \p N operands.
+static uint64_t getOperandListSize(const Instruction &I, unsigned N) {
+  switch (I.getOpcode()) {
+  case Instruction::PHI:
+    // The Uses are followed by a tagged pointer to the PHI node and by the
+    // incoming blocks, and the PHI node is preceded by a pointer to the Uses.
+    return N * (sizeof(Use) + sizeof(BasicBlock *)) + 2 * sizeof(void *);
+  case Instruction::Switch:
+  case Instruction::IndirectBr:
+  case Instruction::LandingPad:
+  case Instruction::CatchSwitch:
+    return N * sizeof(Use) + 2 * sizeof(void *);
+  default:
+    break;
+  }
+
+  uint64_t Size = N * sizeof(Use);
+  ImmutableCallSite CS(&I);
+  if (CS && CS.hasOperandBundles())
+    Size += I.getDescriptor().size() + sizeof(intptr_t);
+  return Size;
+}
+
+void IRMemoryUsage::addFunction(const Function &F) {
+  ++NumFunctions;
+  for (const Argument &A : F.args())
+    NameBytes += getNameSize(A);
+  for (const BasicBlock &BB : F) {
+    NameBytes += getNameSize(BB);
+    for (const Instruction &I : BB) {
+      unsigned NumOps = I.getNumOperands();
+      unsigned NumAllocated = getNumAllocatedOperands(I);
+      uint64_t Size = getOperandListSize(I, NumAllocated);
+
+      ++NumInstructions;
+      NumOperands += NumOps;
+      NumReservedOperands += NumAllocated - NumOps;
+      InstructionBytes += getInstructionSize(I);
+      OperandBytes += Size;
+      ReservedOperandBytes += Size - getOperandListSize(I, NumOps);
+      NameBytes += getNameSize(I);
+    }
+  }
+}
+
+void IRMemoryUsage::print(raw_ostream &OS) const {
+  OS << "IR memory usage:\n";
+  OS << "  functions:         " << NumFunctions << "\n";
+  OS << "  instructions:      " << NumInstructions << "\n";
+  OS << "  operands:          " << NumOperands << " (" << NumReservedOperands
+     << " reserved)\n";
+  OS << "  instruction bytes: " << InstructionBytes << "\n";
+  OS << "  operand bytes:     " << OperandBytes << " (" << ReservedOperandBytes
+     << " reserved)\n";
+  OS << "  name bytes:        " << NameBytes << "\n";
+  OS << "  total bytes:       " << getTotalBytes() << "\n";
+  if (NumInstructions)
+    OS << "  bytes/instruction: "
+       << format("%.1f", double(getTotalBytes()) / NumInstructions) << "\n";
+}
+
+IRMemoryUsage llvm::measureIRMemoryUsage(const Module &M) {
+  IRMemoryUsage Usage;
+  for (const Function &F : M)
+    if (!F.isDeclaration())
+      Usage.addFunction(F);
+  return Usage;
+}
+
+uint64_t llvm::compactOperandLists(Function &F) {
+  uint64_t Released = 0;
+  for (BasicBlock &BB : F) {
+    for (Instruction &I : BB) {
+      unsigned NumAllocated = getNumAllocatedOperands(I);
+      unsigned NumOps = I.getNumOperands();
+      if (NumAllocated == NumOps)
+        continue;
+      if (auto *PN = dyn_cast<PHINode>(&I))
+        PN->shrinkToFit();
+      else
+        cast<SwitchInst>(I).shrinkToFit();
+      ++NumOperandListsCompacted;
+      Released += getOperandListSize(I, NumAllocated) -
+                  getOperandListSize(I, NumOps);
+    }
+  }
+  NumOperandBytesReleased += Released;
+  return Released;
+}
+
+uint64_t llvm::compactOperandLists(Module &M) {
+  uint64_t Released = 0;
+  for (Function &F : M)
+    Released += compactOperandLists(F);
+  return Released;
+}
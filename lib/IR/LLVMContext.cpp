@@ -332,6 +332,22 @@ void LLVMContext::setDiscardValueNames(bool Discard) {
   pImpl->DiscardValueNames = Discard;
 }
 
+bool LLVMContext::shouldDiscardPrivateGlobalNames() const {
+  return pImpl->DiscardPrivateGlobalNames;
+}
+
+void LLVMContext::setDiscardPrivateGlobalNames(bool Discard) {
+  pImpl->DiscardPrivateGlobalNames = Discard;
+}
+
+bool LLVMContext::hasPerNameUniqueSuffixes() const {
+  return pImpl->PerNameUniqueSuffixes;
+}
+
+void LLVMContext::setPerNameUniqueSuffixes(bool Enable) {
+  pImpl->PerNameUniqueSuffixes = Enable;
+}
+
 OptPassGate &LLVMContext::getOptPassGate() const {
   return pImpl->getOptPassGate();
 }
@@ -1376,6 +1376,12 @@ public:
   /// not.
   bool DiscardValueNames = false;
 
+  /// Flag to indicate if private GlobalValues retain their name or not.
+  bool DiscardPrivateGlobalNames = false;
+
+  /// Flag to indicate if symbol tables keep a suffix counter per base name.
+  bool PerNameUniqueSuffixes = false;
+
   LLVMContextImpl(LLVMContext &C);
   ~LLVMContextImpl();
 
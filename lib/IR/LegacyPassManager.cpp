@@ -27,6 +27,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -50,6 +51,11 @@ enum PassDebugLevel {
 };
 }
 
+static cl::opt<unsigned> FunctionPassThreads(
+    "function-pass-threads", cl::init(1), cl::Hidden,
+    cl::desc("Run function pass managers whose passes allow it on this many "
+             "functions at once"));
+
 static cl::opt<enum PassDebugLevel>
 PassDebugging("debug-pass", cl::Hidden,
                   cl::desc("Print PassManager debugging information"),
@@ -1600,7 +1606,84 @@ bool FPPassManager::runOnFunction(Function &F) {
   return Changed;
 }
 
+bool FPPassManager::canRunInParallel(Module &M) {
+  // Per-function timers, debug output and size remarks are not thread-safe.
+  if (FunctionPassThreads <= 1 || TimePassesIsEnabled ||
+      isPassDebuggingExecutionsOrMore() ||
+      M.getContext().getDiagHandlerPtr()->isAnalysisRemarkEnabled("size-info"))
+    return false;
+
+  for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
+    FunctionPass *FP = getContainedPass(Index);
+    if (!FP->isFunctionParallelSafe())
+      return false;
+    // Immutable analyses are shared by all threads; any other one would be
+    // computed for one function while the others run.
+    AnalysisUsage *AnUsage = TPM->findAnalysisUsage(FP);
+    for (const AnalysisUsage::VectorType *IDs :
+         {&AnUsage->getRequiredSet(), &AnUsage->getRequiredTransitiveSet()})
+      for (AnalysisID ID : *IDs) {
+        Pass *AP = TPM->findAnalysisPass(ID);
+        if (!AP || !AP->getAsImmutablePass())
+          return false;
+      }
+  }
+  return true;
+}
+
+bool FPPassManager::runInParallel(Module &M) {
+  std::vector<Function *> Functions;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      Functions.push_back(&F);
+  if (Functions.empty())
+    return false;
+
+  // Resolve the analyses of every pass up front; the threads only read them.
+  populateInheritedAnalysis(TPM->activeStack);
+  for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
+    FunctionPass *FP = getContainedPass(Index);
+    initializeAnalysisImpl(FP);
+    FP->beginParallelRun(M);
+  }
+
+  // Each thread runs the passes on a contiguous range of functions, in order.
+  size_t RangeSize =
+      (Functions.size() + FunctionPassThreads - 1) / FunctionPassThreads;
+  size_t NumRanges = (Functions.size() + RangeSize - 1) / RangeSize;
+  std::vector<char> RangeChanged(NumRanges, false);
+  {
+    ThreadPool Pool(NumRanges);
+    for (size_t I = 0; I != NumRanges; ++I) {
+      size_t Begin = I * RangeSize;
+      ArrayRef<Function *> Range = makeArrayRef(Functions).slice(
+          Begin, std::min(RangeSize, Functions.size() - Begin));
+      Pool.async([this, Range, &RangeChanged, I] {
+        for (Function *F : Range)
+          for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
+            FunctionPass *FP = getContainedPass(Index);
+            PassManagerPrettyStackEntry X(FP, *F);
+            if (FP->runOnFunction(*F))
+              RangeChanged[I] = true;
+          }
+      });
+    }
+  }
+
+  for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
+    FunctionPass *FP = getContainedPass(Index);
+    FP->endParallelRun(M);
+    removeNotPreservedAnalysis(FP);
+    recordAvailableAnalysis(FP);
+    removeDeadPasses(FP, M.getModuleIdentifier(), ON_MODULE_MSG);
+  }
+  return is_contained(RangeChanged, true);
+}
+
 bool FPPassManager::runOnModule(Module &M) {
+  if (canRunInParallel(M))
+    return runInParallel(M);
+
   bool Changed = false;
 
   for (Function &F : M)
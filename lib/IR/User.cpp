@@ -83,6 +83,31 @@ void User::growHungoffUses(unsigned NewNumUses, bool IsPhi) {
   Use::zap(OldOps, OldOps + OldNumUses, true);
 }
 
+void User::shrinkHungoffUses(unsigned Reserved, bool IsPhi) {
+  assert(HasHungOffUses && "realloc must have hung off uses");
+
+  unsigned NumUses = getNumOperands();
+  assert(NumUses <= Reserved && "uses beyond the reserved space");
+  if (NumUses == Reserved)
+    return;
+
+  Use *OldOps = getOperandList();
+  allocHungoffUses(NumUses, IsPhi);
+  Use *NewOps = getOperandList();
+  std::copy(OldOps, OldOps + NumUses, NewOps);
+
+  // The BB pointers of a Phi follow the whole old allocation.
+  if (IsPhi) {
+    auto *OldPtr =
+        reinterpret_cast<char *>(OldOps + Reserved) + sizeof(Use::UserRef);
+    auto *NewPtr =
+        reinterpret_cast<char *>(NewOps + NumUses) + sizeof(Use::UserRef);
+    std::copy(OldPtr, OldPtr + (NumUses * sizeof(BasicBlock *)), NewPtr);
+  }
+  // The Uses past NumUses are unused and hold no value.
+  Use::zap(OldOps, OldOps + NumUses, true);
+}
+
 
 // This is a private struct used by `User` to track the co-allocated descriptor
 // section.
@@ -244,6 +244,12 @@ void Value::setNameImpl(const Twine &NewName) {
   assert(NameRef.find_first_of(0) == StringRef::npos &&
          "Null bytes are not allowed in names");
 
+  // Private globals can drop their name too, unless it has a meaning.
+  if (getContext().shouldDiscardPrivateGlobalNames() &&
+      isa<GlobalValue>(this) && cast<GlobalValue>(this)->hasPrivateLinkage() &&
+      !NameRef.startswith("llvm."))
+    NameRef = StringRef();
+
   // Name isn't changing?
   if (getName() == NameRef)
     return;
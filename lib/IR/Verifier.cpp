@@ -95,6 +95,7 @@
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Statepoint.h"
 #include "llvm/IR/Type.h"
+#include "llvm/IR/TypeFinder.h"
 #include "llvm/IR/Use.h"
 #include "llvm/IR/User.h"
 #include "llvm/IR/Value.h"
@@ -105,12 +106,16 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 
 using namespace llvm;
@@ -248,6 +253,11 @@ public:
 
 } // namespace llvm
 
+static cl::opt<unsigned>
+    VerifyThreads("verify-threads", cl::init(1), cl::Hidden,
+                  cl::desc("Verify the functions of a module on this many "
+                           "threads"));
+
 namespace {
 
 class Verifier : public InstVisitor<Verifier>, VerifierSupport {
@@ -306,6 +316,10 @@ class Verifier : public InstVisitor<Verifier>, VerifierSupport {
 
   TBAAVerifier TBAAVerifyHelper;
 
+  /// Whether the check that each DISubprogram is attached to a single
+  /// function is left to the verifier that merges the results of this one.
+  bool DeferSubprogramAttachmentChecks = false;
+
   void checkAtomicMemAccessSize(Type *Ty, const Instruction *I);
 
 public:
@@ -318,6 +332,35 @@ public:
 
   bool hasBrokenDebugInfo() const { return BrokenDebugInfo; }
 
+  /// Prepare this verifier to verify functions concurrently with other
+  /// verifiers of the same module. Their results are combined with
+  /// mergeFunctionResults() and verifySubprogramAttachment().
+  void setVerifyingInParallel() { DeferSubprogramAttachmentChecks = true; }
+
+  /// Merge the state that the module checks need from the functions \p Other
+  /// verified.
+  void mergeFunctionResults(const Verifier &Other) {
+    BrokenDebugInfo |= Other.BrokenDebugInfo;
+    CUVisited.insert(Other.CUVisited.begin(), Other.CUVisited.end());
+    for (const auto &Counts : Other.FrameEscapeInfo) {
+      auto &Entry = FrameEscapeInfo[Counts.first];
+      Entry.first = std::max(Entry.first, Counts.second.first);
+      Entry.second = std::max(Entry.second, Counts.second.second);
+    }
+  }
+
+  /// Check that \p SP is not attached to a function other than \p F.
+  bool verifySubprogramAttachment(const Function &F, const DISubprogram &SP) {
+    const Function *&AttachedTo = DISubprogramAttachments[&SP];
+    if (AttachedTo && AttachedTo != &F) {
+      DebugInfoCheckFailed("DISubprogram attached to more than one function",
+                           &SP, &F);
+      return false;
+    }
+    AttachedTo = &F;
+    return true;
+  }
+
   bool verify(const Function &F) {
     assert(F.getParent() == &M &&
            "An instance of this class only works with a specific module!");
@@ -1578,10 +1621,22 @@ void Verifier::verifyParameterAttrs(AttributeSet Attrs, Type *Ty,
          V);
 
   AttrBuilder IncompatibleAttrs = AttributeFuncs::typeIncompatible(Ty);
-  Assert(!AttrBuilder(Attrs).overlaps(IncompatibleAttrs),
-         "Wrong types for attribute: " +
-             AttributeSet::get(Context, IncompatibleAttrs).getAsString(),
-         V);
+  if (AttrBuilder(Attrs).overlaps(IncompatibleAttrs)) {
+    // Name the offending attributes of Attrs rather than building an
+    // attribute set, which would be uniqued in the context that other threads
+    // read from when functions are verified in parallel.
+    std::string Names;
+    for (Attribute A : Attrs) {
+      if (A.isStringAttribute() ||
+          !IncompatibleAttrs.contains(A.getKindAsEnum()))
+        continue;
+      if (!Names.empty())
+        Names += ' ';
+      Names += A.getAsString();
+    }
+    CheckFailed("Wrong types for attribute: " + Names, V);
+    return;
+  }
 
   if (PointerType *PTy = dyn_cast<PointerType>(Ty)) {
     SmallPtrSet<Type*, 4> Visited;
@@ -2212,10 +2267,9 @@ void Verifier::visitFunction(const Function &F) {
         AssertDI(isa<DISubprogram>(I.second),
                  "function !dbg attachment must be a subprogram", &F, I.second);
         auto *SP = cast<DISubprogram>(I.second);
-        const Function *&AttachedTo = DISubprogramAttachments[SP];
-        AssertDI(!AttachedTo || AttachedTo == &F,
-                 "DISubprogram attached to more than one function", SP, &F);
-        AttachedTo = &F;
+        if (!DeferSubprogramAttachmentChecks &&
+            !verifySubprogramAttachment(F, *SP))
+          return;
         break;
       }
       case LLVMContext::MD_prof:
@@ -4677,14 +4731,104 @@ bool llvm::verifyFunction(const Function &f, raw_ostream *OS) {
   return !V.verify(F);
 }
 
+/// Create the types and constants that verifying the functions of \p M asks
+/// LLVMContext for, so that verifiers running concurrently only look them up.
+/// Also settle which struct types are sized, since StructType::isSized caches
+/// its answer in the type.
+static void prepareForParallelVerification(const Module &M) {
+  ConstantTokenNone::get(M.getContext());
+
+  TypeFinder StructTypes;
+  StructTypes.run(M, /*onlyNamed=*/false);
+  for (StructType *STy : StructTypes)
+    STy->isSized();
+
+  // Matching an intrinsic declaration against its description derives types
+  // from the overloaded ones.
+  for (const Function &F : M) {
+    Intrinsic::ID ID = F.getIntrinsicID();
+    if (ID == Intrinsic::not_intrinsic)
+      continue;
+    SmallVector<Intrinsic::IITDescriptor, 8> Table;
+    getIntrinsicInfoTableEntries(ID, Table);
+    ArrayRef<Intrinsic::IITDescriptor> TableRef = Table;
+    SmallVector<Type *, 4> ArgTys;
+    FunctionType *FTy = F.getFunctionType();
+    if (Intrinsic::matchIntrinsicType(FTy->getReturnType(), TableRef, ArgTys))
+      continue;
+    for (Type *ParamTy : FTy->params())
+      if (Intrinsic::matchIntrinsicType(ParamTy, TableRef, ArgTys))
+        break;
+  }
+}
+
+/// Verify the functions of \p M on \p NumThreads threads and merge the
+/// results into \p V. Each thread verifies a contiguous range of functions
+/// with its own verifier, and the diagnostics are printed in function order.
+static bool verifyFunctionsInParallel(Verifier &V, const Module &M,
+                                      raw_ostream *OS,
+                                      bool TreatBrokenDebugInfoAsError,
+                                      unsigned NumThreads) {
+  prepareForParallelVerification(M);
+
+  std::vector<const Function *> Functions;
+  for (const Function &F : M)
+    Functions.push_back(&F);
+
+  struct Range {
+    ArrayRef<const Function *> Functions;
+    std::string Diagnostics;
+    std::unique_ptr<raw_string_ostream> OS;
+    std::unique_ptr<Verifier> V;
+    bool Broken = false;
+  };
+  size_t RangeSize = (Functions.size() + NumThreads - 1) / NumThreads;
+  std::vector<Range> Ranges((Functions.size() + RangeSize - 1) / RangeSize);
+  {
+    ThreadPool Pool(Ranges.size());
+    for (size_t I = 0; I != Ranges.size(); ++I) {
+      Range &R = Ranges[I];
+      size_t Begin = I * RangeSize;
+      R.Functions = makeArrayRef(Functions).slice(
+          Begin, std::min(RangeSize, Functions.size() - Begin));
+      if (OS)
+        R.OS = llvm::make_unique<raw_string_ostream>(R.Diagnostics);
+      R.V = llvm::make_unique<Verifier>(R.OS.get(),
+                                        TreatBrokenDebugInfoAsError, M);
+      R.V->setVerifyingInParallel();
+      Pool.async([&R] {
+        for (const Function *F : R.Functions)
+          R.Broken |= !R.V->verify(*F);
+      });
+    }
+  }
+
+  bool Broken = false;
+  for (Range &R : Ranges) {
+    if (OS)
+      *OS << R.OS->str();
+    Broken |= R.Broken;
+    V.mergeFunctionResults(*R.V);
+  }
+  for (const Function *F : Functions)
+    if (const DISubprogram *SP = F->getSubprogram())
+      if (!V.verifySubprogramAttachment(*F, *SP))
+        Broken |= TreatBrokenDebugInfoAsError;
+  return Broken;
+}
+
 bool llvm::verifyModule(const Module &M, raw_ostream *OS,
                         bool *BrokenDebugInfo) {
   // Don't use a raw_null_ostream.  Printing IR is expensive.
   Verifier V(OS, /*ShouldTreatBrokenDebugInfoAsError=*/!BrokenDebugInfo, M);
 
   bool Broken = false;
-  for (const Function &F : M)
-    Broken |= !V.verify(F);
+  if (VerifyThreads > 1 && M.size() > 1)
+    Broken = verifyFunctionsInParallel(V, M, OS, !BrokenDebugInfo,
+                                       VerifyThreads);
+  else
+    for (const Function &F : M)
+      Broken |= !V.verify(F);
 
   Broken |= !V.verify();
   if (BrokenDebugInfo)
@@ -4702,6 +4846,24 @@ struct VerifierLegacyPass : public FunctionPass {
   std::unique_ptr<Verifier> V;
   bool FatalErrors = true;
 
+  /// During a parallel run, each thread verifies functions with its own
+  /// verifier, and the diagnostics of broken functions are kept until the end
+  /// of the run to be printed in function order.
+  struct ThreadVerifier {
+    std::string Diagnostics;
+    raw_string_ostream OS{Diagnostics};
+    Verifier V;
+
+    explicit ThreadVerifier(const Module &M)
+        : V(&OS, /*ShouldTreatBrokenDebugInfoAsError=*/false, M) {
+      V.setVerifyingInParallel();
+    }
+  };
+  bool InParallelRun = false;
+  sys::Mutex ParallelLock;
+  std::map<std::thread::id, std::unique_ptr<ThreadVerifier>> ThreadVerifiers;
+  DenseMap<const Function *, std::string> BrokenFunctions;
+
   VerifierLegacyPass() : FunctionPass(ID) {
     initializeVerifierLegacyPassPass(*PassRegistry::getPassRegistry());
   }
@@ -4718,12 +4880,59 @@ struct VerifierLegacyPass : public FunctionPass {
   }
 
   bool runOnFunction(Function &F) override {
+    if (InParallelRun) {
+      verifyInParallel(F);
+      return false;
+    }
     if (!V->verify(F) && FatalErrors)
       report_fatal_error("Broken function found, compilation aborted!");
 
     return false;
   }
 
+  bool isFunctionParallelSafe() const override { return true; }
+
+  void beginParallelRun(Module &M) override {
+    prepareForParallelVerification(M);
+    InParallelRun = true;
+  }
+
+  void verifyInParallel(const Function &F) {
+    ThreadVerifier *TV;
+    {
+      sys::ScopedLock Lock(ParallelLock);
+      auto &Slot = ThreadVerifiers[std::this_thread::get_id()];
+      if (!Slot)
+        Slot = llvm::make_unique<ThreadVerifier>(*F.getParent());
+      TV = Slot.get();
+    }
+    if (TV->V.verify(F))
+      return;
+    std::string Diagnostics = std::move(TV->OS.str());
+    TV->Diagnostics.clear();
+    sys::ScopedLock Lock(ParallelLock);
+    BrokenFunctions[&F] = std::move(Diagnostics);
+  }
+
+  void endParallelRun(Module &M) override {
+    InParallelRun = false;
+    for (auto &Entry : ThreadVerifiers)
+      V->mergeFunctionResults(Entry.second->V);
+    ThreadVerifiers.clear();
+
+    for (Function &F : M) {
+      auto It = BrokenFunctions.find(&F);
+      if (It != BrokenFunctions.end()) {
+        dbgs() << It->second;
+        if (FatalErrors)
+          report_fatal_error("Broken function found, compilation aborted!");
+      }
+      if (const DISubprogram *SP = F.getSubprogram())
+        V->verifySubprogramAttachment(F, *SP);
+    }
+    BrokenFunctions.clear();
+  }
+
   bool doFinalization(Module &M) override {
     bool HasErrors = false;
     for (Function &F : M)
@@ -28,9 +28,11 @@
 #include "llvm/Linker/IRMover.h"
 #include "llvm/Object/IRObjectFile.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
@@ -149,10 +151,30 @@ static void computeCacheKey(
 
   // Include the hash for every module we import functions from. The set of
   // imported symbols for each module may affect code generation and is
-  // sensitive to link order, so include that as well.
+  // sensitive to link order, so include that as well. If the summaries of all
+  // the functions imported from a module carry body hashes, those are used
+  // instead of the module hash, so that changes to other functions in that
+  // module do not invalidate this entry.
   for (auto &Entry : ImportList) {
-    auto ModHash = Index.getModuleHash(Entry.first());
-    Hasher.update(ArrayRef<uint8_t>((uint8_t *)&ModHash[0], sizeof(ModHash)));
+    SmallVector<uint64_t, 16> BodyHashes;
+    for (auto &Fn : Entry.second) {
+      auto *FS = dyn_cast_or_null<FunctionSummary>(
+          Index.findSummaryInModule(Fn, Entry.first()));
+      if (!FS || !FS->getBodyHash()) {
+        BodyHashes.clear();
+        break;
+      }
+      BodyHashes.push_back(FS->getBodyHash());
+    }
+    AddUnsigned(!BodyHashes.empty());
+    if (!BodyHashes.empty()) {
+      for (uint64_t BodyHash : BodyHashes)
+        AddUint64(BodyHash);
+    } else {
+      auto ModHash = Index.getModuleHash(Entry.first());
+      Hasher.update(
+          ArrayRef<uint8_t>((uint8_t *)&ModHash[0], sizeof(ModHash)));
+    }
 
     AddUint64(Entry.second.size());
     for (auto &Fn : Entry.second)
@@ -905,26 +927,15 @@ public:
 };
 
 namespace {
-class InProcessThinBackend : public ThinBackendProc {
-  ThreadPool BackendThreadPool;
-  AddStreamFn AddStream;
-  NativeObjectCache Cache;
+/// The parts of a backend job's cache key that are derived from the combined
+/// index as a whole. They are computed once and shared by all jobs.
+class ThinBackendCacheKeyInfo {
   TypeIdSummariesByGuidTy TypeIdSummariesByGuid;
   std::set<GlobalValue::GUID> CfiFunctionDefs;
   std::set<GlobalValue::GUID> CfiFunctionDecls;
 
-  Optional<Error> Err;
-  std::mutex ErrMu;
-
 public:
-  InProcessThinBackend(
-      Config &Conf, ModuleSummaryIndex &CombinedIndex,
-      unsigned ThinLTOParallelismLevel,
-      const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
-      AddStreamFn AddStream, NativeObjectCache Cache)
-      : ThinBackendProc(Conf, CombinedIndex, ModuleToDefinedGVSummaries),
-        BackendThreadPool(ThinLTOParallelismLevel),
-        AddStream(std::move(AddStream)), Cache(std::move(Cache)) {
+  ThinBackendCacheKeyInfo(const ModuleSummaryIndex &CombinedIndex) {
     // Create a mapping from type identifier GUIDs to type identifier summaries.
     // This allows backends to use the type identifier GUIDs stored in the
     // function summaries to determine which type identifier summaries affect
@@ -939,6 +950,47 @@ public:
           GlobalValue::getGUID(GlobalValue::dropLLVMManglingEscape(Name)));
   }
 
+  /// Compute the cache key of the backend job for \p ModuleID into \p Key.
+  /// Returns false if the job cannot be cached, because the module has no
+  /// entry or no hash in the combined index.
+  bool computeKey(
+      SmallString<40> &Key, const Config &Conf,
+      const ModuleSummaryIndex &CombinedIndex, StringRef ModuleID,
+      const FunctionImporter::ImportMapTy &ImportList,
+      const FunctionImporter::ExportSetTy &ExportList,
+      const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> &ResolvedODR,
+      const GVSummaryMapTy &DefinedGlobals) const {
+    if (!CombinedIndex.modulePaths().count(ModuleID) ||
+        all_of(CombinedIndex.getModuleHash(ModuleID),
+               [](uint32_t V) { return V == 0; }))
+      return false;
+    computeCacheKey(Key, Conf, CombinedIndex, ModuleID, ImportList, ExportList,
+                    ResolvedODR, DefinedGlobals, TypeIdSummariesByGuid,
+                    CfiFunctionDefs, CfiFunctionDecls);
+    return true;
+  }
+};
+
+class InProcessThinBackend : public ThinBackendProc {
+  ThreadPool BackendThreadPool;
+  AddStreamFn AddStream;
+  NativeObjectCache Cache;
+  ThinBackendCacheKeyInfo CacheKeyInfo;
+
+  Optional<Error> Err;
+  std::mutex ErrMu;
+
+public:
+  InProcessThinBackend(
+      Config &Conf, ModuleSummaryIndex &CombinedIndex,
+      unsigned ThinLTOParallelismLevel,
+      const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+      AddStreamFn AddStream, NativeObjectCache Cache)
+      : ThinBackendProc(Conf, CombinedIndex, ModuleToDefinedGVSummaries),
+        BackendThreadPool(ThinLTOParallelismLevel),
+        AddStream(std::move(AddStream)), Cache(std::move(Cache)),
+        CacheKeyInfo(CombinedIndex) {}
+
   Error runThinLTOBackendThread(
       AddStreamFn AddStream, NativeObjectCache Cache, unsigned Task,
       BitcodeModule BM, ModuleSummaryIndex &CombinedIndex,
@@ -946,8 +998,7 @@ public:
       const FunctionImporter::ExportSetTy &ExportList,
       const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> &ResolvedODR,
       const GVSummaryMapTy &DefinedGlobals,
-      MapVector<StringRef, BitcodeModule> &ModuleMap,
-      const TypeIdSummariesByGuidTy &TypeIdSummariesByGuid) {
+      MapVector<StringRef, BitcodeModule> &ModuleMap) {
     auto RunThinBackend = [&](AddStreamFn AddStream) {
       LTOLLVMContext BackendContext(Conf);
       Expected<std::unique_ptr<Module>> MOrErr = BM.parseModule(BackendContext);
@@ -960,18 +1011,15 @@ public:
 
     auto ModuleID = BM.getModuleIdentifier();
 
-    if (!Cache || !CombinedIndex.modulePaths().count(ModuleID) ||
-        all_of(CombinedIndex.getModuleHash(ModuleID),
-               [](uint32_t V) { return V == 0; }))
+    SmallString<40> Key;
+    // The module may be cached, this helps handling it.
+    if (!Cache ||
+        !CacheKeyInfo.computeKey(Key, Conf, CombinedIndex, ModuleID, ImportList,
+                                 ExportList, ResolvedODR, DefinedGlobals))
       // Cache disabled or no entry for this module in the combined index or
       // no module hash.
       return RunThinBackend(AddStream);
 
-    SmallString<40> Key;
-    // The module may be cached, this helps handling it.
-    computeCacheKey(Key, Conf, CombinedIndex, ModuleID, ImportList, ExportList,
-                    ResolvedODR, DefinedGlobals, TypeIdSummariesByGuid,
-                    CfiFunctionDefs, CfiFunctionDecls);
     if (AddStreamFn CacheAddStream = Cache(Task, Key))
       return RunThinBackend(CacheAddStream);
 
@@ -995,11 +1043,10 @@ public:
             const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>
                 &ResolvedODR,
             const GVSummaryMapTy &DefinedGlobals,
-            MapVector<StringRef, BitcodeModule> &ModuleMap,
-            const TypeIdSummariesByGuidTy &TypeIdSummariesByGuid) {
+            MapVector<StringRef, BitcodeModule> &ModuleMap) {
           Error E = runThinLTOBackendThread(
               AddStream, Cache, Task, BM, CombinedIndex, ImportList, ExportList,
-              ResolvedODR, DefinedGlobals, ModuleMap, TypeIdSummariesByGuid);
+              ResolvedODR, DefinedGlobals, ModuleMap);
           if (E) {
             std::unique_lock<std::mutex> L(ErrMu);
             if (Err)
@@ -1009,8 +1056,7 @@ public:
           }
         },
         BM, std::ref(CombinedIndex), std::ref(ImportList), std::ref(ExportList),
-        std::ref(ResolvedODR), std::ref(DefinedGlobals), std::ref(ModuleMap),
-        std::ref(TypeIdSummariesByGuid));
+        std::ref(ResolvedODR), std::ref(DefinedGlobals), std::ref(ModuleMap));
     return Error::success();
   }
 
@@ -1124,6 +1170,173 @@ ThinBackend lto::createWriteIndexesThinBackend(
   };
 }
 
+namespace {
+class OutOfProcessThinBackend : public ThinBackendProc {
+  ThreadPool BackendThreadPool;
+  AddStreamFn AddStream;
+  NativeObjectCache Cache;
+  ThinBackendCacheKeyInfo CacheKeyInfo;
+  std::string WorkerPath;
+  std::vector<std::string> WorkerArgs;
+
+  Optional<Error> Err;
+  std::mutex ErrMu;
+
+public:
+  OutOfProcessThinBackend(
+      Config &Conf, ModuleSummaryIndex &CombinedIndex,
+      unsigned ParallelismLevel,
+      const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+      AddStreamFn AddStream, NativeObjectCache Cache, std::string WorkerPath,
+      std::vector<std::string> WorkerArgs)
+      : ThinBackendProc(Conf, CombinedIndex, ModuleToDefinedGVSummaries),
+        BackendThreadPool(ParallelismLevel), AddStream(std::move(AddStream)),
+        Cache(std::move(Cache)), CacheKeyInfo(CombinedIndex),
+        WorkerPath(std::move(WorkerPath)), WorkerArgs(std::move(WorkerArgs)) {}
+
+  // Write the individual index for ModulePath, run a worker process on it and
+  // hand the object file it produces to AddStream.
+  Error runWorker(AddStreamFn AddStream, unsigned Task, StringRef ModulePath,
+                  const FunctionImporter::ImportMapTy &ImportList) {
+    std::map<std::string, GVSummaryMapTy> ModuleToSummariesForIndex;
+    gatherImportedSummariesForModule(ModulePath, ModuleToDefinedGVSummaries,
+                                     ImportList, ModuleToSummariesForIndex);
+
+    SmallString<128> IndexPath;
+    int IndexFD;
+    if (std::error_code EC = sys::fs::createTemporaryFile(
+            "thinlto-index", "thinlto.bc", IndexFD, IndexPath))
+      return errorCodeToError(EC);
+    FileRemover IndexRemover(IndexPath);
+    {
+      raw_fd_ostream OS(IndexFD, /*shouldClose=*/true);
+      WriteIndexToFile(CombinedIndex, OS, &ModuleToSummariesForIndex);
+      if (OS.has_error())
+        return make_error<StringError>("could not write " + IndexPath,
+                                       inconvertibleErrorCode());
+    }
+
+    SmallString<128> ObjectPath;
+    if (std::error_code EC =
+            sys::fs::createTemporaryFile("thinlto-object", "o", ObjectPath))
+      return errorCodeToError(EC);
+    FileRemover ObjectRemover(ObjectPath);
+
+    // Forward the options that the in-process backend would generate code
+    // with. clang's driver takes the CPU and the features through to cc1,
+    // where the last -target-cpu wins over the one the driver picks.
+    std::vector<std::string> CodeGenArgs;
+    CodeGenArgs.push_back("-O" + utostr(Conf.OptLevel));
+    if (!Conf.CPU.empty()) {
+      CodeGenArgs.insert(CodeGenArgs.end(), {"-Xclang", "-target-cpu"});
+      CodeGenArgs.insert(CodeGenArgs.end(), {"-Xclang", Conf.CPU});
+    }
+    for (const std::string &Feature : Conf.MAttrs) {
+      CodeGenArgs.insert(CodeGenArgs.end(), {"-Xclang", "-target-feature"});
+      CodeGenArgs.insert(CodeGenArgs.end(), {"-Xclang", Feature});
+    }
+
+    std::string IndexArg = ("-fthinlto-index=" + IndexPath).str();
+    std::vector<StringRef> Args;
+    Args.push_back(WorkerPath);
+    for (const std::string &Arg : WorkerArgs)
+      Args.push_back(Arg);
+    for (const std::string &Arg : CodeGenArgs)
+      Args.push_back(Arg);
+    Args.push_back("-x");
+    Args.push_back("ir");
+    Args.push_back(ModulePath);
+    Args.push_back(IndexArg);
+    Args.push_back("-o");
+    Args.push_back(ObjectPath);
+
+    std::string ErrMsg;
+    int Result = sys::ExecuteAndWait(WorkerPath, Args, /*Env=*/None,
+                                     /*Redirects=*/{}, /*SecondsToWait=*/0,
+                                     /*MemoryLimit=*/0, &ErrMsg);
+    if (Result != 0) {
+      std::string Msg =
+          "ThinLTO backend worker for '" + ModulePath.str() + "' ";
+      if (Result == -1)
+        Msg += "could not be run";
+      else if (Result == -2)
+        Msg += "crashed";
+      else
+        Msg += "exited with status " + utostr(Result);
+      if (!ErrMsg.empty())
+        Msg += ": " + ErrMsg;
+      return make_error<StringError>(Msg, inconvertibleErrorCode());
+    }
+
+    ErrorOr<std::unique_ptr<MemoryBuffer>> ObjectOrErr =
+        MemoryBuffer::getFile(ObjectPath);
+    if (!ObjectOrErr)
+      return errorCodeToError(ObjectOrErr.getError());
+    std::unique_ptr<NativeObjectStream> Stream = AddStream(Task);
+    *Stream->OS << (*ObjectOrErr)->getBuffer();
+    return Error::success();
+  }
+
+  Error start(
+      unsigned Task, BitcodeModule BM,
+      const FunctionImporter::ImportMapTy &ImportList,
+      const FunctionImporter::ExportSetTy &ExportList,
+      const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> &ResolvedODR,
+      MapVector<StringRef, BitcodeModule> &ModuleMap) override {
+    StringRef ModulePath = BM.getModuleIdentifier();
+    assert(ModuleToDefinedGVSummaries.count(ModulePath));
+    const GVSummaryMapTy &DefinedGlobals =
+        ModuleToDefinedGVSummaries.find(ModulePath)->second;
+
+    // Look the job up in the cache before paying for a worker process.
+    AddStreamFn JobAddStream = AddStream;
+    SmallString<40> Key;
+    if (Cache &&
+        CacheKeyInfo.computeKey(Key, Conf, CombinedIndex, ModulePath,
+                                ImportList, ExportList, ResolvedODR,
+                                DefinedGlobals)) {
+      JobAddStream = Cache(Task, Key);
+      if (!JobAddStream)
+        return Error::success();
+    }
+
+    BackendThreadPool.async(
+        [=](const FunctionImporter::ImportMapTy &ImportList) {
+          Error E = runWorker(JobAddStream, Task, ModulePath, ImportList);
+          if (E) {
+            std::unique_lock<std::mutex> L(ErrMu);
+            if (Err)
+              Err = joinErrors(std::move(*Err), std::move(E));
+            else
+              Err = std::move(E);
+          }
+        },
+        std::ref(ImportList));
+    return Error::success();
+  }
+
+  Error wait() override {
+    BackendThreadPool.wait();
+    if (Err)
+      return std::move(*Err);
+    else
+      return Error::success();
+  }
+};
+} // end anonymous namespace
+
+ThinBackend lto::createOutOfProcessThinBackend(
+    unsigned ParallelismLevel, std::string WorkerPath,
+    std::vector<std::string> WorkerArgs) {
+  return [=](Config &Conf, ModuleSummaryIndex &CombinedIndex,
+             const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+             AddStreamFn AddStream, NativeObjectCache Cache) {
+    return llvm::make_unique<OutOfProcessThinBackend>(
+        Conf, CombinedIndex, ParallelismLevel, ModuleToDefinedGVSummaries,
+        AddStream, Cache, WorkerPath, WorkerArgs);
+  };
+}
+
 Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
   if (ThinLTO.ModuleMap.empty())
     return Error::success();
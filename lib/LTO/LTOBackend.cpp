@@ -21,6 +21,7 @@
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/IRMemoryUsage.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Verifier.h"
@@ -28,6 +29,7 @@
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Object/ModuleSymbolTable.h"
 #include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -46,6 +48,11 @@
 using namespace llvm;
 using namespace lto;
 
+static cl::opt<bool> LTOCompactOperandLists(
+    "lto-compact-operand-lists", cl::init(false), cl::Hidden,
+    cl::desc("Release the operand space that PHI nodes and switches reserved "
+             "during optimization before running code generation"));
+
 LLVM_ATTRIBUTE_NORETURN static void reportOpenError(StringRef Path, Twine Msg) {
   errs() << "failed to open " << Path << ": " << Msg << '\n';
   errs().flush();
@@ -286,6 +293,8 @@ bool opt(Config &Conf, TargetMachine *TM, unsigned Task, Module &Mod,
                    ImportSummary);
   else
     runOldPMPasses(Conf, Mod, TM, IsThinLTO, ExportSummary, ImportSummary);
+  if (LTOCompactOperandLists)
+    compactOperandLists(Mod);
   return !Conf.PostOptModuleHook || Conf.PostOptModuleHook(Task, Mod);
 }
 
@@ -366,7 +375,7 @@ void splitCodeGen(Config &C, TargetMachine *TM, AddStreamFn AddStream,
             // copied into the thread's context.
             std::move(BC), ThreadCount++);
       },
-      false);
+      /*PreserveLocals=*/false, /*BalancePartitions=*/true);
 
   // Because the inner lambda (which runs in a worker thread) captures our local
   // variables, we need to wait for the worker threads to terminate before we
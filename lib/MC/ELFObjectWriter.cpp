@@ -38,6 +38,7 @@
 #include "llvm/MC/StringTableBuilder.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
@@ -64,6 +65,12 @@ using namespace llvm;
 #undef  DEBUG_TYPE
 #define DEBUG_TYPE "reloc-info"
 
+static cl::opt<unsigned> CompressDebugSectionsThreads(
+    "compress-debug-sections-threads", cl::init(0), cl::Hidden,
+    cl::desc("Number of threads to compress each debug section with; 0 uses "
+             "one per hardware thread. Lower it when several objects are "
+             "written at once."));
+
 namespace {
 
 using SectionIndexMapTy = DenseMap<const MCSectionELF *, uint32_t>;
@@ -852,9 +859,10 @@ void ELFWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
   Asm.writeSectionData(VecOS, &Section, Layout);
 
   SmallVector<char, 128> CompressedContents;
-  if (Error E = zlib::compress(
+  if (Error E = zlib::compressParallel(
           StringRef(UncompressedData.data(), UncompressedData.size()),
-          CompressedContents)) {
+          CompressedContents, zlib::DefaultCompression,
+          CompressDebugSectionsThreads)) {
     consumeError(std::move(E));
     W.OS << UncompressedData;
     return;
@@ -133,6 +133,23 @@ MCSymbol *MCContext::getOrCreateSymbol(const Twine &Name) {
   return Sym;
 }
 
+MCSymbol *MCContext::createUniqueSymbol(const Twine &Name) {
+  SmallString<128> NameSV;
+  StringRef NameRef = Name.toStringRef(NameSV);
+
+  assert(!NameRef.empty() && "Normal symbols cannot be unnamed!");
+
+  SmallString<128> NewName = NameRef;
+  unsigned &NextUniqueID = NextID[NameRef];
+  while (Symbols.count(NewName) || UsedNames.lookup(NewName)) {
+    NewName.resize(NameRef.size());
+    raw_svector_ostream(NewName) << '.' << ++NextUniqueID;
+  }
+  MCSymbol *&Sym = Symbols[NewName];
+  Sym = createSymbol(NewName, false, false);
+  return Sym;
+}
+
 MCSymbol *MCContext::getOrCreateFrameAllocSymbol(StringRef FuncName,
                                                  unsigned Idx) {
   return getOrCreateSymbol(Twine(MAI->getPrivateGlobalPrefix()) + FuncName +
@@ -2143,6 +2143,15 @@ LLVM_DUMP_METHOD void APInt::dump() const {
 #endif
 
 void APInt::print(raw_ostream &OS, bool isSigned) const {
+  // Print values that fit in a word directly, without a temporary string.
+  if (isSingleWord()) {
+    if (isSigned)
+      OS << getSExtValue();
+    else
+      OS << getZExtValue();
+    return;
+  }
+
   SmallString<40> S;
   this->toString(S, 10, isSigned, /* formatAsCLiteral = */false);
   OS << S;
@@ -18,6 +18,10 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <vector>
 #if LLVM_ENABLE_ZLIB == 1 && HAVE_ZLIB_H
 #include <zlib.h>
 #endif
@@ -73,6 +77,119 @@ Error zlib::compress(StringRef InputBuffer,
   return Res ? createError(convertZlibCodeToString(Res)) : Error::success();
 }
 
+/// Input is split into blocks of this size for compressParallel.
+static const size_t ParallelBlockSize = 1 << 20;
+
+/// The size of the deflate window, and so of the dictionary each block can
+/// refer back into.
+static const size_t DictionarySize = 1 << 15;
+
+/// Deflate one block of a larger stream into \p Out as raw deflate data.
+/// \p Dictionary is the input immediately preceding the block, if any.
+static int compressBlock(StringRef Block, StringRef Dictionary, bool IsLast,
+                         int CLevel, SmallVectorImpl<char> &Out) {
+  z_stream Stream = {};
+  // Negative window bits produce a raw deflate stream without the zlib
+  // header and trailer; the caller writes those once for the whole input.
+  int Res = ::deflateInit2(&Stream, CLevel, Z_DEFLATED, -15, 8,
+                           Z_DEFAULT_STRATEGY);
+  if (Res != Z_OK)
+    return Res;
+  if (!Dictionary.empty()) {
+    Res = ::deflateSetDictionary(&Stream, (const Bytef *)Dictionary.data(),
+                                 Dictionary.size());
+    if (Res != Z_OK) {
+      ::deflateEnd(&Stream);
+      return Res;
+    }
+  }
+
+  // deflateBound does not account for the empty stored block emitted by
+  // Z_SYNC_FLUSH, so leave room for it.
+  Out.resize(::deflateBound(&Stream, Block.size()) + 16);
+  Stream.next_in = (Bytef *)const_cast<char *>(Block.data());
+  Stream.avail_in = Block.size();
+  Stream.next_out = (Bytef *)Out.data();
+  Stream.avail_out = Out.size();
+  // A sync flush ends the block on a byte boundary without marking it as the
+  // final one, so the blocks can simply be concatenated.
+  Res = ::deflate(&Stream, IsLast ? Z_FINISH : Z_SYNC_FLUSH);
+  size_t Written = Out.size() - Stream.avail_out;
+  ::deflateEnd(&Stream);
+  // Tell MemorySanitizer that zlib output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented ZLib.
+  __msan_unpoison(Out.data(), Written);
+  Out.resize(Written);
+  if (Res != (IsLast ? Z_STREAM_END : Z_OK))
+    return Res == Z_OK ? Z_BUF_ERROR : Res;
+  return Z_OK;
+}
+
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             CompressionLevel Level, unsigned ThreadCount) {
+  if (InputBuffer.size() <= ParallelBlockSize)
+    return compress(InputBuffer, CompressedBuffer, Level);
+
+  int CLevel = encodeZlibCompressionLevel(Level);
+  size_t NumBlocks =
+      (InputBuffer.size() + ParallelBlockSize - 1) / ParallelBlockSize;
+  std::vector<SmallVector<char, 0>> Blocks(NumBlocks);
+  std::vector<uint32_t> Checksums(NumBlocks);
+  std::vector<int> Results(NumBlocks);
+  // Use a pool that lives only for this call rather than the process-wide
+  // parallel executor, so that no worker threads outlive the compression.
+  if (ThreadCount == 0)
+    ThreadCount = hardware_concurrency();
+  ThreadPool Pool(std::min<size_t>(NumBlocks, ThreadCount));
+  for (size_t I = 0; I != NumBlocks; ++I)
+    Pool.async([&, I] {
+      size_t Start = I * ParallelBlockSize;
+      StringRef Block = InputBuffer.substr(Start, ParallelBlockSize);
+      size_t DictStart = Start > DictionarySize ? Start - DictionarySize : 0;
+      StringRef Dictionary = InputBuffer.slice(DictStart, Start);
+      Results[I] = compressBlock(Block, Dictionary, I == NumBlocks - 1, CLevel,
+                                 Blocks[I]);
+      Checksums[I] = ::adler32(1, (const Bytef *)Block.data(), Block.size());
+    });
+  Pool.wait();
+  for (int Res : Results)
+    if (Res != Z_OK)
+      return createError(convertZlibCodeToString(Res));
+
+  // Emit the zlib header the same way deflate() would for this level.
+  int LevelFlags;
+  if (CLevel == Z_DEFAULT_COMPRESSION || CLevel == 6)
+    LevelFlags = 2;
+  else
+    LevelFlags = CLevel < 2 ? 0 : CLevel < 6 ? 1 : 3;
+  unsigned Header = (0x78 << 8) | (LevelFlags << 6);
+  Header += 31 - Header % 31;
+
+  size_t TotalSize = 2 + 4;
+  for (const SmallVector<char, 0> &Block : Blocks)
+    TotalSize += Block.size();
+  CompressedBuffer.clear();
+  CompressedBuffer.reserve(TotalSize);
+  CompressedBuffer.push_back(Header >> 8);
+  CompressedBuffer.push_back(Header & 0xff);
+
+  uLong Adler = Checksums[0];
+  for (size_t I = 0; I != NumBlocks; ++I) {
+    CompressedBuffer.append(Blocks[I].begin(), Blocks[I].end());
+    if (I != 0) {
+      size_t Start = I * ParallelBlockSize;
+      size_t BlockLen = std::min(ParallelBlockSize, InputBuffer.size() - Start);
+      Adler = ::adler32_combine(Adler, Checksums[I], BlockLen);
+    }
+  }
+
+  // The trailer is the big-endian Adler-32 of the uncompressed data.
+  for (int Shift = 24; Shift >= 0; Shift -= 8)
+    CompressedBuffer.push_back((Adler >> Shift) & 0xff);
+  return Error::success();
+}
+
 Error zlib::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                        size_t &UncompressedSize) {
   int Res =
@@ -105,6 +222,11 @@ Error zlib::compress(StringRef InputBuffer,
                      CompressionLevel Level) {
   llvm_unreachable("zlib::compress is unavailable");
 }
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             CompressionLevel Level, unsigned ThreadCount) {
+  llvm_unreachable("zlib::compressParallel is unavailable");
+}
 Error zlib::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                        size_t &UncompressedSize) {
   llvm_unreachable("zlib::uncompress is unavailable");
@@ -107,7 +107,8 @@ public:
 template <typename MB>
 static ErrorOr<std::unique_ptr<MB>>
 getFileAux(const Twine &Filename, int64_t FileSize, uint64_t MapSize,
-           uint64_t Offset, bool RequiresNullTerminator, bool IsVolatile);
+           uint64_t Offset, bool RequiresNullTerminator, bool IsVolatile,
+           const MemoryBuffer::FileOptions &Options);
 
 std::unique_ptr<MemoryBuffer>
 MemoryBuffer::getMemBuffer(StringRef InputData, StringRef BufferName,
@@ -155,13 +156,16 @@ ErrorOr<std::unique_ptr<MemoryBuffer>>
 MemoryBuffer::getFileSlice(const Twine &FilePath, uint64_t MapSize, 
                            uint64_t Offset, bool IsVolatile) {
   return getFileAux<MemoryBuffer>(FilePath, -1, MapSize, Offset, false,
-                                  IsVolatile);
+                                  IsVolatile, MemoryBuffer::FileOptions());
 }
 
 //===----------------------------------------------------------------------===//
 // MemoryBuffer::getFile implementation.
 //===----------------------------------------------------------------------===//
 
+/// Files at least this large are worth backing with transparent huge pages.
+static const uint64_t HugePageThreshold = 2 * 1024 * 1024;
+
 namespace {
 /// Memory maps a file descriptor using sys::fs::mapped_file_region.
 ///
@@ -197,6 +201,20 @@ public:
   /// tail-allocated data.
   void operator delete(void *p) { ::operator delete(p); }
 
+  /// Forward the paging hints in \p Options to the OS.
+  void advise(const MemoryBuffer::FileOptions &Options) {
+    using Region = sys::fs::mapped_file_region;
+    // Ask for huge pages before prefaulting, so the prefault can use them.
+    if (Options.HugePages && MFR.size() >= HugePageThreshold)
+      MFR.advise(Region::hugepage);
+    if (Options.Access == MemoryBuffer::AP_Sequential)
+      MFR.advise(Region::sequential);
+    else if (Options.Access == MemoryBuffer::AP_Random)
+      MFR.advise(Region::random);
+    if (Options.Prefault)
+      MFR.advise(Region::willneed);
+  }
+
   StringRef getBufferIdentifier() const override {
     // The name is stored after the class itself.
     return StringRef(reinterpret_cast<const char *>(this + 1));
@@ -230,19 +248,29 @@ ErrorOr<std::unique_ptr<MemoryBuffer>>
 MemoryBuffer::getFile(const Twine &Filename, int64_t FileSize,
                       bool RequiresNullTerminator, bool IsVolatile) {
   return getFileAux<MemoryBuffer>(Filename, FileSize, FileSize, 0,
-                                  RequiresNullTerminator, IsVolatile);
+                                  RequiresNullTerminator, IsVolatile,
+                                  FileOptions());
+}
+
+ErrorOr<std::unique_ptr<MemoryBuffer>>
+MemoryBuffer::getFile(const Twine &Filename, const FileOptions &Options,
+                      int64_t FileSize, bool RequiresNullTerminator,
+                      bool IsVolatile) {
+  return getFileAux<MemoryBuffer>(Filename, FileSize, FileSize, 0,
+                                  RequiresNullTerminator, IsVolatile, Options);
 }
 
 template <typename MB>
 static ErrorOr<std::unique_ptr<MB>>
 getOpenFileImpl(int FD, const Twine &Filename, uint64_t FileSize,
                 uint64_t MapSize, int64_t Offset, bool RequiresNullTerminator,
-                bool IsVolatile);
+                bool IsVolatile, const MemoryBuffer::FileOptions &Options);
 
 template <typename MB>
 static ErrorOr<std::unique_ptr<MB>>
 getFileAux(const Twine &Filename, int64_t FileSize, uint64_t MapSize,
-           uint64_t Offset, bool RequiresNullTerminator, bool IsVolatile) {
+           uint64_t Offset, bool RequiresNullTerminator, bool IsVolatile,
+           const MemoryBuffer::FileOptions &Options) {
   int FD;
   std::error_code EC = sys::fs::openFileForRead(Filename, FD, sys::fs::OF_None);
 
@@ -250,7 +278,7 @@ getFileAux(const Twine &Filename, int64_t FileSize, uint64_t MapSize,
     return EC;
 
   auto Ret = getOpenFileImpl<MB>(FD, Filename, FileSize, MapSize, Offset,
-                                 RequiresNullTerminator, IsVolatile);
+                                 RequiresNullTerminator, IsVolatile, Options);
   close(FD);
   return Ret;
 }
@@ -260,14 +288,16 @@ WritableMemoryBuffer::getFile(const Twine &Filename, int64_t FileSize,
                               bool IsVolatile) {
   return getFileAux<WritableMemoryBuffer>(Filename, FileSize, FileSize, 0,
                                           /*RequiresNullTerminator*/ false,
-                                          IsVolatile);
+                                          IsVolatile,
+                                          MemoryBuffer::FileOptions());
 }
 
 ErrorOr<std::unique_ptr<WritableMemoryBuffer>>
 WritableMemoryBuffer::getFileSlice(const Twine &Filename, uint64_t MapSize,
                                    uint64_t Offset, bool IsVolatile) {
   return getFileAux<WritableMemoryBuffer>(Filename, -1, MapSize, Offset, false,
-                                          IsVolatile);
+                                          IsVolatile,
+                                          MemoryBuffer::FileOptions());
 }
 
 std::unique_ptr<WritableMemoryBuffer>
@@ -311,13 +341,18 @@ static bool shouldUseMmap(int FD,
                           off_t Offset,
                           bool RequiresNullTerminator,
                           int PageSize,
-                          bool IsVolatile) {
+                          bool IsVolatile,
+                          const MemoryBuffer::FileOptions &Options) {
   // mmap may leave the buffer without null terminator if the file size changed
   // by the time the last page is mapped in, so avoid it if the file size is
   // likely to change.
   if (IsVolatile)
     return false;
 
+  // The client asked for the file to be read rather than mapped.
+  if (Options.Stream)
+    return false;
+
   // We don't use mmap for small files because this can severely fragment our
   // address space.
   if (MapSize < 4 * 4096 || MapSize < (unsigned)PageSize)
@@ -417,7 +452,7 @@ template <typename MB>
 static ErrorOr<std::unique_ptr<MB>>
 getOpenFileImpl(int FD, const Twine &Filename, uint64_t FileSize,
                 uint64_t MapSize, int64_t Offset, bool RequiresNullTerminator,
-                bool IsVolatile) {
+                bool IsVolatile, const MemoryBuffer::FileOptions &Options) {
   static int PageSize = sys::Process::getPageSize();
 
   // Default is to map the full file.
@@ -444,13 +479,15 @@ getOpenFileImpl(int FD, const Twine &Filename, uint64_t FileSize,
   }
 
   if (shouldUseMmap(FD, FileSize, MapSize, Offset, RequiresNullTerminator,
-                    PageSize, IsVolatile)) {
+                    PageSize, IsVolatile, Options)) {
     std::error_code EC;
-    std::unique_ptr<MB> Result(
+    std::unique_ptr<MemoryBufferMMapFile<MB>> Result(
         new (NamedBufferAlloc(Filename)) MemoryBufferMMapFile<MB>(
             RequiresNullTerminator, FD, MapSize, Offset, EC));
-    if (!EC)
-      return std::move(Result);
+    if (!EC) {
+      Result->advise(Options);
+      return std::unique_ptr<MB>(std::move(Result));
+    }
   }
 
   auto Buf = WritableMemoryBuffer::getNewUninitMemBuffer(MapSize, Filename);
@@ -462,6 +499,11 @@ getOpenFileImpl(int FD, const Twine &Filename, uint64_t FileSize,
 
   char *BufPtr = Buf.get()->getBufferStart();
 
+  // Let the kernel start fetching the whole range now with a large read-ahead
+  // window, rather than discovering the sequential pattern one read at a time.
+  if (Options.Stream || Options.Access == MemoryBuffer::AP_Sequential)
+    sys::fs::readAhead(FD, Offset, MapSize);
+
   size_t BytesLeft = MapSize;
 #ifndef HAVE_PREAD
   if (lseek(FD, Offset, SEEK_SET) == -1)
@@ -494,7 +536,8 @@ ErrorOr<std::unique_ptr<MemoryBuffer>>
 MemoryBuffer::getOpenFile(int FD, const Twine &Filename, uint64_t FileSize,
                           bool RequiresNullTerminator, bool IsVolatile) {
   return getOpenFileImpl<MemoryBuffer>(FD, Filename, FileSize, FileSize, 0,
-                         RequiresNullTerminator, IsVolatile);
+                         RequiresNullTerminator, IsVolatile,
+                         MemoryBuffer::FileOptions());
 }
 
 ErrorOr<std::unique_ptr<MemoryBuffer>>
@@ -502,7 +545,7 @@ MemoryBuffer::getOpenFileSlice(int FD, const Twine &Filename, uint64_t MapSize,
                                int64_t Offset, bool IsVolatile) {
   assert(MapSize != uint64_t(-1));
   return getOpenFileImpl<MemoryBuffer>(FD, Filename, -1, MapSize, Offset, false,
-                                       IsVolatile);
+                                       IsVolatile, MemoryBuffer::FileOptions());
 }
 
 ErrorOr<std::unique_ptr<MemoryBuffer>> MemoryBuffer::getSTDIN() {
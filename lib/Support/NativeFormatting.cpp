@@ -20,13 +20,29 @@ using namespace llvm;
 
 template<typename T, std::size_t N>
 static int format_to_buffer(T Value, char (&Buffer)[N]) {
+  static const char DigitPairs[] =
+    "000102030405060708091011121314151617181920212223242526272829"
+    "303132333435363738394041424344454647484950515253545556575859"
+    "606162636465666768697071727374757677787980818283848586878889"
+    "90919293949596979899";
   char *EndPtr = std::end(Buffer);
   char *CurPtr = EndPtr;
 
-  do {
-    *--CurPtr = '0' + char(Value % 10);
-    Value /= 10;
-  } while (Value);
+  // Emit two digits per division, which halves the number of divisions for
+  // large values.
+  while (Value >= 100) {
+    unsigned Pair = unsigned(Value % 100) * 2;
+    Value /= 100;
+    *--CurPtr = DigitPairs[Pair + 1];
+    *--CurPtr = DigitPairs[Pair];
+  }
+  if (Value >= 10) {
+    unsigned Pair = unsigned(Value) * 2;
+    *--CurPtr = DigitPairs[Pair + 1];
+    *--CurPtr = DigitPairs[Pair];
+  } else {
+    *--CurPtr = '0' + char(Value);
+  }
   return EndPtr - CurPtr;
 }
 
@@ -54,10 +70,7 @@ static void write_unsigned_impl(raw_ostream &S, T N, size_t MinDigits,
   static_assert(std::is_unsigned<T>::value, "Value is not unsigned!");
 
   char NumberBuffer[128];
-  std::memset(NumberBuffer, '0', sizeof(NumberBuffer));
-
-  size_t Len = 0;
-  Len = format_to_buffer(N, NumberBuffer);
+  size_t Len = format_to_buffer(N, NumberBuffer);
 
   if (IsNegative)
     S << '-';
@@ -147,15 +160,15 @@ void llvm::write_hex(raw_ostream &S, uint64_t N, HexPrintStyle Style,
       std::max(static_cast<unsigned>(W), std::max(1u, Nibbles) + PrefixChars);
 
   char NumberBuffer[kMaxWidth];
-  ::memset(NumberBuffer, '0', llvm::array_lengthof(NumberBuffer));
+  ::memset(NumberBuffer, '0', NumChars);
   if (Prefix)
     NumberBuffer[1] = 'x';
+  const char *Digits = Upper ? "0123456789ABCDEF" : "0123456789abcdef";
   char *EndPtr = NumberBuffer + NumChars;
   char *CurPtr = EndPtr;
   while (N) {
-    unsigned char x = static_cast<unsigned char>(N) % 16;
-    *--CurPtr = hexdigit(x, !Upper);
-    N /= 16;
+    *--CurPtr = Digits[N & 15];
+    N >>= 4;
   }
 
   S.write(NumberBuffer, NumChars);
@@ -173,17 +186,16 @@ void llvm::write_double(raw_ostream &S, double N, FloatStyle Style,
     return;
   }
 
-  char Letter;
+  // Pass the precision as an argument rather than building a format string
+  // for every number printed.
+  const char *Spec;
   if (Style == FloatStyle::Exponent)
-    Letter = 'e';
+    Spec = "%.*e";
   else if (Style == FloatStyle::ExponentUpper)
-    Letter = 'E';
+    Spec = "%.*E";
   else
-    Letter = 'f';
-
-  SmallString<8> Spec;
-  llvm::raw_svector_ostream Out(Spec);
-  Out << "%." << Prec << Letter;
+    Spec = "%.*f";
+  int P = static_cast<int>(Prec);
 
   if (Style == FloatStyle::Exponent || Style == FloatStyle::ExponentUpper) {
 #ifdef _WIN32
@@ -214,7 +226,7 @@ void llvm::write_double(raw_ostream &S, double N, FloatStyle Style,
 
     char buf[32];
     unsigned len;
-    len = format(Spec.c_str(), N).snprint(buf, sizeof(buf));
+    len = format(Spec, P, N).snprint(buf, sizeof(buf));
     if (len <= sizeof(buf) - 2) {
       if (len >= 5 && (buf[len - 5] == 'e' || buf[len - 5] == 'E') &&
           buf[len - 3] == '0') {
@@ -241,7 +253,7 @@ void llvm::write_double(raw_ostream &S, double N, FloatStyle Style,
     N *= 100.0;
 
   char Buf[32];
-  format(Spec.c_str(), N).snprint(Buf, sizeof(Buf));
+  format(Spec, P, N).snprint(Buf, sizeof(Buf));
   S << Buf;
   if (Style == FloatStyle::Percent)
     S << '%';
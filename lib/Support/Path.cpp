@@ -927,7 +927,18 @@ std::error_code create_directories(const Twine &Path, bool IgnoreExisting,
   return create_directory(P, IgnoreExisting, Perms);
 }
 
+#if defined(LLVM_ON_UNIX)
+// Defined in Unix/Path.inc.
+static bool copy_file_in_kernel(int ReadFD, int WriteFD, std::error_code &EC);
+#endif
+
 static std::error_code copy_file_internal(int ReadFD, int WriteFD) {
+#if defined(LLVM_ON_UNIX)
+  std::error_code KernelEC;
+  if (copy_file_in_kernel(ReadFD, WriteFD, KernelEC))
+    return KernelEC;
+#endif
+
   const size_t BufSize = 4096;
   char *Buf = new char[BufSize];
   int BytesRead = 0, BytesWritten = 0;
@@ -708,6 +708,11 @@ size_t raw_fd_ostream::preferred_buffer_size() const {
   // the complexity.
   if (S_ISCHR(statbuf.st_mode) && isatty(FD))
     return 0;
+  // st_blksize is typically a single page, which costs a syscall per 4KB when
+  // dumping large amounts of text or object data. Use a larger buffer for
+  // regular files and pipes.
+  if (S_ISREG(statbuf.st_mode) || S_ISFIFO(statbuf.st_mode))
+    return std::max<size_t>(statbuf.st_blksize, 64 * 1024);
   // Return the preferred block size.
   return statbuf.st_blksize;
 #else
@@ -33,14 +33,27 @@
 */
 
 /* based on revision d2df04efcbef7d7f6886d345861e5dfda4edacc1 Removed
- * everything but a simple interface for computing XXh64. */
+ * everything but a simple interface for computing XXh64. XXH3 was added later
+ * following the v0.8 reference implementation, keeping only the 64-bit
+ * variant with the default secret and seed. */
 
 #include "llvm/Support/xxhash.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/MathExtras.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__) &&                           \
+    defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define XXH3_USE_NEON
+#include <arm_neon.h>
+#endif
+
 using namespace llvm;
 using namespace support;
 
@@ -132,3 +145,395 @@ uint64_t llvm::xxHash64(StringRef Data) {
 
   return H64;
 }
+
+//===----------------------------------------------------------------------===//
+// XXH3
+//===----------------------------------------------------------------------===//
+
+static const uint32_t PRIME32_1 = 0x9E3779B1U;
+static const uint32_t PRIME32_2 = 0x85EBCA77U;
+static const uint32_t PRIME32_3 = 0xC2B2AE3DU;
+static const uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+static const uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+/// The default secret of the reference implementation.
+alignas(64) static const uint8_t Secret[192] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+    0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+    0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+    0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+    0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+    0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+    0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+    0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+    0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static const size_t SecretSize = sizeof(Secret);
+static const size_t StripeLen = 64;
+static const size_t SecretConsumeRate = 8;
+static const size_t StripesPerBlock =
+    (SecretSize - StripeLen) / SecretConsumeRate;
+static const size_t BlockLen = StripeLen * StripesPerBlock;
+static const size_t MidSizeMax = 240;
+static const size_t SecretSizeMin = 136;
+static const size_t SecretLastAccStart = 7;
+static const size_t SecretMergeAccsStart = 11;
+static const size_t MidSizeStartOffset = 3;
+static const size_t MidSizeLastOffset = 17;
+
+static const uint64_t *getInitialAcc() {
+  alignas(64) static const uint64_t InitialAcc[8] = {
+      PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+      PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+  return InitialAcc;
+}
+
+/// Compute the 128-bit product of \p LHS and \p RHS and fold the halves.
+static uint64_t mul128Fold64(uint64_t LHS, uint64_t RHS) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t Product = (__uint128_t)LHS * RHS;
+  return uint64_t(Product) ^ uint64_t(Product >> 64);
+#else
+  uint64_t LoLo = (LHS & 0xffffffff) * (RHS & 0xffffffff);
+  uint64_t HiLo = (LHS >> 32) * (RHS & 0xffffffff);
+  uint64_t LoHi = (LHS & 0xffffffff) * (RHS >> 32);
+  uint64_t HiHi = (LHS >> 32) * (RHS >> 32);
+  uint64_t Cross = (LoLo >> 32) + (HiLo & 0xffffffff) + LoHi;
+  uint64_t Upper = (HiLo >> 32) + (Cross >> 32) + HiHi;
+  uint64_t Lower = (Cross << 32) | (LoLo & 0xffffffff);
+  return Lower ^ Upper;
+#endif
+}
+
+static uint64_t xxh64Avalanche(uint64_t Hash) {
+  Hash ^= Hash >> 33;
+  Hash *= PRIME64_2;
+  Hash ^= Hash >> 29;
+  Hash *= PRIME64_3;
+  Hash ^= Hash >> 32;
+  return Hash;
+}
+
+static uint64_t xxh3Avalanche(uint64_t Hash) {
+  Hash ^= Hash >> 37;
+  Hash *= PRIME_MX1;
+  Hash ^= Hash >> 32;
+  return Hash;
+}
+
+static uint64_t rrmxmx(uint64_t Hash, uint64_t Len) {
+  Hash ^= rotl64(Hash, 49) ^ rotl64(Hash, 24);
+  Hash *= PRIME_MX2;
+  Hash ^= (Hash >> 35) + Len;
+  Hash *= PRIME_MX2;
+  return Hash ^ (Hash >> 28);
+}
+
+static uint64_t mix16B(const uint8_t *In, const uint8_t *Sec) {
+  return mul128Fold64(endian::read64le(In) ^ endian::read64le(Sec),
+                      endian::read64le(In + 8) ^ endian::read64le(Sec + 8));
+}
+
+static uint64_t len0To16(const uint8_t *In, size_t Len) {
+  if (Len > 8) {
+    uint64_t BitFlip1 =
+        endian::read64le(Secret + 24) ^ endian::read64le(Secret + 32);
+    uint64_t BitFlip2 =
+        endian::read64le(Secret + 40) ^ endian::read64le(Secret + 48);
+    uint64_t InputLo = endian::read64le(In) ^ BitFlip1;
+    uint64_t InputHi = endian::read64le(In + Len - 8) ^ BitFlip2;
+    uint64_t Acc = Len + ByteSwap_64(InputLo) + InputHi +
+                   mul128Fold64(InputLo, InputHi);
+    return xxh3Avalanche(Acc);
+  }
+  if (Len >= 4) {
+    uint64_t BitFlip =
+        endian::read64le(Secret + 8) ^ endian::read64le(Secret + 16);
+    uint64_t Input1 = endian::read32le(In);
+    uint64_t Input2 = endian::read32le(In + Len - 4);
+    uint64_t Keyed = (Input2 + (Input1 << 32)) ^ BitFlip;
+    return rrmxmx(Keyed, Len);
+  }
+  if (Len > 0) {
+    uint32_t Combined = (uint32_t(In[0]) << 16) |
+                        (uint32_t(In[Len >> 1]) << 24) | In[Len - 1] |
+                        (uint32_t(Len) << 8);
+    uint64_t BitFlip =
+        endian::read32le(Secret) ^ endian::read32le(Secret + 4);
+    return xxh64Avalanche(uint64_t(Combined) ^ BitFlip);
+  }
+  return xxh64Avalanche(endian::read64le(Secret + 56) ^
+                        endian::read64le(Secret + 64));
+}
+
+static uint64_t len17To128(const uint8_t *In, size_t Len) {
+  uint64_t Acc = Len * PRIME64_1;
+  if (Len > 32) {
+    if (Len > 64) {
+      if (Len > 96) {
+        Acc += mix16B(In + 48, Secret + 96);
+        Acc += mix16B(In + Len - 64, Secret + 112);
+      }
+      Acc += mix16B(In + 32, Secret + 64);
+      Acc += mix16B(In + Len - 48, Secret + 80);
+    }
+    Acc += mix16B(In + 16, Secret + 32);
+    Acc += mix16B(In + Len - 32, Secret + 48);
+  }
+  Acc += mix16B(In, Secret);
+  Acc += mix16B(In + Len - 16, Secret + 16);
+  return xxh3Avalanche(Acc);
+}
+
+static uint64_t len129To240(const uint8_t *In, size_t Len) {
+  uint64_t Acc = Len * PRIME64_1;
+  size_t NumRounds = Len / 16;
+  for (size_t I = 0; I < 8; ++I)
+    Acc += mix16B(In + 16 * I, Secret + 16 * I);
+  Acc = xxh3Avalanche(Acc);
+  for (size_t I = 8; I < NumRounds; ++I)
+    Acc += mix16B(In + 16 * I, Secret + 16 * (I - 8) + MidSizeStartOffset);
+  Acc += mix16B(In + Len - 16, Secret + SecretSizeMin - MidSizeLastOffset);
+  return xxh3Avalanche(Acc);
+}
+
+/// Mix one 64-byte stripe of input into the accumulators.
+static void accumulate512(uint64_t *Acc, const uint8_t *In,
+                          const uint8_t *Sec) {
+#if defined(__AVX2__)
+  __m256i *XAcc = reinterpret_cast<__m256i *>(Acc);
+  for (size_t I = 0; I < 2; ++I) {
+    __m256i Data = _mm256_loadu_si256((const __m256i *)(In + 32 * I));
+    __m256i Key = _mm256_loadu_si256((const __m256i *)(Sec + 32 * I));
+    __m256i DataKey = _mm256_xor_si256(Data, Key);
+    __m256i DataKeyHi = _mm256_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1));
+    __m256i Product = _mm256_mul_epu32(DataKey, DataKeyHi);
+    __m256i Swapped = _mm256_shuffle_epi32(Data, _MM_SHUFFLE(1, 0, 3, 2));
+    XAcc[I] = _mm256_add_epi64(Product, _mm256_add_epi64(XAcc[I], Swapped));
+  }
+#elif defined(__SSE2__)
+  __m128i *XAcc = reinterpret_cast<__m128i *>(Acc);
+  for (size_t I = 0; I < 4; ++I) {
+    __m128i Data = _mm_loadu_si128((const __m128i *)(In + 16 * I));
+    __m128i Key = _mm_loadu_si128((const __m128i *)(Sec + 16 * I));
+    __m128i DataKey = _mm_xor_si128(Data, Key);
+    __m128i DataKeyHi = _mm_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1));
+    __m128i Product = _mm_mul_epu32(DataKey, DataKeyHi);
+    __m128i Swapped = _mm_shuffle_epi32(Data, _MM_SHUFFLE(1, 0, 3, 2));
+    XAcc[I] = _mm_add_epi64(Product, _mm_add_epi64(XAcc[I], Swapped));
+  }
+#elif defined(XXH3_USE_NEON)
+  uint64x2_t *XAcc = reinterpret_cast<uint64x2_t *>(Acc);
+  for (size_t I = 0; I < 4; ++I) {
+    uint64x2_t Data = vreinterpretq_u64_u8(vld1q_u8(In + 16 * I));
+    uint64x2_t Key = vreinterpretq_u64_u8(vld1q_u8(Sec + 16 * I));
+    uint64x2_t DataKey = veorq_u64(Data, Key);
+    uint64x2_t Swapped = vextq_u64(Data, Data, 1);
+    XAcc[I] = vaddq_u64(XAcc[I], Swapped);
+    XAcc[I] = vmlal_u32(XAcc[I], vmovn_u64(DataKey), vshrn_n_u64(DataKey, 32));
+  }
+#else
+  for (size_t I = 0; I < 8; ++I) {
+    uint64_t Data = endian::read64le(In + 8 * I);
+    uint64_t DataKey = Data ^ endian::read64le(Sec + 8 * I);
+    Acc[I ^ 1] += Data;
+    Acc[I] += uint32_t(DataKey) * (DataKey >> 32);
+  }
+#endif
+}
+
+/// Scramble the accumulators at the end of each block.
+static void scrambleAcc(uint64_t *Acc, const uint8_t *Sec) {
+#if defined(__AVX2__)
+  __m256i *XAcc = reinterpret_cast<__m256i *>(Acc);
+  const __m256i Prime = _mm256_set1_epi32(PRIME32_1);
+  for (size_t I = 0; I < 2; ++I) {
+    __m256i Shifted = _mm256_srli_epi64(XAcc[I], 47);
+    __m256i Data = _mm256_xor_si256(XAcc[I], Shifted);
+    __m256i Key = _mm256_loadu_si256((const __m256i *)(Sec + 32 * I));
+    __m256i DataKey = _mm256_xor_si256(Data, Key);
+    __m256i DataKeyHi = _mm256_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1));
+    __m256i ProdLo = _mm256_mul_epu32(DataKey, Prime);
+    __m256i ProdHi = _mm256_mul_epu32(DataKeyHi, Prime);
+    XAcc[I] = _mm256_add_epi64(ProdLo, _mm256_slli_epi64(ProdHi, 32));
+  }
+#elif defined(__SSE2__)
+  __m128i *XAcc = reinterpret_cast<__m128i *>(Acc);
+  const __m128i Prime = _mm_set1_epi32(PRIME32_1);
+  for (size_t I = 0; I < 4; ++I) {
+    __m128i Shifted = _mm_srli_epi64(XAcc[I], 47);
+    __m128i Data = _mm_xor_si128(XAcc[I], Shifted);
+    __m128i Key = _mm_loadu_si128((const __m128i *)(Sec + 16 * I));
+    __m128i DataKey = _mm_xor_si128(Data, Key);
+    __m128i DataKeyHi = _mm_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1));
+    __m128i ProdLo = _mm_mul_epu32(DataKey, Prime);
+    __m128i ProdHi = _mm_mul_epu32(DataKeyHi, Prime);
+    XAcc[I] = _mm_add_epi64(ProdLo, _mm_slli_epi64(ProdHi, 32));
+  }
+#elif defined(XXH3_USE_NEON)
+  uint64x2_t *XAcc = reinterpret_cast<uint64x2_t *>(Acc);
+  const uint32x2_t Prime = vdup_n_u32(PRIME32_1);
+  for (size_t I = 0; I < 4; ++I) {
+    uint64x2_t Shifted = vshrq_n_u64(XAcc[I], 47);
+    uint64x2_t Data = veorq_u64(XAcc[I], Shifted);
+    uint64x2_t Key = vreinterpretq_u64_u8(vld1q_u8(Sec + 16 * I));
+    uint64x2_t DataKey = veorq_u64(Data, Key);
+    uint64x2_t ProdHi = vmull_u32(vshrn_n_u64(DataKey, 32), Prime);
+    XAcc[I] = vmlal_u32(vshlq_n_u64(ProdHi, 32), vmovn_u64(DataKey), Prime);
+  }
+#else
+  for (size_t I = 0; I < 8; ++I) {
+    uint64_t A = Acc[I];
+    A ^= A >> 47;
+    A ^= endian::read64le(Sec + 8 * I);
+    A *= PRIME32_1;
+    Acc[I] = A;
+  }
+#endif
+}
+
+static void accumulate(uint64_t *Acc, const uint8_t *In, const uint8_t *Sec,
+                       size_t NumStripes) {
+  for (size_t N = 0; N < NumStripes; ++N)
+    accumulate512(Acc, In + N * StripeLen, Sec + N * SecretConsumeRate);
+}
+
+static uint64_t mergeAccs(const uint64_t *Acc, const uint8_t *Sec,
+                          uint64_t Start) {
+  uint64_t Result = Start;
+  for (size_t I = 0; I < 4; ++I)
+    Result += mul128Fold64(Acc[2 * I] ^ endian::read64le(Sec + 16 * I),
+                           Acc[2 * I + 1] ^ endian::read64le(Sec + 16 * I + 8));
+  return xxh3Avalanche(Result);
+}
+
+static uint64_t hashLong(const uint8_t *In, size_t Len) {
+  alignas(64) uint64_t Acc[8];
+  memcpy(Acc, getInitialAcc(), sizeof(Acc));
+
+  size_t NumBlocks = (Len - 1) / BlockLen;
+  for (size_t N = 0; N < NumBlocks; ++N) {
+    accumulate(Acc, In + N * BlockLen, Secret, StripesPerBlock);
+    scrambleAcc(Acc, Secret + SecretSize - StripeLen);
+  }
+
+  // The last partial block, and then the last stripe, which may overlap it.
+  size_t NumStripes = ((Len - 1) - BlockLen * NumBlocks) / StripeLen;
+  accumulate(Acc, In + NumBlocks * BlockLen, Secret, NumStripes);
+  accumulate512(Acc, In + Len - StripeLen,
+                Secret + SecretSize - StripeLen - SecretLastAccStart);
+
+  return mergeAccs(Acc, Secret + SecretMergeAccsStart, Len * PRIME64_1);
+}
+
+uint64_t llvm::xxh3_64bits(ArrayRef<uint8_t> Data) {
+  const uint8_t *In = Data.data();
+  size_t Len = Data.size();
+  if (Len <= 16)
+    return len0To16(In, Len);
+  if (Len <= 128)
+    return len17To128(In, Len);
+  if (Len <= MidSizeMax)
+    return len129To240(In, Len);
+  return hashLong(In, Len);
+}
+
+/// Accumulate \p NumStripes stripes starting at \p In, scrambling whenever a
+/// block boundary is crossed. \p StripesSoFar is the position within the
+/// current block.
+static void consumeStripes(uint64_t *Acc, size_t &StripesSoFar,
+                           const uint8_t *In, size_t NumStripes) {
+  if (StripesPerBlock - StripesSoFar <= NumStripes) {
+    size_t StripesToEnd = StripesPerBlock - StripesSoFar;
+    accumulate(Acc, In, Secret + StripesSoFar * SecretConsumeRate,
+               StripesToEnd);
+    scrambleAcc(Acc, Secret + SecretSize - StripeLen);
+    accumulate(Acc, In + StripesToEnd * StripeLen, Secret,
+               NumStripes - StripesToEnd);
+    StripesSoFar = NumStripes - StripesToEnd;
+  } else {
+    accumulate(Acc, In, Secret + StripesSoFar * SecretConsumeRate, NumStripes);
+    StripesSoFar += NumStripes;
+  }
+}
+
+void XXH3_64::init() {
+  memcpy(Acc, getInitialAcc(), sizeof(Acc));
+  BufferedSize = 0;
+  StripesSoFar = 0;
+  TotalLen = 0;
+}
+
+void XXH3_64::update(ArrayRef<uint8_t> Data) {
+  const uint8_t *In = Data.data();
+  const uint8_t *const End = In + Data.size();
+  TotalLen += Data.size();
+
+  // Small updates just fill the buffer.
+  if (Data.size() <= BufferSize - BufferedSize) {
+    if (!Data.empty())
+      memcpy(Buffer + BufferedSize, In, Data.size());
+    BufferedSize += Data.size();
+    return;
+  }
+
+  // The buffer is only flushed once more input is known to follow it, as the
+  // last stripe gets special treatment in final().
+  static const size_t BufferStripes = BufferSize / StripeLen;
+  if (BufferedSize) {
+    size_t LoadSize = BufferSize - BufferedSize;
+    memcpy(Buffer + BufferedSize, In, LoadSize);
+    In += LoadSize;
+    consumeStripes(Acc, StripesSoFar, Buffer, BufferStripes);
+    BufferedSize = 0;
+  }
+
+  // Consume whole buffers directly from the input, always leaving something
+  // behind for final().
+  if (End - In > (ptrdiff_t)BufferSize) {
+    do {
+      consumeStripes(Acc, StripesSoFar, In, BufferStripes);
+      In += BufferSize;
+    } while (End - In > (ptrdiff_t)BufferSize);
+    // Keep the last stripe consumed, in case final() needs to look back.
+    memcpy(Buffer + BufferSize - StripeLen, In - StripeLen, StripeLen);
+  }
+
+  memcpy(Buffer, In, End - In);
+  BufferedSize = End - In;
+}
+
+uint64_t XXH3_64::final() const {
+  if (TotalLen <= MidSizeMax)
+    return xxh3_64bits(ArrayRef<uint8_t>(Buffer, TotalLen));
+
+  alignas(64) uint64_t FinalAcc[8];
+  memcpy(FinalAcc, Acc, sizeof(FinalAcc));
+  const uint8_t *LastStripe;
+  uint8_t LastStripeBuf[StripeLen];
+  if (BufferedSize >= StripeLen) {
+    size_t NumStripes = (BufferedSize - 1) / StripeLen;
+    size_t FinalStripesSoFar = StripesSoFar;
+    consumeStripes(FinalAcc, FinalStripesSoFar, Buffer, NumStripes);
+    LastStripe = Buffer + BufferedSize - StripeLen;
+  } else {
+    // The last stripe straddles the previously consumed input, whose tail was
+    // saved at the end of the buffer.
+    size_t CatchupSize = StripeLen - BufferedSize;
+    memcpy(LastStripeBuf, Buffer + BufferSize - CatchupSize, CatchupSize);
+    memcpy(LastStripeBuf + CatchupSize, Buffer, BufferedSize);
+    LastStripe = LastStripeBuf;
+  }
+  accumulate512(FinalAcc, LastStripe,
+                Secret + SecretSize - StripeLen - SecretLastAccStart);
+  return mergeAccs(FinalAcc, Secret + SecretMergeAccsStart,
+                   TotalLen * PRIME64_1);
+}
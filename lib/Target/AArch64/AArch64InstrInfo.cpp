@@ -403,6 +403,137 @@ unsigned AArch64InstrInfo::insertBranch(
   return 2;
 }
 
+/// Analyze a single block loop for the software pipeliner. The loop must end
+/// in a Bcc that tests the flags set by a single compare in the loop. No other
+/// instruction may read the flags, and no instruction may define a physical
+/// register other than NZCV, so everything but the compare can be moved
+/// between iterations. The branch is rewritten, if needed, so that it is taken
+/// to continue the loop.
+bool AArch64InstrInfo::analyzeLoop(MachineLoop &L, MachineInstr *&IndVarInst,
+                                   MachineInstr *&CmpInst) const {
+  MachineBasicBlock *LoopBB = L.getHeader();
+  MachineBasicBlock *TBB = nullptr, *FBB = nullptr;
+  SmallVector<MachineOperand, 4> Cond;
+  if (L.getNumBlocks() != 1 || analyzeBranch(*LoopBB, TBB, FBB, Cond) ||
+      Cond.size() != 1)
+    return true;
+
+  if (TBB != LoopBB && FBB != LoopBB)
+    return true;
+
+  CmpInst = nullptr;
+  for (MachineInstr &MI : make_range(LoopBB->getFirstNonPHI(),
+                                     LoopBB->getFirstTerminator())) {
+    if (MI.isCall() || MI.hasUnmodeledSideEffects())
+      return true;
+    for (const MachineOperand &MO : MI.operands()) {
+      if (!MO.isReg() || !TargetRegisterInfo::isPhysicalRegister(MO.getReg()))
+        continue;
+      if (MO.getReg() == AArch64::NZCV) {
+        if (MO.readsReg())
+          return true;
+        // The branch reads the flags of the last definition.
+        CmpInst = &MI;
+      } else if (MO.isDef())
+        return true;
+    }
+  }
+  if (!CmpInst)
+    return true;
+
+  // reduceLoopCount identifies the exit test by a register of the compare.
+  const MachineRegisterInfo &MRI = LoopBB->getParent()->getRegInfo();
+  IndVarInst = nullptr;
+  bool HasVReg = false;
+  for (const MachineOperand &MO : CmpInst->uses()) {
+    if (!MO.isReg() || !TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+      continue;
+    HasVReg = true;
+    MachineInstr *DefMI = MRI.getVRegDef(MO.getReg());
+    if (!IndVarInst && DefMI && DefMI->getParent() == LoopBB &&
+        !DefMI->isPHI())
+      IndVarInst = DefMI;
+  }
+  if (!HasVReg)
+    return true;
+
+  // Only rewrite the branch once the loop is known to be accepted.
+  if (TBB != LoopBB) {
+    reverseBranchCondition(Cond);
+    DebugLoc DL = LoopBB->getFirstTerminator()->getDebugLoc();
+    removeBranch(*LoopBB);
+    insertBranch(*LoopBB, LoopBB, TBB, Cond, DL);
+  }
+  return false;
+}
+
+/// Add the exit test to a prolog block that the pipeliner peeled from the
+/// loop. The trip count is not known, so the copy of the loop compare in the
+/// prolog decides whether to branch to the epilog. Return a register of that
+/// compare to tell the pipeliner that the exit is decided at run time.
+unsigned AArch64InstrInfo::reduceLoopCount(
+    MachineBasicBlock &MBB, MachineInstr *IndVar, MachineInstr &Cmp,
+    SmallVectorImpl<MachineOperand> &Cond,
+    SmallVectorImpl<MachineInstr *> &PrevInsts, unsigned Iter,
+    unsigned MaxIter) const {
+  MachineBasicBlock *LoopBB = Cmp.getParent();
+  MachineBasicBlock *TBB = nullptr, *FBB = nullptr;
+  bool CantAnalyze = analyzeBranch(*LoopBB, TBB, FBB, Cond);
+  assert(!CantAnalyze && TBB == LoopBB && "Loop was not analyzed");
+  (void)CantAnalyze;
+  reverseBranchCondition(Cond);
+  PrevInsts.clear();
+
+  for (MachineInstr &MI : llvm::reverse(MBB)) {
+    if (!MI.modifiesRegister(AArch64::NZCV, &getRegisterInfo()))
+      continue;
+    assert(MI.getOpcode() == Cmp.getOpcode() && "Expected the loop compare");
+    for (const MachineOperand &MO : MI.uses())
+      if (MO.isReg() && TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+        return MO.getReg();
+    break;
+  }
+  // The prolog has no compare to test the exit with.
+  return 0;
+}
+
+bool AArch64InstrInfo::getBaseAndOffsetPosition(const MachineInstr &MI,
+                                                unsigned &BasePos,
+                                                unsigned &OffsetPos) const {
+  // The pipeliner adjusts the offset by a byte amount, so only the unscaled
+  // forms qualify.
+  if (!MI.mayLoadOrStore() || !isUnscaledLdSt(MI.getOpcode()) ||
+      MI.getNumExplicitOperands() != 3 || !MI.getOperand(1).isReg() ||
+      !MI.getOperand(2).isImm())
+    return false;
+  BasePos = 1;
+  OffsetPos = 2;
+  return true;
+}
+
+bool AArch64InstrInfo::getIncrementValue(const MachineInstr &MI,
+                                         int &Value) const {
+  bool IsSub;
+  switch (MI.getOpcode()) {
+  default:
+    return false;
+  case AArch64::ADDWri:
+  case AArch64::ADDXri:
+    IsSub = false;
+    break;
+  case AArch64::SUBWri:
+  case AArch64::SUBXri:
+    IsSub = true;
+    break;
+  }
+  if (!MI.getOperand(1).isReg() || !MI.getOperand(2).isImm())
+    return false;
+  int Imm = MI.getOperand(2).getImm()
+            << AArch64_AM::getShiftValue(MI.getOperand(3).getImm());
+  Value = IsSub ? -Imm : Imm;
+  return true;
+}
+
 // Find the original register that VReg is copied from.
 static unsigned removeCopies(const MachineRegisterInfo &MRI, unsigned VReg) {
   while (TargetRegisterInfo::isVirtualRegister(VReg)) {
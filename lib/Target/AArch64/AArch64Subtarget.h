@@ -198,6 +198,14 @@ public:
   bool enablePostRAScheduler() const override {
     return UsePostRAScheduler;
   }
+  /// Software pipelining pays off on in-order cores, where the schedule of
+  /// the loop body is what the hardware executes.
+  bool enableMachinePipeliner() const override {
+    return !getSchedModel().isOutOfOrder();
+  }
+
+  /// The loop compare sets the flags that the branch of the kernel reads.
+  bool enablePipelinerKernelChecks() const override { return true; }
 
   /// Returns ARM processor family.
   /// Avoid this function! CPU specifics should be kept local to this class
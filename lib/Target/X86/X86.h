@@ -127,6 +127,11 @@ InstructionSelector *createX86InstructionSelector(const X86TargetMachine &TM,
 
 void initializeEvexToVexInstPassPass(PassRegistry &);
 
+/// This pass combines generic machine instructions before the GlobalISel
+/// legalizer.
+FunctionPass *createX86PreLegalizeCombiner();
+void initializeX86PreLegalizerCombinerPass(PassRegistry &);
+
 FunctionPass *createX86SpeculativeLoadHardeningPass();
 
 } // End llvm namespace
@@ -2892,6 +2892,103 @@ unsigned X86InstrInfo::insertBranch(MachineBasicBlock &MBB,
   return Count;
 }
 
+/// Analyze a single block loop for the software pipeliner. The loop must end
+/// in a JCC that tests the flags set by a single compare in the loop. No other
+/// instruction may read EFLAGS, and no instruction may define another
+/// physical register, so everything but the compare can be moved between
+/// iterations. The branch is rewritten, if needed, so that it is taken to
+/// continue the loop.
+bool X86InstrInfo::analyzeLoop(MachineLoop &L, MachineInstr *&IndVarInst,
+                               MachineInstr *&CmpInst) const {
+  MachineBasicBlock *LoopBB = L.getHeader();
+  MachineBasicBlock *TBB = nullptr, *FBB = nullptr;
+  SmallVector<MachineOperand, 4> Cond;
+  if (L.getNumBlocks() != 1 ||
+      analyzeBranch(*LoopBB, TBB, FBB, Cond, /*AllowModify*/ false) ||
+      Cond.size() != 1 ||
+      (X86::CondCode)Cond[0].getImm() > X86::LAST_VALID_COND)
+    return true;
+
+  if (TBB != LoopBB && FBB != LoopBB)
+    return true;
+
+  CmpInst = nullptr;
+  for (MachineInstr &MI : make_range(LoopBB->getFirstNonPHI(),
+                                     LoopBB->getFirstTerminator())) {
+    if (MI.isCall() || MI.hasUnmodeledSideEffects())
+      return true;
+    for (const MachineOperand &MO : MI.operands()) {
+      if (!MO.isReg() || !TargetRegisterInfo::isPhysicalRegister(MO.getReg()))
+        continue;
+      if (MO.getReg() == X86::EFLAGS) {
+        if (MO.readsReg())
+          return true;
+        // The branch reads the flags of the last definition.
+        CmpInst = &MI;
+      } else if (MO.isDef())
+        return true;
+    }
+  }
+  if (!CmpInst)
+    return true;
+
+  // reduceLoopCount identifies the exit test by a register of the compare.
+  const MachineRegisterInfo &MRI = LoopBB->getParent()->getRegInfo();
+  IndVarInst = nullptr;
+  bool HasVReg = false;
+  for (const MachineOperand &MO : CmpInst->uses()) {
+    if (!MO.isReg() || !TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+      continue;
+    HasVReg = true;
+    MachineInstr *DefMI = MRI.getVRegDef(MO.getReg());
+    if (!IndVarInst && DefMI && DefMI->getParent() == LoopBB &&
+        !DefMI->isPHI())
+      IndVarInst = DefMI;
+  }
+  if (!HasVReg)
+    return true;
+
+  // Only rewrite the branch once the loop is known to be accepted.
+  if (TBB != LoopBB) {
+    reverseBranchCondition(Cond);
+    DebugLoc DL = LoopBB->getFirstTerminator()->getDebugLoc();
+    removeBranch(*LoopBB);
+    insertBranch(*LoopBB, LoopBB, TBB, Cond, DL);
+  }
+  return false;
+}
+
+/// Add the exit test to a prolog block that the pipeliner peeled from the
+/// loop. The trip count is not known, so the copy of the loop compare in the
+/// prolog decides whether to branch to the epilog. Return a register of that
+/// compare to tell the pipeliner that the exit is decided at run time.
+unsigned X86InstrInfo::reduceLoopCount(
+    MachineBasicBlock &MBB, MachineInstr *IndVar, MachineInstr &Cmp,
+    SmallVectorImpl<MachineOperand> &Cond,
+    SmallVectorImpl<MachineInstr *> &PrevInsts, unsigned Iter,
+    unsigned MaxIter) const {
+  MachineBasicBlock *LoopBB = Cmp.getParent();
+  MachineBasicBlock *TBB = nullptr, *FBB = nullptr;
+  bool CantAnalyze = analyzeBranch(*LoopBB, TBB, FBB, Cond,
+                                   /*AllowModify*/ false);
+  assert(!CantAnalyze && TBB == LoopBB && "Loop was not analyzed");
+  (void)CantAnalyze;
+  reverseBranchCondition(Cond);
+  PrevInsts.clear();
+
+  for (MachineInstr &MI : llvm::reverse(MBB)) {
+    if (!MI.modifiesRegister(X86::EFLAGS, &RI))
+      continue;
+    assert(MI.getOpcode() == Cmp.getOpcode() && "Expected the loop compare");
+    for (const MachineOperand &MO : MI.uses())
+      if (MO.isReg() && TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+        return MO.getReg();
+    break;
+  }
+  // The prolog has no compare to test the exit with.
+  return 0;
+}
+
 bool X86InstrInfo::
 canInsertSelect(const MachineBasicBlock &MBB,
                 ArrayRef<MachineOperand> Cond,
@@ -3274,6 +3371,73 @@ bool X86InstrInfo::getMemOpBaseRegImmOfs(MachineInstr &MemOp, unsigned &BaseReg,
   return true;
 }
 
+bool X86InstrInfo::getBaseAndOffsetPosition(const MachineInstr &MI,
+                                            unsigned &BasePos,
+                                            unsigned &OffsetPos) const {
+  if (!MI.mayLoadOrStore())
+    return false;
+  const MCInstrDesc &Desc = MI.getDesc();
+  int MemRefBegin = X86II::getMemoryOperandNo(Desc.TSFlags);
+  if (MemRefBegin < 0)
+    return false;
+  MemRefBegin += X86II::getOperandBias(Desc);
+
+  // Only a base register and an immediate displacement, like
+  // getMemOpBaseRegImmOfs.
+  if (!MI.getOperand(MemRefBegin + X86::AddrBaseReg).isReg() ||
+      MI.getOperand(MemRefBegin + X86::AddrScaleAmt).getImm() != 1 ||
+      MI.getOperand(MemRefBegin + X86::AddrIndexReg).getReg() !=
+          X86::NoRegister ||
+      !MI.getOperand(MemRefBegin + X86::AddrDisp).isImm() ||
+      MI.getOperand(MemRefBegin + X86::AddrSegmentReg).getReg() !=
+          X86::NoRegister)
+    return false;
+  BasePos = MemRefBegin + X86::AddrBaseReg;
+  OffsetPos = MemRefBegin + X86::AddrDisp;
+  return true;
+}
+
+bool X86InstrInfo::getIncrementValue(const MachineInstr &MI,
+                                     int &Value) const {
+  switch (MI.getOpcode()) {
+  default:
+    return false;
+  case X86::INC32r:
+  case X86::INC64r:
+    Value = 1;
+    return true;
+  case X86::DEC32r:
+  case X86::DEC64r:
+    Value = -1;
+    return true;
+  case X86::ADD32ri:
+  case X86::ADD32ri8:
+  case X86::ADD64ri8:
+  case X86::ADD64ri32:
+    if (!MI.getOperand(2).isImm())
+      return false;
+    Value = MI.getOperand(2).getImm();
+    return true;
+  case X86::SUB32ri:
+  case X86::SUB32ri8:
+  case X86::SUB64ri8:
+  case X86::SUB64ri32:
+    if (!MI.getOperand(2).isImm())
+      return false;
+    Value = -MI.getOperand(2).getImm();
+    return true;
+  case X86::LEA32r:
+  case X86::LEA64r:
+    if (!MI.getOperand(1 + X86::AddrBaseReg).isReg() ||
+        MI.getOperand(1 + X86::AddrIndexReg).getReg() != X86::NoRegister ||
+        !MI.getOperand(1 + X86::AddrDisp).isImm() ||
+        MI.getOperand(1 + X86::AddrSegmentReg).getReg() != X86::NoRegister)
+      return false;
+    Value = MI.getOperand(1 + X86::AddrDisp).getImm();
+    return true;
+  }
+}
+
 static unsigned getStoreRegOpcode(unsigned SrcReg,
                                   const TargetRegisterClass *RC,
                                   bool isStackAligned,
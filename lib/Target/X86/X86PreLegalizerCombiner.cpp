@@ -0,0 +1,116 @@
+//=== lib/Target/X86/X86PreLegalizerCombiner.cpp --------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass does combining of machine instructions at the generic MI level,
+// before the legalizer. The combines are generated from the rules in
+// X86Combine.td.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86.h"
+#include "X86TargetMachine.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/CodeGen/GlobalISel/Combiner.h"
+#include "llvm/CodeGen/GlobalISel/CombinerHelper.h"
+#include "llvm/CodeGen/GlobalISel/CombinerInfo.h"
+#include "llvm/CodeGen/GlobalISel/CombinerMatchTable.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/TargetPassConfig.h"
+#include "llvm/Support/CodeGenCoverage.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "x86-prelegalizer-combiner"
+
+using namespace llvm;
+
+#define X86PRELEGALIZERCOMBINERHELPER_GENCOMBINERHELPER_H
+#include "X86GenGICombiner.inc"
+#undef X86PRELEGALIZERCOMBINERHELPER_GENCOMBINERHELPER_H
+
+#define X86PRELEGALIZERCOMBINERHELPER_GENCOMBINERHELPER_CPP
+#include "X86GenGICombiner.inc"
+#undef X86PRELEGALIZERCOMBINERHELPER_GENCOMBINERHELPER_CPP
+
+namespace {
+class X86PreLegalizerCombinerInfo : public CombinerInfo {
+  X86GenPreLegalizerCombinerHelper Generated;
+  CodeGenCoverage &CoverageInfo;
+
+public:
+  X86PreLegalizerCombinerInfo(CodeGenCoverage &CoverageInfo)
+      : CombinerInfo(/*AllowIllegalOps*/ true, /*ShouldLegalizeIllegal*/ false,
+                     /*LegalizerInfo*/ nullptr),
+        CoverageInfo(CoverageInfo) {}
+  bool combine(MachineInstr &MI, MachineIRBuilder &B) const override;
+};
+
+bool X86PreLegalizerCombinerInfo::combine(MachineInstr &MI,
+                                          MachineIRBuilder &B) const {
+  CombinerHelper Helper(B);
+  return Generated.tryCombineAll(MI, Helper, CoverageInfo);
+}
+
+// Pass boilerplate
+// ================
+
+class X86PreLegalizerCombiner : public MachineFunctionPass {
+public:
+  static char ID;
+
+  X86PreLegalizerCombiner();
+
+  StringRef getPassName() const override { return "X86PreLegalizerCombiner"; }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+};
+} // end anonymous namespace
+
+void X86PreLegalizerCombiner::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<TargetPassConfig>();
+  AU.setPreservesCFG();
+  getSelectionDAGFallbackAnalysisUsage(AU);
+  MachineFunctionPass::getAnalysisUsage(AU);
+}
+
+X86PreLegalizerCombiner::X86PreLegalizerCombiner() : MachineFunctionPass(ID) {
+  initializeX86PreLegalizerCombinerPass(*PassRegistry::getPassRegistry());
+}
+
+bool X86PreLegalizerCombiner::runOnMachineFunction(MachineFunction &MF) {
+  if (MF.getProperties().hasProperty(
+          MachineFunctionProperties::Property::FailedISel))
+    return false;
+  auto *TPC = &getAnalysis<TargetPassConfig>();
+  CodeGenCoverage CoverageInfo;
+  X86PreLegalizerCombinerInfo PCInfo(CoverageInfo);
+  Combiner C(PCInfo, TPC);
+  bool Changed = C.combineMachineInstrs(MF);
+  emitGICombinerCoverage(CoverageInfo, getPassName());
+  return Changed;
+}
+
+char X86PreLegalizerCombiner::ID = 0;
+INITIALIZE_PASS_BEGIN(X86PreLegalizerCombiner, DEBUG_TYPE,
+                      "Combine X86 machine instrs before legalization", false,
+                      false)
+INITIALIZE_PASS_DEPENDENCY(TargetPassConfig)
+INITIALIZE_PASS_END(X86PreLegalizerCombiner, DEBUG_TYPE,
+                    "Combine X86 machine instrs before legalization", false,
+                    false)
+
+namespace llvm {
+FunctionPass *createX86PreLegalizeCombiner() {
+  return new X86PreLegalizerCombiner();
+}
+} // end namespace llvm
@@ -22,6 +22,7 @@
 #include "llvm/ADT/Triple.h"
 #include "llvm/CodeGen/GlobalISel/CallLowering.h"
 #include "llvm/CodeGen/GlobalISel/InstructionSelect.h"
+#include "llvm/CodeGen/ScheduleDAGInstrs.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/ConstantRange.h"
 #include "llvm/IR/Function.h"
@@ -325,3 +326,37 @@ const RegisterBankInfo *X86Subtarget::getRegBankInfo() const {
 bool X86Subtarget::enableEarlyIfConversion() const {
   return hasCMov() && X86EarlyIfConv;
 }
+
+namespace {
+/// Most X86 arithmetic clobbers EFLAGS, and the output dependences between
+/// those clobbers would serialize every iteration of a pipelined loop. Drop
+/// the ones from a dead definition to a definition that no instruction in
+/// the loop reads. A definition that is read stays ordered after earlier
+/// clobbers and, through its uses, before later ones. The flags of the loop
+/// compare are only read by the branch, and the pipeliner checks that no
+/// clobber is scheduled between the two.
+struct DeadFlagsMutation : public ScheduleDAGMutation {
+  void apply(ScheduleDAGInstrs *DAG) override {
+    for (SUnit &SU : DAG->SUnits) {
+      if (!SU.isInstr() ||
+          llvm::any_of(SU.Succs, [](const SDep &D) {
+            return D.getKind() == SDep::Data && D.getReg() == X86::EFLAGS;
+          }))
+        continue;
+      SmallVector<SDep, 4> Erase;
+      for (const SDep &D : SU.Preds)
+        if (D.getKind() == SDep::Output && D.getReg() == X86::EFLAGS &&
+            D.getSUnit()->isInstr() &&
+            D.getSUnit()->getInstr()->registerDefIsDead(X86::EFLAGS))
+          Erase.push_back(D);
+      for (const SDep &E : Erase)
+        SU.removePred(E);
+    }
+  }
+};
+} // end anonymous namespace
+
+void X86Subtarget::getSMSMutations(
+    std::vector<std::unique_ptr<ScheduleDAGMutation>> &Mutations) const {
+  Mutations.push_back(llvm::make_unique<DeadFlagsMutation>());
+}
@@ -809,6 +809,19 @@ public:
   /// Enable the MachineScheduler pass for all X86 subtargets.
   bool enableMachineScheduler() const override { return true; }
 
+  /// Software pipeline loops only for in-order subtargets, whose schedule
+  /// model describes what the hardware actually issues.
+  bool enableMachinePipeliner() const override {
+    return !getSchedModel().isOutOfOrder();
+  }
+
+  /// The loop compare sets the flags that the branch of the kernel reads.
+  bool enablePipelinerKernelChecks() const override { return true; }
+
+  void getSMSMutations(
+      std::vector<std::unique_ptr<ScheduleDAGMutation>> &Mutations)
+      const override;
+
   // TODO: Update the regression tests and return true.
   bool supportPrintSchedInfo() const override { return false; }
 
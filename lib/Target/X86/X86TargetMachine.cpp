@@ -58,6 +58,11 @@ static cl::opt<bool> EnableSpeculativeLoadHardening(
     "x86-speculative-load-hardening",
     cl::desc("Enable speculative load hardening"), cl::init(false), cl::Hidden);
 
+static cl::opt<bool> EnableMachinePipeliner(
+    "x86-enable-pipeliner",
+    cl::desc("Enable the machine pipeliner for in-order subtargets"),
+    cl::init(false), cl::Hidden);
+
 namespace llvm {
 
 void initializeWinEHStatePassPass(PassRegistry &);
@@ -90,6 +95,7 @@ extern "C" void LLVMInitializeX86Target() {
   initializeX86DomainReassignmentPass(PR);
   initializeX86AvoidSFBPassPass(PR);
   initializeX86FlagsCopyLoweringPassPass(PR);
+  initializeX86PreLegalizerCombinerPass(PR);
 }
 
 static std::unique_ptr<TargetLoweringObjectFile> createTLOF(const Triple &TT) {
@@ -360,6 +366,7 @@ public:
   void addIRPasses() override;
   bool addInstSelector() override;
   bool addIRTranslator() override;
+  void addPreLegalizeMachineIR() override;
   bool addLegalizeMachineIR() override;
   bool addRegBankSelect() override;
   bool addGlobalInstructionSelect() override;
@@ -427,6 +434,11 @@ bool X86PassConfig::addIRTranslator() {
   return false;
 }
 
+void X86PassConfig::addPreLegalizeMachineIR() {
+  if (getOptLevel() != CodeGenOpt::None)
+    addPass(createX86PreLegalizeCombiner());
+}
+
 bool X86PassConfig::addLegalizeMachineIR() {
   addPass(new Legalizer());
   return false;
@@ -459,6 +471,9 @@ bool X86PassConfig::addPreISel() {
 }
 
 void X86PassConfig::addPreRegAlloc() {
+  if (getOptLevel() != CodeGenOpt::None && EnableMachinePipeliner)
+    addPass(&MachinePipelinerID);
+
   if (getOptLevel() != CodeGenOpt::None) {
     addPass(&LiveRangeShrinkID);
     addPass(createX86FixupSetCC());
@@ -0,0 +1,501 @@
+//===- CodeLayout.cpp - Code layout by the Ext-TSP model ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the Ext-TSP block ordering of "Improved Basic Block
+// Reordering" by Newell and Pupyrev (IEEE Transactions on Computers, 2020).
+//
+// A jump from a block ending at address S to a block starting at address D
+// that is taken C times contributes to the score
+//
+//   FallthroughWeight * C                             if S == D,
+//   ForwardWeight * (1 - (D - S) / ForwardDist) * C   if S < D <= S + ForwardDist,
+//   BackwardWeight * (1 - (S - D) / BackwardDist) * C if D < S <= D + BackwardDist.
+//
+// The algorithm starts with one chain per block and greedily merges the pair
+// of chains that gains the most score, until no merge gains anything. Two
+// chains X and Y may be merged as X Y, or with X split into X1 X2 as X1 Y X2,
+// Y X2 X1 or X2 X1 Y. The remaining chains are then ordered by decreasing
+// execution density.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/CodeLayout.h"
+#include "llvm/Support/CommandLine.h"
+#include <algorithm>
+#include <cassert>
+#include <memory>
+
+using namespace llvm;
+
+static cl::opt<double> FallthroughWeight(
+    "ext-tsp-fallthrough-weight", cl::init(1.0), cl::Hidden,
+    cl::desc("The weight of fall-through jumps in the Ext-TSP score"));
+
+static cl::opt<double> ForwardWeight(
+    "ext-tsp-forward-weight", cl::init(0.1), cl::Hidden,
+    cl::desc("The weight of short forward jumps in the Ext-TSP score"));
+
+static cl::opt<double> BackwardWeight(
+    "ext-tsp-backward-weight", cl::init(0.1), cl::Hidden,
+    cl::desc("The weight of short backward jumps in the Ext-TSP score"));
+
+static cl::opt<unsigned> ForwardDistance(
+    "ext-tsp-forward-distance", cl::init(1024), cl::Hidden,
+    cl::desc("The longest forward jump, in bytes, that adds to the Ext-TSP "
+             "score"));
+
+static cl::opt<unsigned> BackwardDistance(
+    "ext-tsp-backward-distance", cl::init(640), cl::Hidden,
+    cl::desc("The longest backward jump, in bytes, that adds to the Ext-TSP "
+             "score"));
+
+static cl::opt<unsigned> ChainSplitThreshold(
+    "ext-tsp-chain-split-threshold", cl::init(128), cl::Hidden,
+    cl::desc("The largest chain that is split at every position when "
+             "looking for the best merge"));
+
+/// Scores that differ by less than this are considered equal.
+static const double EPS = 1e-8;
+
+/// Return the score of a jump taken \p Count times from a block ending at
+/// \p SrcEnd to a block starting at \p DstAddr.
+static double getJumpScore(uint64_t SrcEnd, uint64_t DstAddr, uint64_t Count) {
+  if (SrcEnd == DstAddr)
+    return FallthroughWeight * Count;
+  if (SrcEnd < DstAddr) {
+    uint64_t Dist = DstAddr - SrcEnd;
+    if (Dist > ForwardDistance)
+      return 0;
+    return ForwardWeight * (1.0 - double(Dist) / ForwardDistance) * Count;
+  }
+  uint64_t Dist = SrcEnd - DstAddr;
+  if (Dist > BackwardDistance)
+    return 0;
+  return BackwardWeight * (1.0 - double(Dist) / BackwardDistance) * Count;
+}
+
+namespace {
+
+/// The ways of merging chain X with chain Y; X1 and X2 are the parts of X
+/// before and after the split offset.
+enum class MergeType { X_Y, X1_Y_X2, Y_X2_X1, X2_X1_Y };
+
+struct Chain;
+struct ChainEdge;
+
+struct Block {
+  uint64_t Size;
+  uint64_t Count;
+  Chain *CurChain = nullptr;
+  size_t CurIndex = 0;
+  /// Whether the block must stay followed by the next block of its chain.
+  bool HasForcedSucc = false;
+  bool HasForcedPred = false;
+  std::vector<unsigned> InJumps;
+  std::vector<unsigned> OutJumps;
+};
+
+struct MergeGain {
+  double Score = -1.0;
+  size_t Offset = 0;
+  MergeType Type = MergeType::X_Y;
+};
+
+/// The jumps between the blocks of two chains, or within a chain if both
+/// ends are the same.
+struct ChainEdge {
+  Chain *A;
+  Chain *B;
+  std::vector<unsigned> Jumps;
+  /// The best gain of merging A before B, and of merging B before A.
+  MergeGain Cached[2];
+  bool IsCached[2] = {false, false};
+
+  ChainEdge(Chain *A, Chain *B) : A(A), B(B) {}
+
+  unsigned getDirection(const Chain *Pred) const { return Pred == A ? 0 : 1; }
+  void invalidate() { IsCached[0] = IsCached[1] = false; }
+};
+
+struct Chain {
+  unsigned Id;
+  std::vector<unsigned> Blocks;
+  uint64_t Size = 0;
+  uint64_t Count = 0;
+  double Score = 0;
+  /// The edges to the chains this chain has jumps to or from, including
+  /// itself.
+  std::vector<std::pair<Chain *, ChainEdge *>> Edges;
+
+  bool isEntry() const { return Blocks.front() == 0; }
+  double getDensity() const { return double(Count) / Size; }
+
+  ChainEdge *getEdge(const Chain *Other) const {
+    for (const auto &E : Edges)
+      if (E.first == Other)
+        return E.second;
+    return nullptr;
+  }
+
+  void removeEdge(const Chain *Other) {
+    for (auto I = Edges.begin(), E = Edges.end(); I != E; ++I)
+      if (I->first == Other) {
+        Edges.erase(I);
+        return;
+      }
+  }
+};
+
+class ExtTspLayout {
+  ArrayRef<ExtTspEdge> Jumps;
+  std::vector<Block> Blocks;
+  std::vector<Chain> AllChains;
+  std::vector<std::unique_ptr<ChainEdge>> AllEdges;
+  /// The chains that have not been merged into another chain.
+  std::vector<Chain *> Chains;
+  /// Scratch space for the block addresses of a candidate layout.
+  std::vector<uint64_t> Addr;
+  std::vector<unsigned> Merged;
+
+public:
+  ExtTspLayout(ArrayRef<uint64_t> NodeSizes, ArrayRef<uint64_t> NodeCounts,
+               ArrayRef<ExtTspEdge> Edges);
+
+  void mergeForcedPairs(ArrayRef<std::pair<unsigned, unsigned>> ForcedPairs);
+  void mergeChains();
+  std::vector<unsigned> getOrder();
+
+private:
+  ChainEdge *getOrCreateEdge(Chain *X, Chain *Y);
+  double computeScore(ArrayRef<unsigned> Order,
+                      ArrayRef<const std::vector<unsigned> *> JumpLists);
+  void buildMerged(const Chain &X, const Chain &Y, size_t Offset,
+                   MergeType Type);
+  MergeGain computeMergeGain(Chain *Pred, Chain *Succ, ChainEdge *Edge);
+  MergeGain getMergeGain(Chain *Pred, Chain *Succ, ChainEdge *Edge);
+  void merge(Chain *X, Chain *Y, size_t Offset, MergeType Type);
+};
+
+} // end anonymous namespace
+
+ExtTspLayout::ExtTspLayout(ArrayRef<uint64_t> NodeSizes,
+                           ArrayRef<uint64_t> NodeCounts,
+                           ArrayRef<ExtTspEdge> Edges)
+    : Jumps(Edges) {
+  unsigned NumNodes = NodeSizes.size();
+  assert(NodeCounts.size() == NumNodes && "Mismatched node data");
+  Blocks.resize(NumNodes);
+  Addr.resize(NumNodes);
+  AllChains.resize(NumNodes);
+  for (unsigned I = 0; I != NumNodes; ++I) {
+    // Empty blocks still separate their neighbours.
+    Blocks[I].Size = std::max<uint64_t>(NodeSizes[I], 1);
+    Blocks[I].Count = NodeCounts[I];
+    Chain &C = AllChains[I];
+    C.Id = I;
+    C.Blocks.push_back(I);
+    C.Size = Blocks[I].Size;
+    C.Count = Blocks[I].Count;
+    Blocks[I].CurChain = &C;
+    Chains.push_back(&C);
+  }
+
+  for (unsigned J = 0, E = Jumps.size(); J != E; ++J) {
+    const ExtTspEdge &Jump = Jumps[J];
+    assert(Jump.Src < NumNodes && Jump.Dst < NumNodes && "Invalid edge");
+    // Jumps that are never taken do not change the score.
+    if (!Jump.Count)
+      continue;
+    Blocks[Jump.Src].OutJumps.push_back(J);
+    Blocks[Jump.Dst].InJumps.push_back(J);
+    getOrCreateEdge(Blocks[Jump.Src].CurChain, Blocks[Jump.Dst].CurChain)
+        ->Jumps.push_back(J);
+  }
+
+  for (Chain *C : Chains)
+    if (ChainEdge *Self = C->getEdge(C))
+      C->Score = computeScore(C->Blocks, {&Self->Jumps});
+}
+
+ChainEdge *ExtTspLayout::getOrCreateEdge(Chain *X, Chain *Y) {
+  if (ChainEdge *E = X->getEdge(Y))
+    return E;
+  AllEdges.push_back(llvm::make_unique<ChainEdge>(X, Y));
+  ChainEdge *E = AllEdges.back().get();
+  X->Edges.push_back({Y, E});
+  if (X != Y)
+    Y->Edges.push_back({X, E});
+  return E;
+}
+
+double
+ExtTspLayout::computeScore(ArrayRef<unsigned> Order,
+                           ArrayRef<const std::vector<unsigned> *> JumpLists) {
+  uint64_t Cur = 0;
+  for (unsigned B : Order) {
+    Addr[B] = Cur;
+    Cur += Blocks[B].Size;
+  }
+  double Score = 0;
+  for (const std::vector<unsigned> *List : JumpLists)
+    for (unsigned J : *List) {
+      const ExtTspEdge &Jump = Jumps[J];
+      Score += getJumpScore(Addr[Jump.Src] + Blocks[Jump.Src].Size,
+                            Addr[Jump.Dst], Jump.Count);
+    }
+  return Score;
+}
+
+void ExtTspLayout::buildMerged(const Chain &X, const Chain &Y, size_t Offset,
+                               MergeType Type) {
+  auto X1Begin = X.Blocks.begin(), X1End = X.Blocks.begin() + Offset;
+  auto X2Begin = X1End, X2End = X.Blocks.end();
+  Merged.clear();
+  switch (Type) {
+  case MergeType::X_Y:
+    Merged.insert(Merged.end(), X.Blocks.begin(), X.Blocks.end());
+    Merged.insert(Merged.end(), Y.Blocks.begin(), Y.Blocks.end());
+    break;
+  case MergeType::X1_Y_X2:
+    Merged.insert(Merged.end(), X1Begin, X1End);
+    Merged.insert(Merged.end(), Y.Blocks.begin(), Y.Blocks.end());
+    Merged.insert(Merged.end(), X2Begin, X2End);
+    break;
+  case MergeType::Y_X2_X1:
+    Merged.insert(Merged.end(), Y.Blocks.begin(), Y.Blocks.end());
+    Merged.insert(Merged.end(), X2Begin, X2End);
+    Merged.insert(Merged.end(), X1Begin, X1End);
+    break;
+  case MergeType::X2_X1_Y:
+    Merged.insert(Merged.end(), X2Begin, X2End);
+    Merged.insert(Merged.end(), X1Begin, X1End);
+    Merged.insert(Merged.end(), Y.Blocks.begin(), Y.Blocks.end());
+    break;
+  }
+}
+
+MergeGain ExtTspLayout::computeMergeGain(Chain *Pred, Chain *Succ,
+                                         ChainEdge *Edge) {
+  static const std::vector<unsigned> NoJumps;
+  ChainEdge *PredSelf = Pred->getEdge(Pred);
+  ChainEdge *SuccSelf = Succ->getEdge(Succ);
+  const std::vector<const std::vector<unsigned> *> JumpLists = {
+      PredSelf ? &PredSelf->Jumps : &NoJumps,
+      SuccSelf ? &SuccSelf->Jumps : &NoJumps, &Edge->Jumps};
+  bool HasEntry = Pred->isEntry() || Succ->isEntry();
+  size_t PredSize = Pred->Blocks.size();
+
+  MergeGain Best;
+  auto TryMerge = [&](size_t Offset, MergeType Type) {
+    if (Type != MergeType::X_Y) {
+      // Splitting must leave two non-empty parts and keep forced pairs.
+      if (Offset == 0 || Offset >= PredSize ||
+          Blocks[Pred->Blocks[Offset - 1]].HasForcedSucc)
+        return;
+    }
+    buildMerged(*Pred, *Succ, Offset, Type);
+    if (HasEntry && Merged.front() != 0)
+      return;
+    double Gain = computeScore(Merged, JumpLists) - Pred->Score - Succ->Score;
+    if (Gain > Best.Score + EPS) {
+      Best.Score = Gain;
+      Best.Offset = Offset;
+      Best.Type = Type;
+    }
+  };
+
+  TryMerge(0, MergeType::X_Y);
+
+  // Place Succ right after a block of Pred that jumps to its first block, or
+  // right before a block of Pred that its last block jumps to.
+  for (unsigned J : Blocks[Succ->Blocks.front()].InJumps) {
+    const Block &Src = Blocks[Jumps[J].Src];
+    if (Src.CurChain != Pred)
+      continue;
+    TryMerge(Src.CurIndex + 1, MergeType::X1_Y_X2);
+    TryMerge(Src.CurIndex + 1, MergeType::X2_X1_Y);
+  }
+  for (unsigned J : Blocks[Succ->Blocks.back()].OutJumps) {
+    const Block &Dst = Blocks[Jumps[J].Dst];
+    if (Dst.CurChain != Pred)
+      continue;
+    TryMerge(Dst.CurIndex, MergeType::X1_Y_X2);
+    TryMerge(Dst.CurIndex, MergeType::Y_X2_X1);
+  }
+
+  // Try all splits of chains that are small enough.
+  if (PredSize <= ChainSplitThreshold)
+    for (size_t Offset = 1; Offset < PredSize; ++Offset) {
+      TryMerge(Offset, MergeType::X1_Y_X2);
+      TryMerge(Offset, MergeType::Y_X2_X1);
+      TryMerge(Offset, MergeType::X2_X1_Y);
+    }
+  return Best;
+}
+
+MergeGain ExtTspLayout::getMergeGain(Chain *Pred, Chain *Succ,
+                                     ChainEdge *Edge) {
+  unsigned Dir = Edge->getDirection(Pred);
+  if (!Edge->IsCached[Dir]) {
+    Edge->Cached[Dir] = computeMergeGain(Pred, Succ, Edge);
+    Edge->IsCached[Dir] = true;
+  }
+  return Edge->Cached[Dir];
+}
+
+void ExtTspLayout::merge(Chain *X, Chain *Y, size_t Offset, MergeType Type) {
+  assert(X != Y && "Merging a chain with itself");
+  buildMerged(*X, *Y, Offset, Type);
+  X->Blocks = Merged;
+  for (size_t I = 0, E = X->Blocks.size(); I != E; ++I) {
+    Block &B = Blocks[X->Blocks[I]];
+    B.CurChain = X;
+    B.CurIndex = I;
+  }
+  X->Size += Y->Size;
+  X->Count += Y->Count;
+
+  // The jumps between X and Y, and those within Y, are now within X.
+  ChainEdge *Self = nullptr;
+  if (ChainEdge *XY = X->getEdge(Y)) {
+    Self = getOrCreateEdge(X, X);
+    Self->Jumps.insert(Self->Jumps.end(), XY->Jumps.begin(), XY->Jumps.end());
+    X->removeEdge(Y);
+  }
+  if (ChainEdge *YSelf = Y->getEdge(Y)) {
+    Self = getOrCreateEdge(X, X);
+    Self->Jumps.insert(Self->Jumps.end(), YSelf->Jumps.begin(),
+                       YSelf->Jumps.end());
+  }
+
+  // Redirect the other edges of Y to X.
+  for (const auto &E : Y->Edges) {
+    Chain *Z = E.first;
+    if (Z == X || Z == Y)
+      continue;
+    if (ChainEdge *XZ = X->getEdge(Z)) {
+      XZ->Jumps.insert(XZ->Jumps.end(), E.second->Jumps.begin(),
+                       E.second->Jumps.end());
+      Z->removeEdge(Y);
+      continue;
+    }
+    ChainEdge *YZ = E.second;
+    if (YZ->A == Y)
+      YZ->A = X;
+    else
+      YZ->B = X;
+    X->Edges.push_back({Z, YZ});
+    for (auto &ZE : Z->Edges)
+      if (ZE.first == Y)
+        ZE.first = X;
+  }
+  Y->Edges.clear();
+  Y->Blocks.clear();
+
+  if (!Self)
+    Self = X->getEdge(X);
+  X->Score = Self ? computeScore(X->Blocks, {&Self->Jumps}) : 0;
+
+  // Every gain involving X has changed.
+  for (const auto &E : X->Edges)
+    E.second->invalidate();
+  Chains.erase(std::find(Chains.begin(), Chains.end(), Y));
+}
+
+void ExtTspLayout::mergeForcedPairs(
+    ArrayRef<std::pair<unsigned, unsigned>> ForcedPairs) {
+  for (const auto &P : ForcedPairs) {
+    Block &Src = Blocks[P.first];
+    Block &Dst = Blocks[P.second];
+    // The entry block stays first; a block has one layout neighbour on each
+    // side.
+    if (P.first == P.second || P.second == 0 || Src.HasForcedSucc ||
+        Dst.HasForcedPred)
+      continue;
+    Chain *X = Src.CurChain, *Y = Dst.CurChain;
+    if (X == Y || X->Blocks.back() != P.first || Y->Blocks.front() != P.second)
+      continue;
+    merge(X, Y, 0, MergeType::X_Y);
+    Src.HasForcedSucc = true;
+    Dst.HasForcedPred = true;
+  }
+}
+
+void ExtTspLayout::mergeChains() {
+  while (Chains.size() > 1) {
+    Chain *BestPred = nullptr, *BestSucc = nullptr;
+    MergeGain BestGain;
+    for (Chain *Pred : Chains) {
+      for (const auto &E : Pred->Edges) {
+        Chain *Succ = E.first;
+        if (Succ == Pred)
+          continue;
+        MergeGain Gain = getMergeGain(Pred, Succ, E.second);
+        if (Gain.Score <= EPS || Gain.Score <= BestGain.Score + EPS)
+          continue;
+        BestPred = Pred;
+        BestSucc = Succ;
+        BestGain = Gain;
+      }
+    }
+    if (!BestPred)
+      break;
+    merge(BestPred, BestSucc, BestGain.Offset, BestGain.Type);
+  }
+}
+
+std::vector<unsigned> ExtTspLayout::getOrder() {
+  // The entry chain goes first, then the chains that execute most often per
+  // byte. Chains of equal density, such as those that never execute, keep
+  // their original order.
+  std::vector<Chain *> Sorted(Chains);
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [](const Chain *L, const Chain *R) {
+                     if (L->isEntry() != R->isEntry())
+                       return L->isEntry();
+                     double DL = L->getDensity(), DR = R->getDensity();
+                     if (DL != DR)
+                       return DL > DR;
+                     return L->Id < R->Id;
+                   });
+  std::vector<unsigned> Order;
+  Order.reserve(Blocks.size());
+  for (const Chain *C : Sorted)
+    Order.insert(Order.end(), C->Blocks.begin(), C->Blocks.end());
+  return Order;
+}
+
+std::vector<unsigned>
+llvm::applyExtTspLayout(ArrayRef<uint64_t> NodeSizes,
+                        ArrayRef<uint64_t> NodeCounts,
+                        ArrayRef<ExtTspEdge> Edges,
+                        ArrayRef<std::pair<unsigned, unsigned>> ForcedPairs) {
+  if (NodeSizes.empty())
+    return {};
+  ExtTspLayout Layout(NodeSizes, NodeCounts, Edges);
+  Layout.mergeForcedPairs(ForcedPairs);
+  Layout.mergeChains();
+  return Layout.getOrder();
+}
+
+double llvm::calcExtTspScore(ArrayRef<unsigned> Order,
+                             ArrayRef<uint64_t> NodeSizes,
+                             ArrayRef<ExtTspEdge> Edges) {
+  std::vector<uint64_t> Addr(NodeSizes.size());
+  uint64_t Cur = 0;
+  for (unsigned B : Order) {
+    Addr[B] = Cur;
+    Cur += std::max<uint64_t>(NodeSizes[B], 1);
+  }
+  double Score = 0;
+  for (const ExtTspEdge &E : Edges)
+    Score += getJumpScore(Addr[E.Src] + std::max<uint64_t>(NodeSizes[E.Src], 1),
+                          Addr[E.Dst], E.Count);
+  return Score;
+}
@@ -19,6 +19,8 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/IR/CallSite.h"
 #include "llvm/IR/Comdat.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/Constants.h"
@@ -92,12 +94,119 @@ static void addAllGlobalValueUsers(ClusterMapType &GVtoClusterMap,
   }
 }
 
+// Estimate how long the backend will take to compile GV. This is the number of
+// instructions, scaled by the profile: functions that are cold are usually
+// optimized for size, while hot ones go through the most expensive codegen.
+static uint64_t getCodeGenCost(const GlobalValue &GV, ProfileSummaryInfo &PSI) {
+  const Function *F = dyn_cast<Function>(&GV);
+  if (!F)
+    return 1;
+  uint64_t Cost = 1;
+  for (const BasicBlock &BB : *F)
+    Cost += BB.size();
+  if (PSI.hasProfileSummary()) {
+    if (PSI.isFunctionEntryHot(F))
+      Cost *= 2;
+    else if (PSI.isFunctionEntryCold(F))
+      Cost = Cost / 2 + 1;
+  }
+  return Cost;
+}
+
+// Assign the clusters in GVtoClusterMap, and every other definition in M on
+// its own, to N partitions of roughly equal codegen cost. The clusters are
+// placed from most to least expensive, each into the least loaded partition,
+// unless a partition that already holds one of its callers or callees has room
+// for it within the average load.
+static void balancePartitions(Module *M, ClusterMapType &GVtoClusterMap,
+                              ClusterIDMapType &ClusterIDMap, unsigned N) {
+  ProfileSummaryInfo PSI(*M);
+  std::vector<const GlobalValue *> Leaders;
+  DenseMap<const GlobalValue *, uint64_t> Costs;
+  uint64_t TotalCost = 0;
+  for (const GlobalValue &GV : M->global_values()) {
+    if (GV.isDeclaration() || isa<GlobalIFunc>(GV))
+      continue;
+    const GlobalValue *Leader = GVtoClusterMap.getOrInsertLeaderValue(&GV);
+    uint64_t Cost = getCodeGenCost(GV, PSI);
+    uint64_t &ClusterCost = Costs[Leader];
+    if (!ClusterCost)
+      Leaders.push_back(Leader);
+    ClusterCost += Cost;
+    TotalCost += Cost;
+  }
+
+  // Record the clusters that call each other.
+  DenseMap<const GlobalValue *, SmallVector<const GlobalValue *, 4>> Neighbours;
+  for (const Function &F : *M) {
+    if (F.isDeclaration())
+      continue;
+    const GlobalValue *Leader = GVtoClusterMap.getLeaderValue(&F);
+    for (const BasicBlock &BB : F)
+      for (const Instruction &I : BB) {
+        ImmutableCallSite CS(&I);
+        if (!CS)
+          continue;
+        const Function *Callee = CS.getCalledFunction();
+        if (!Callee || Callee->isDeclaration())
+          continue;
+        const GlobalValue *CalleeLeader = GVtoClusterMap.getLeaderValue(Callee);
+        if (CalleeLeader == Leader)
+          continue;
+        Neighbours[Leader].push_back(CalleeLeader);
+        Neighbours[CalleeLeader].push_back(Leader);
+      }
+  }
+
+  // Sort by decreasing cost. The sort is stable so that ties are broken by
+  // the order of the module.
+  std::stable_sort(Leaders.begin(), Leaders.end(),
+                   [&](const GlobalValue *A, const GlobalValue *B) {
+                     return Costs[A] > Costs[B];
+                   });
+
+  uint64_t Budget = (TotalCost + N - 1) / N;
+  std::vector<uint64_t> Loads(N, 0);
+  std::vector<unsigned> Affinity(N);
+  DenseMap<const GlobalValue *, unsigned> LeaderPartition;
+  for (const GlobalValue *Leader : Leaders) {
+    uint64_t Cost = Costs[Leader];
+    std::fill(Affinity.begin(), Affinity.end(), 0);
+    auto NI = Neighbours.find(Leader);
+    if (NI != Neighbours.end())
+      for (const GlobalValue *Neighbour : NI->second) {
+        auto PI = LeaderPartition.find(Neighbour);
+        if (PI != LeaderPartition.end())
+          ++Affinity[PI->second];
+      }
+
+    unsigned Best = 0;
+    for (unsigned I = 1; I < N; ++I)
+      if (Loads[I] < Loads[Best])
+        Best = I;
+    unsigned BestAffinity = 0;
+    for (unsigned I = 0; I < N; ++I)
+      if (Affinity[I] > BestAffinity && Loads[I] + Cost <= Budget) {
+        Best = I;
+        BestAffinity = Affinity[I];
+      }
+
+    LLVM_DEBUG(dbgs() << "Root[" << Best << "] cost(" << Cost << ") ----> "
+                      << Leader->getName() << "\n");
+    LeaderPartition[Leader] = Best;
+    Loads[Best] += Cost;
+    for (ClusterMapType::member_iterator MI = GVtoClusterMap.findLeader(Leader);
+         MI != GVtoClusterMap.member_end(); ++MI)
+      ClusterIDMap[*MI] = Best;
+  }
+}
+
 // Find partitions for module in the way that no locals need to be
 // globalized.
 // Try to balance pack those partitions into N files since this roughly equals
 // thread balancing for the backend codegen step.
 static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
-                           unsigned N) {
+                           unsigned N, bool Balance) {
   // At this point module should have the proper mix of globals and locals.
   // As we attempt to partition this module, we must not change any
   // locals to globals.
@@ -149,6 +258,9 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   llvm::for_each(M->globals(), recordGVSet);
   llvm::for_each(M->aliases(), recordGVSet);
 
+  if (Balance)
+    return balancePartitions(M, GVtoClusterMap, ClusterIDMap, N);
+
   // Assigned all GVs to merged clusters while balancing number of objects in
   // each.
   auto CompareClusters = [](const std::pair<unsigned, unsigned> &a,
@@ -252,7 +364,7 @@ static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
 void llvm::SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals) {
+    bool PreserveLocals, bool BalancePartitions) {
   if (!PreserveLocals) {
     for (Function &F : *M)
       externalize(&F);
@@ -267,7 +379,7 @@ void llvm::SplitModule(
   // This performs splitting without a need for externalization, which might not
   // always be possible.
   ClusterIDMapType ClusterIDMap;
-  findPartitions(M.get(), ClusterIDMap, N);
+  findPartitions(M.get(), ClusterIDMap, N, BalancePartitions);
 
   // FIXME: We should be able to reuse M as the last partition instead of
   // cloning it.
@@ -0,0 +1,31 @@
+; RUN: llvm-as < %s | llvm-dis -ir-memory-usage -disable-output 2>&1 \
+; RUN:   | FileCheck %s
+
+; CHECK:      IR memory usage:
+; CHECK-NEXT:   functions:         2
+; CHECK-NEXT:   instructions:      7
+; CHECK-NEXT:   operands:          10 (0 reserved)
+; CHECK-NEXT:   instruction bytes: {{[0-9]+}}
+; CHECK-NEXT:   operand bytes:     {{[0-9]+}} (0 reserved)
+; CHECK-NEXT:   name bytes:        {{[1-9][0-9]*}}
+; CHECK-NEXT:   total bytes:       {{[0-9]+}}
+; CHECK-NEXT:   bytes/instruction: {{[0-9]+\.[0-9]}}
+
+declare i32 @g(i32)
+
+define i32 @f(i32 %x, i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+a:
+  %y = call i32 @g(i32 %x)
+  br label %join
+b:
+  br label %join
+join:
+  %p = phi i32 [ %y, %a ], [ 0, %b ]
+  ret i32 %p
+}
+
+define void @h() {
+  ret void
+}
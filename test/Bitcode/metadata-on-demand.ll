@@ -0,0 +1,45 @@
+; Check that module-level metadata of a lazily loaded module is only loaded
+; when it is referenced.
+; REQUIRES: asserts
+; RUN: llvm-as -bitcode-mdindex-threshold=0 %s -o %t.bc
+
+; Only load the metadata: the records shared by @f and @g are not needed.
+; RUN: llvm-dis -materialize-metadata -stats %t.bc -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s -check-prefix=METADATA
+; METADATA: 2 bitcode-reader - {{.*}} lazily loaded modules never loaded
+
+; Materializing the functions loads everything.
+; RUN: llvm-dis -stats %t.bc -o %t.ll 2>&1 | FileCheck %s -check-prefix=ALL
+; ALL: 3 bitcode-reader - {{.*}} lazily loaded modules loaded on demand
+; ALL-NOT: never loaded
+; RUN: FileCheck %s -check-prefix=IR < %t.ll
+; IR: define void @f()
+; IR-NEXT: ret void, !attach [[SHARED:![0-9]+]]
+; IR: define void @g()
+; IR-NEXT: ret void, !attach [[SHARED]]
+; IR: [[SHARED]] = !{[[STR:![0-9]+]]}
+; IR: [[STR]] = !{!"shared"}
+
+; With -bitcode-ondemand-mds-for-lazy-modules=false, or with
+; -disable-ondemand-mds-loading, everything is loaded up front.
+; RUN: llvm-dis -bitcode-ondemand-mds-for-lazy-modules=false \
+; RUN:   -materialize-metadata -stats %t.bc -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s -check-prefix=EAGER
+; RUN: llvm-dis -stats -disable-ondemand-mds-loading %t.bc -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s -check-prefix=EAGER
+; EAGER-NOT: on demand
+; EAGER-NOT: never loaded
+
+!llvm.named = !{!0}
+!0 = !{!"named"}
+
+define void @f() {
+  ret void, !attach !1
+}
+
+define void @g() {
+  ret void, !attach !1
+}
+
+!1 = !{!2}
+!2 = !{!"shared"}
@@ -0,0 +1,73 @@
+; Check that decoding function blocks ahead of time on several threads gives
+; the same module as reading them from the stream.
+; RUN: llvm-as < %s > %t.bc
+; RUN: llvm-dis < %t.bc > %t.serial.ll
+; RUN: llvm-dis -bitcode-parallel-decode -bitcode-parallel-decode-batch=2 \
+; RUN:   < %t.bc > %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+; RUN: FileCheck %s < %t.parallel.ll
+
+@g = global i32 0
+
+; CHECK: define void @f(i8** nocapture %ptr)
+define void @f(i8** nocapture %ptr) {
+entry:
+  ; CHECK: store i8* blockaddress(@h, %here), i8** %ptr
+  store i8* blockaddress(@h, %here), i8** %ptr
+  ret void
+}
+
+; CHECK: define i32 @sum(i32 %n)
+define i32 @sum(i32 %n) !dbg !6 {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %loop ]
+  ; CHECK: %acc.next = add i32 %acc, %i, !dbg [[LOC:![0-9]+]]
+  %acc.next = add i32 %acc, %i, !dbg !9
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !10
+
+exit:
+  %x = load i32, i32* @g
+  %r = add i32 %acc.next, %x
+  ret i32 %r
+}
+
+; CHECK: define void @h()
+define void @h() {
+entry:
+  br label %here
+
+here:
+  store i32 42, i32* @g
+  ret void
+}
+
+; CHECK: define float @consts(float %x)
+define float @consts(float %x) {
+  ; CHECK: fmul float %x, 1.500000e+00
+  %y = fmul float %x, 1.5
+  ; CHECK: call float @consts(float 2.500000e+00)
+  %z = call float @consts(float 2.5)
+  %w = fadd float %y, %z
+  ret float %w
+}
+
+; CHECK: [[LOC]] = !DILocation(line: 3, column: 7
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "sum.c", directory: "/tmp")
+!2 = !{}
+!3 = !{i32 2, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!6 = distinct !DISubprogram(name: "sum", scope: !1, file: !1, line: 1, type: !7, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: false, unit: !0, retainedNodes: !2)
+!7 = !DISubroutineType(types: !8)
+!8 = !{null}
+!9 = !DILocation(line: 3, column: 7, scope: !6)
+!10 = !{!"branch_weights", i32 1, i32 99}
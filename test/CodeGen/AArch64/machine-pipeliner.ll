@@ -0,0 +1,60 @@
+; RUN: llc < %s -mtriple=aarch64-linux-gnu -mcpu=cortex-a53 \
+; RUN:   -aarch64-enable-pipeliner -pass-remarks=pipeliner \
+; RUN:   -pass-remarks-missed=pipeliner -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=aarch64-linux-gnu -mcpu=cortex-a57 \
+; RUN:   -aarch64-enable-pipeliner -pass-remarks=pipeliner \
+; RUN:   -pass-remarks-missed=pipeliner -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=OOO --allow-empty
+; RUN: llc < %s -mtriple=aarch64-linux-gnu -mcpu=cortex-a53 \
+; RUN:   -pass-remarks=pipeliner -pass-remarks-missed=pipeliner -o /dev/null \
+; RUN:   2>&1 | FileCheck %s --check-prefix=OOO --allow-empty
+
+; The pipeliner only runs for in-order cores, and only when it is enabled.
+; OOO-NOT: remark
+
+; CHECK: remark: {{.*}} pipelined loop with II {{[0-9]+}} (ResMII {{[0-9]+}}, RecMII {{[0-9]+}}) in {{[0-9]+}} stages
+define void @saxpy(float* noalias nocapture %x, float* noalias nocapture %y,
+                   float %a, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %px = getelementptr inbounds float, float* %x, i64 %i
+  %py = getelementptr inbounds float, float* %y, i64 %i
+  %vx = load float, float* %px, align 4
+  %vy = load float, float* %py, align 4
+  %mul = fmul float %vx, %a
+  %add = fadd float %mul, %vy
+  store float %add, float* %py, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; A call clobbers the flags and other physical registers.
+; CHECK: remark: {{.*}} loop not pipelined: the loop control cannot be analyzed by the target
+declare float @f(float)
+
+define void @call(float* nocapture %x, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %px = getelementptr inbounds float, float* %x, i64 %i
+  %vx = load float, float* %px, align 4
+  %r = call float @f(float %vx)
+  store float %r, float* %px, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
@@ -0,0 +1,73 @@
+; REQUIRES: asserts
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -enable-ext-tsp-block-placement -debug-only=block-placement -o /dev/null 2>&1 | FileCheck %s --check-prefix=DEBUG
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -enable-ext-tsp-block-placement | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -enable-ext-tsp-block-placement -ext-tsp-min-profile-coverage=90 -debug-only=block-placement -o /dev/null 2>&1 | FileCheck %s --check-prefix=COVERAGE
+
+; The Ext-TSP layout is only tried for functions with a profile.
+; DEBUG: [MBP] Ext-TSP layout of foo (5 blocks): score
+; DEBUG-NOT: [MBP] Ext-TSP layout of noprofile
+
+; The rarely taken block of the loop leaves the hot path.
+; CHECK-LABEL: foo:
+; CHECK:       .LBB0_[[LOOP:[0-9]+]]:
+; CHECK:         je .LBB0_[[RARE:[0-9]+]]
+; CHECK:         callq hot
+; CHECK:         jne .LBB0_[[LOOP]]
+; CHECK:         retq
+; CHECK:       .LBB0_[[RARE]]:
+; CHECK:         callq cold
+
+; Only one of the five blocks is executed rarely, below the required coverage.
+; COVERAGE-NOT: [MBP] Ext-TSP layout of foo
+define void @foo(i32 %n) !prof !0 {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %c = icmp eq i32 %i, 17
+  br i1 %c, label %rare, label %latch, !prof !1
+
+rare:
+  notail call void @cold()
+  br label %latch
+
+latch:
+  notail call void @hot()
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !2
+
+exit:
+  ret void
+}
+
+define void @noprofile(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %c = icmp eq i32 %i, 17
+  br i1 %c, label %rare, label %latch
+
+rare:
+  notail call void @cold()
+  br label %latch
+
+latch:
+  notail call void @hot()
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+declare void @hot()
+declare void @cold()
+
+!0 = !{!"function_entry_count", i64 10}
+!1 = !{!"branch_weights", i32 0, i32 1000}
+!2 = !{!"branch_weights", i32 10, i32 990}
@@ -0,0 +1,36 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -dag-max-block-size=4 -pass-remarks-analysis=isel 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -dag-max-block-size=0 -pass-remarks-analysis=isel 2>&1 | FileCheck %s --check-prefix=NOSPLIT
+
+; Blocks above the size limit are split before their DAGs are built. The
+; static alloca stays in the entry block.
+
+; CHECK: remark: {{.*}} split basic block with 11 instructions into 3 blocks to bound instruction selection time
+; NOSPLIT-NOT: remark: {{.*}} split basic block
+
+; CHECK-LABEL: f:
+; CHECK:         movl $1, (%rdi)
+; CHECK:         movl $2, (%rdi)
+; CHECK:         movl $3, (%rdi)
+; CHECK:         movl $4, (%rdi)
+; CHECK:         movl $5, (%rdi)
+; CHECK:         movl $6, (%rdi)
+; CHECK:         movl $7, (%rdi)
+; CHECK:         movl $8, (%rdi)
+; CHECK:         movl $9, (%rdi)
+; CHECK:         movl $10, (%rdi)
+; CHECK:         retq
+define void @f(i32* %p) {
+entry:
+  %a = alloca i32, align 4
+  store volatile i32 1, i32* %p, align 4
+  store volatile i32 2, i32* %p, align 4
+  store volatile i32 3, i32* %p, align 4
+  store volatile i32 4, i32* %p, align 4
+  store volatile i32 5, i32* %p, align 4
+  store volatile i32 6, i32* %p, align 4
+  store volatile i32 7, i32* %p, align 4
+  store volatile i32 8, i32* %p, align 4
+  store volatile i32 9, i32* %p, align 4
+  store volatile i32 10, i32* %p, align 4
+  ret void
+}
@@ -0,0 +1,85 @@
+; REQUIRES: asserts
+; RUN: llc < %s -mtriple=x86_64-- -stats -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --implicit-check-not="released by compacting"
+; RUN: llc < %s -mtriple=x86_64-- -stats -compact-live-intervals \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s --check-prefixes=CHECK,COMPACT
+
+; LiveIntervals and SlotIndexes report the memory they allocate. The value
+; merged by the phi has a segment in each case block, which grows its segment
+; vector beyond what the copy made by compaction allocates.
+; CHECK-DAG:   {{[1-9][0-9]*}} regalloc{{.*}}Bytes allocated for value numbers
+; CHECK-DAG:   {{[1-9][0-9]*}} regalloc{{.*}}Bytes of segment and value number vectors in computed intervals
+; CHECK-DAG:   {{[1-9][0-9]*}} regalloc{{.*}}Number of virtual register intervals computed
+; CHECK-DAG:   {{[1-9][0-9]*}} slotindexes{{.*}}Bytes allocated for index list entries
+; COMPACT-DAG: {{[1-9][0-9]*}} regalloc{{.*}}Bytes released by compacting computed intervals
+
+define i32 @sel(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %join ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %join ]
+  %k = load volatile i32, i32* %p
+  switch i32 %k, label %join [ i32 0, label %c0
+                               i32 1, label %c1
+                               i32 2, label %c2
+                               i32 3, label %c3
+                               i32 4, label %c4
+                               i32 5, label %c5
+                               i32 6, label %c6
+                               i32 7, label %c7
+                               i32 8, label %c8
+                               i32 9, label %c9 ]
+
+c0:
+  %v0 = mul i32 %s, 3
+  br label %join
+
+c1:
+  %v1 = mul i32 %s, 4
+  br label %join
+
+c2:
+  %v2 = mul i32 %s, 5
+  br label %join
+
+c3:
+  %v3 = mul i32 %s, 6
+  br label %join
+
+c4:
+  %v4 = mul i32 %s, 7
+  br label %join
+
+c5:
+  %v5 = mul i32 %s, 8
+  br label %join
+
+c6:
+  %v6 = mul i32 %s, 9
+  br label %join
+
+c7:
+  %v7 = mul i32 %s, 10
+  br label %join
+
+c8:
+  %v8 = mul i32 %s, 11
+  br label %join
+
+c9:
+  %v9 = mul i32 %s, 12
+  br label %join
+
+join:
+  %s.next = phi i32 [ %s, %loop ], [ %v0, %c0 ], [ %v1, %c1 ], [ %v2, %c2 ],
+                    [ %v3, %c3 ], [ %v4, %c4 ], [ %v5, %c5 ], [ %v6, %c6 ],
+                    [ %v7, %c7 ], [ %v8, %c8 ], [ %v9, %c9 ]
+  %i.next = add nsw i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %s.next
+}
@@ -0,0 +1,59 @@
+; RUN: llc -mtriple=x86_64-- -O0 -machine-function-barriers -debug-pass=Structure < %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=PIPELINE
+; RUN: llc -mtriple=x86_64-- -machine-function-barriers < %s | FileCheck %s
+; RUN: llc -mtriple=x86_64-- < %s | FileCheck %s
+; RUN: llc -mtriple=x86_64-- -O0 -machine-function-barriers -verify-machineinstrs -debug-pass=Structure < %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=VERIFY
+; RUN: llc -mtriple=x86_64-- -machine-function-barriers -verify-machineinstrs -function-pass-threads=2 < %s | FileCheck %s
+
+; Instruction selection and the machine passes run in a function pass manager
+; of their own, separate from the IR passes and from the printer. The stack
+; protector runs once, next to the instruction selector that reads its results.
+; PIPELINE:          Safe Stack instrumentation pass
+; PIPELINE-NEXT:   Machine Function Barrier
+; PIPELINE-NEXT:   FunctionPass Manager
+; PIPELINE-NEXT:     Insert stack protectors
+; PIPELINE-NEXT:     Module Verifier
+; PIPELINE-NEXT:     X86 DAG->DAG Instruction Selection
+; PIPELINE-NOT:      Insert stack protectors
+; PIPELINE:          Check CFA info and insert CFI instructions if needed
+; PIPELINE-NEXT:   Machine Function Barrier
+; PIPELINE-NEXT:   FunctionPass Manager
+; PIPELINE-NEXT:     Lazy Machine Block Frequency Analysis
+; PIPELINE-NEXT:     Machine Optimization Remark Emitter
+; PIPELINE-NEXT:     X86 Assembly Printer
+; PIPELINE-NEXT:     Free MachineFunction
+
+; With -verify-machineinstrs, the verifier that follows the last machine pass
+; moves between two barriers. There it is alone in its pass manager, so
+; -function-pass-threads runs it in parallel. The other verifiers stay put.
+; VERIFY:          Verify generated machine code
+; VERIFY:          Check CFA info and insert CFI instructions if needed
+; VERIFY-NEXT:   Machine Function Barrier
+; VERIFY-NEXT:   FunctionPass Manager
+; VERIFY-NEXT:     Verify generated machine code
+; VERIFY-NEXT:   Machine Function Barrier
+; VERIFY-NEXT:   FunctionPass Manager
+; VERIFY-NEXT:     Lazy Machine Block Frequency Analysis
+
+; The blocks are numbered after their function in module order.
+; CHECK-LABEL: f:
+; CHECK:       .LBB0_2:
+; CHECK-LABEL: g:
+; CHECK:       .LBB1_2:
+
+define i32 @f(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+a:
+  ret i32 1
+b:
+  ret i32 2
+}
+
+define i32 @g(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+a:
+  ret i32 3
+b:
+  ret i32 4
+}
@@ -0,0 +1,163 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -split-machine-functions | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -split-machine-functions -function-sections | FileCheck %s --check-prefix=FSECT
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -split-machine-functions -filetype=obj -o %t.o
+; RUN: llvm-readobj -symbols %t.o | FileCheck %s --check-prefix=SYM
+
+; The block that the profile shows to be never executed is moved to the cold
+; fragment, whose frame starts in the state of the hot part. The fragment is
+; a local function symbol of its own.
+define void @foo(i1 %c) !prof !0 {
+; CHECK-LABEL: foo:
+; CHECK:         .cfi_startproc
+; CHECK:         jne .LBB0_[[COLD:[0-9]+]]
+; CHECK:         callq hot
+; CHECK:       .Lfunc_end0:
+; CHECK-NEXT:    .size foo, .Lfunc_end0-foo
+; CHECK-NEXT:    .cfi_endproc
+; CHECK-NEXT:    .section .text.unlikely,"ax",@progbits
+; CHECK-NEXT:    .p2align 4, 0x90
+; CHECK-NEXT:    .type foo.cold,@function
+; CHECK-NEXT:  foo.cold:
+; CHECK-NEXT:    .cfi_startproc
+; CHECK-NEXT:    .cfi_def_cfa_offset 16
+; CHECK:       .LBB0_[[COLD]]:
+; CHECK:         callq cold
+; CHECK:       .Lfunc_cold_end0:
+; CHECK-NEXT:    .size foo.cold, .Lfunc_cold_end0-foo.cold
+; CHECK-NEXT:    .cfi_endproc
+
+; FSECT:       .section .text.unlikely.foo,"ax",@progbits
+; FSECT-NEXT:  .p2align 4, 0x90
+; FSECT-NEXT:  .type foo.cold,@function
+; FSECT-NEXT:  foo.cold:
+entry:
+  br i1 %c, label %unlikely, label %likely, !prof !1
+
+likely:
+  notail call void @hot()
+  ret void
+
+unlikely:
+  notail call void @cold()
+  ret void
+}
+
+; The fragment of a COMDAT function goes to the same group.
+$bar = comdat any
+
+define linkonce_odr void @bar(i1 %c) comdat !prof !0 {
+; CHECK-LABEL: bar:
+; CHECK:         .section .text.unlikely.bar,"axG",@progbits,bar,comdat
+; CHECK-NEXT:    .p2align 4, 0x90
+; CHECK-NEXT:    .type bar.cold,@function
+; CHECK-NEXT:  bar.cold:
+entry:
+  br i1 %c, label %unlikely, label %likely, !prof !1
+
+likely:
+  notail call void @hot()
+  ret void
+
+unlikely:
+  notail call void @cold()
+  ret void
+}
+
+; Functions without profile data are not split.
+define void @noprofile(i1 %c) {
+; CHECK-LABEL: noprofile:
+; CHECK-NOT:     .section
+; CHECK:         .cfi_endproc
+entry:
+  br i1 %c, label %unlikely, label %likely, !prof !1
+
+likely:
+  notail call void @hot()
+  ret void
+
+unlikely:
+  notail call void @cold()
+  ret void
+}
+
+; The call-site table describes the hot part only, so the blocks with invokes
+; and the landing pads stay there. The frame of the fragment has no
+; personality and no LSDA.
+define void @personality(i1 %c) personality i32 (...)* @__gxx_personality_v0 !prof !0 {
+; CHECK-LABEL: personality:
+; CHECK:         .cfi_personality 3, __gxx_personality_v0
+; CHECK-NEXT:    .cfi_lsda 3, .Lexception0
+; CHECK:       .Ltmp0:
+; CHECK-NEXT:    callq hot
+; CHECK-NEXT:  .Ltmp1:
+; CHECK:         callq _Unwind_Resume
+; CHECK:       .Lfunc_end3:
+; CHECK-NEXT:    .size personality, .Lfunc_end3-personality
+; CHECK-NEXT:    .cfi_endproc
+; CHECK-NEXT:    .section .text.unlikely,"ax",@progbits
+; CHECK-NEXT:    .p2align 4, 0x90
+; CHECK-NEXT:    .type personality.cold,@function
+; CHECK-NEXT:  personality.cold:
+; CHECK-NEXT:    .cfi_startproc
+; CHECK-NOT:     .cfi_personality
+; CHECK-NOT:     .cfi_lsda
+; CHECK:         callq cold
+; CHECK:       .Lfunc_cold_end2:
+; CHECK-NEXT:    .size personality.cold, .Lfunc_cold_end2-personality.cold
+; CHECK-NEXT:    .cfi_endproc
+; CHECK:       GCC_except_table3:
+; CHECK:         .uleb128 .Ltmp0-.Lfunc_begin0
+; CHECK:         .uleb128 .Lfunc_end3-.Ltmp1
+entry:
+  br i1 %c, label %unlikely, label %likely, !prof !1
+
+likely:
+  invoke void @hot() to label %cont unwind label %lpad
+
+cont:
+  ret void
+
+lpad:
+  %lp = landingpad { i8*, i32 } cleanup
+  resume { i8*, i32 } %lp
+
+unlikely:
+  notail call void @cold()
+  ret void
+}
+
+; A symbol of the name that the fragment would get is already taken.
+define void @"baz.cold"() {
+  ret void
+}
+
+define void @baz(i1 %c) !prof !0 {
+; CHECK-LABEL: baz:
+; CHECK:         .type baz.cold.1,@function
+; CHECK-NEXT:  baz.cold.1:
+entry:
+  br i1 %c, label %unlikely, label %likely, !prof !1
+
+likely:
+  notail call void @hot()
+  ret void
+
+unlikely:
+  notail call void @cold()
+  ret void
+}
+
+; SYM:       Name: foo.cold
+; SYM-NEXT:  Value: 0x0
+; SYM-NEXT:  Size: 7
+; SYM-NEXT:  Binding: Local
+; SYM-NEXT:  Type: Function
+; SYM-NEXT:  Other: 0
+; SYM-NEXT:  Section: .text.unlikely
+
+declare void @hot()
+declare void @cold()
+declare i32 @__gxx_personality_v0(...)
+
+!0 = !{!"function_entry_count", i64 1000}
+!1 = !{!"branch_weights", i32 0, i32 1000}
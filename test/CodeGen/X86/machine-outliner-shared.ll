@@ -0,0 +1,71 @@
+; RUN: llc -enable-machine-outliner -enable-shared-outlined-functions -relocation-model=static -mtriple=x86_64-unknown-linux-gnu < %s | FileCheck %s
+; RUN: llc -enable-machine-outliner -relocation-model=static -mtriple=x86_64-unknown-linux-gnu < %s | FileCheck %s --check-prefix=LOCAL
+
+; Outlined functions are named by their contents and go to COMDAT groups, so
+; that the linker keeps one of the copies that different modules create. A
+; function whose instructions refer to a local global stays internal. The
+; static relocation model keeps the addresses of the globals in immediates,
+; since the outliner does not move RIP-relative instructions.
+
+@g = global i32 0, align 4
+@l = internal global i32 0, align 4
+
+define void @a(i32** %p) #0 {
+; CHECK-LABEL: a:
+; CHECK:         jmp [[SHARED:OUTLINED_FUNCTION_[0-9a-f]+]]
+; LOCAL-LABEL: a:
+; LOCAL:         jmp OUTLINED_FUNCTION_{{[0-9]+$}}
+  store volatile i32* @g, i32** %p, align 8
+  %p1 = getelementptr i32*, i32** %p, i64 1
+  store volatile i32* @g, i32** %p1, align 8
+  %p2 = getelementptr i32*, i32** %p, i64 2
+  store volatile i32* @g, i32** %p2, align 8
+  ret void
+}
+
+define void @b(i32** %p) #0 {
+; CHECK-LABEL: b:
+; CHECK:         jmp [[SHARED]]
+  store volatile i32* @g, i32** %p, align 8
+  %p1 = getelementptr i32*, i32** %p, i64 1
+  store volatile i32* @g, i32** %p1, align 8
+  %p2 = getelementptr i32*, i32** %p, i64 2
+  store volatile i32* @g, i32** %p2, align 8
+  ret void
+}
+
+define void @c(i32** %p) #0 {
+; CHECK-LABEL: c:
+; CHECK:         jmp [[INTERNAL:OUTLINED_FUNCTION_[0-9]+$]]
+  store volatile i32* @l, i32** %p, align 8
+  %p1 = getelementptr i32*, i32** %p, i64 1
+  store volatile i32* @l, i32** %p1, align 8
+  %p2 = getelementptr i32*, i32** %p, i64 2
+  store volatile i32* @l, i32** %p2, align 8
+  ret void
+}
+
+define void @d(i32** %p) #0 {
+; CHECK-LABEL: d:
+; CHECK:         jmp [[INTERNAL]]
+  store volatile i32* @l, i32** %p, align 8
+  %p1 = getelementptr i32*, i32** %p, i64 1
+  store volatile i32* @l, i32** %p1, align 8
+  %p2 = getelementptr i32*, i32** %p, i64 2
+  store volatile i32* @l, i32** %p2, align 8
+  ret void
+}
+
+attributes #0 = { noredzone nounwind minsize }
+
+; CHECK-NOT:     .weak
+; CHECK:       [[INTERNAL]]:
+; CHECK:         movq $l, (%rdi)
+
+; CHECK:         .section .text.[[SHARED]],"axG",@progbits,[[SHARED]],comdat
+; CHECK-NEXT:    .hidden [[SHARED]]
+; CHECK-NEXT:    .weak [[SHARED]]
+; CHECK:       [[SHARED]]:
+; CHECK:         movq $g, (%rdi)
+
+; LOCAL-NOT:     .weak
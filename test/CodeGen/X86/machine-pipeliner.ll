@@ -0,0 +1,90 @@
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mcpu=atom \
+; RUN:   -x86-enable-pipeliner -pass-remarks=pipeliner \
+; RUN:   -pass-remarks-missed=pipeliner -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mcpu=skylake \
+; RUN:   -x86-enable-pipeliner -pass-remarks=pipeliner \
+; RUN:   -pass-remarks-missed=pipeliner -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=OOO --allow-empty
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mcpu=atom \
+; RUN:   -pass-remarks=pipeliner -pass-remarks-missed=pipeliner -o /dev/null \
+; RUN:   2>&1 | FileCheck %s --check-prefix=OOO --allow-empty
+
+; The pipeliner only runs for in-order cores, and only when it is enabled.
+; OOO-NOT: remark
+
+; The flags that the integer instructions clobber do not order them, so the
+; multiply of the next iteration overlaps the chain of the current one.
+; CHECK: remark: {{.*}} pipelined loop with II {{[0-9]+}} (ResMII {{[0-9]+}}, RecMII {{[0-9]+}}) in 2 stages
+define void @hash(i32* noalias nocapture %x, i32* noalias nocapture %y,
+                  i32 %a, i32 %b, i32 %c, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %px = getelementptr inbounds i32, i32* %x, i64 %i
+  %py = getelementptr inbounds i32, i32* %y, i64 %i
+  %vx = load i32, i32* %px, align 4
+  %m = mul i32 %vx, %a
+  %h1 = xor i32 %m, %b
+  %h2 = add i32 %h1, %c
+  %h3 = xor i32 %h2, %a
+  %h4 = add i32 %h3, %b
+  store i32 %h4, i32* %py, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; Atom issues the floating-point operations for as many cycles as they take,
+; so no iterations overlap.
+; CHECK: remark: {{.*}} loop not pipelined: the schedule does not overlap iterations
+define void @saxpy(float* noalias nocapture %x, float* noalias nocapture %y,
+                   float %a, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %px = getelementptr inbounds float, float* %x, i64 %i
+  %py = getelementptr inbounds float, float* %y, i64 %i
+  %vx = load float, float* %px, align 4
+  %vy = load float, float* %py, align 4
+  %mul = fmul float %vx, %a
+  %add = fadd float %mul, %vy
+  store float %add, float* %py, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; A call clobbers the flags and other physical registers.
+; CHECK: remark: {{.*}} loop not pipelined: the loop control cannot be analyzed by the target
+declare float @f(float)
+
+define void @call(float* nocapture %x, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %px = getelementptr inbounds float, float* %x, i64 %i
+  %vx = load float, float* %px, align 4
+  %r = call float @f(float %vx)
+  store float %r, float* %px, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
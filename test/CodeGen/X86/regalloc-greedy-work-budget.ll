@@ -0,0 +1,75 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -regalloc-greedy-work-budget=1 \
+; RUN:     -pass-remarks-missed=regalloc -o /dev/null 2>&1 \
+; RUN:   | FileCheck -check-prefix=REMARK %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -regalloc-greedy-work-budget=0 \
+; RUN:     -pass-remarks-missed=regalloc -o /dev/null 2>&1 \
+; RUN:   | FileCheck -allow-empty -check-prefix=NOLIMIT %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -regalloc-greedy-work-budget=1 \
+; RUN:     -verify-machineinstrs | FileCheck %s
+
+; The values loaded before the calls are live across them, so there are more
+; live ranges than callee-saved registers. With a tiny work budget the greedy
+; allocator falls back to cheaper decisions and reports it.
+
+; REMARK: remark: {{.*}}register allocation exceeded its work budget of 1 units; made {{[0-9]+}} cheaper eviction and splitting decisions
+; NOLIMIT-NOT: work budget
+
+; CHECK-LABEL: pressure:
+; CHECK: callq use
+; CHECK: retq
+
+declare void @use(i32)
+
+define i32 @pressure(i32* %p) {
+entry:
+  %a0.p = getelementptr i32, i32* %p, i64 0
+  %a0 = load volatile i32, i32* %a0.p
+  %a1.p = getelementptr i32, i32* %p, i64 1
+  %a1 = load volatile i32, i32* %a1.p
+  %a2.p = getelementptr i32, i32* %p, i64 2
+  %a2 = load volatile i32, i32* %a2.p
+  %a3.p = getelementptr i32, i32* %p, i64 3
+  %a3 = load volatile i32, i32* %a3.p
+  %a4.p = getelementptr i32, i32* %p, i64 4
+  %a4 = load volatile i32, i32* %a4.p
+  %a5.p = getelementptr i32, i32* %p, i64 5
+  %a5 = load volatile i32, i32* %a5.p
+  %a6.p = getelementptr i32, i32* %p, i64 6
+  %a6 = load volatile i32, i32* %a6.p
+  %a7.p = getelementptr i32, i32* %p, i64 7
+  %a7 = load volatile i32, i32* %a7.p
+  %a8.p = getelementptr i32, i32* %p, i64 8
+  %a8 = load volatile i32, i32* %a8.p
+  %a9.p = getelementptr i32, i32* %p, i64 9
+  %a9 = load volatile i32, i32* %a9.p
+  %a10.p = getelementptr i32, i32* %p, i64 10
+  %a10 = load volatile i32, i32* %a10.p
+  %a11.p = getelementptr i32, i32* %p, i64 11
+  %a11 = load volatile i32, i32* %a11.p
+  %a12.p = getelementptr i32, i32* %p, i64 12
+  %a12 = load volatile i32, i32* %a12.p
+  %a13.p = getelementptr i32, i32* %p, i64 13
+  %a13 = load volatile i32, i32* %a13.p
+  %a14.p = getelementptr i32, i32* %p, i64 14
+  %a14 = load volatile i32, i32* %a14.p
+  %a15.p = getelementptr i32, i32* %p, i64 15
+  %a15 = load volatile i32, i32* %a15.p
+  call void @use(i32 %a0)
+  call void @use(i32 %a1)
+  %s1 = mul i32 %a0, %a1
+  %s2 = mul i32 %s1, %a2
+  %s3 = mul i32 %s2, %a3
+  %s4 = mul i32 %s3, %a4
+  %s5 = mul i32 %s4, %a5
+  %s6 = mul i32 %s5, %a6
+  %s7 = mul i32 %s6, %a7
+  %s8 = mul i32 %s7, %a8
+  %s9 = mul i32 %s8, %a9
+  %s10 = mul i32 %s9, %a10
+  %s11 = mul i32 %s10, %a11
+  %s12 = mul i32 %s11, %a12
+  %s13 = mul i32 %s12, %a13
+  %s14 = mul i32 %s13, %a14
+  %s15 = mul i32 %s14, %a15
+  ret i32 %s15
+}
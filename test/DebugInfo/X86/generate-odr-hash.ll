@@ -8,6 +8,9 @@
 ; RUN: llvm-dwarfdump -v %t | FileCheck --check-prefix=CHECK --check-prefix=FISSION %s
 ; RUN: llvm-readobj -s -t %t | FileCheck --check-prefix=OBJ_FISSION %s
 
+; RUN: llc < %s -o %t -filetype=obj -O0 -generate-type-units -dwarf-type-signature-hash=xxh3 -mtriple=x86_64-unknown-linux-gnu
+; RUN: llvm-dwarfdump -v %t | FileCheck --check-prefix=XXH3 %s
+
 ; Generated from bar.cpp:
 
 ; #line 1 "bar.h"
@@ -62,6 +65,14 @@
 ; CHECK-NEXT: DW_AT_declaration
 ; CHECK-NEXT: DW_AT_signature {{.*}} (0xb04af47397402e77)
 
+; XXH3: Compile Unit:
+; XXH3: {{^0x........}}: DW_TAG_structure_type
+; XXH3-NEXT: DW_AT_declaration
+; XXH3-NEXT: DW_AT_signature {{.*}} (0x0b932ad9d3724ee4)
+; XXH3: {{^0x........}}: DW_TAG_class_type
+; XXH3-NEXT: DW_AT_declaration
+; XXH3-NEXT: DW_AT_signature {{.*}} (0x8051648086182d7f)
+
 ; Ensure the CU-local type 'walrus' is not placed in a type unit.
 ; CHECK: [[WALRUS:^0x........]]: DW_TAG_structure_type
 ; CHECK-NEXT: DW_AT_name{{.*}}"walrus"
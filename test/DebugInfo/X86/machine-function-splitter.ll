@@ -0,0 +1,105 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -split-machine-functions < %s | FileCheck %s
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -split-machine-functions -filetype=obj < %s \
+; RUN:   | llvm-dwarfdump -debug-info - | FileCheck %s --check-prefix=DWARF
+
+; The cold fragment of a function gets line entries of its own. The subprogram
+; and the compile unit have a range in each section, and so have the lexical
+; block and the location of the variable that reach into the fragment.
+
+; CHECK-LABEL: foo:
+; CHECK:       # %likely
+; CHECK-NEXT:  [[BLOCK:.Ltmp[0-9]+]]:
+; CHECK-NEXT:    .loc 1 4 5
+; CHECK:       .Lfunc_end0:
+; CHECK:         .section .text.unlikely,"ax",@progbits
+; CHECK:       foo.cold:
+; CHECK-NEXT:    .cfi_startproc
+; CHECK:         .loc 1 6 5
+; CHECK-NEXT:    callq cold
+; CHECK-NEXT:  [[VALUE:.Ltmp[0-9]+]]:
+; CHECK:         .loc 1 8 5
+; CHECK-NEXT:    callq cold
+; CHECK:       [[BLOCKEND:.Ltmp[0-9]+]]:
+; CHECK-NEXT:  .Lfunc_cold_end0:
+
+; CHECK-LABEL:   .section .debug_loc
+; CHECK-NEXT:  .Ldebug_loc0:
+; CHECK-NEXT:    .quad .Ltmp0
+; CHECK-NEXT:    .quad .Lfunc_end0
+; CHECK:         .quad foo.cold
+; CHECK-NEXT:    .quad [[VALUE]]
+; CHECK:         .quad [[VALUE]]
+; CHECK-NEXT:    .quad .Lfunc_cold_end0
+
+; CHECK-LABEL:   .section .debug_ranges
+; CHECK-NEXT:  .Ldebug_ranges0:
+; CHECK-NEXT:    .quad .Lfunc_begin0
+; CHECK-NEXT:    .quad .Lfunc_end0
+; CHECK-NEXT:    .quad foo.cold
+; CHECK-NEXT:    .quad .Lfunc_cold_end0
+; CHECK-NEXT:    .quad 0
+; CHECK-NEXT:    .quad 0
+; CHECK-NEXT:  .Ldebug_ranges1:
+; CHECK-NEXT:    .quad [[BLOCK]]
+; CHECK-NEXT:    .quad .Lfunc_end0
+; CHECK-NEXT:    .quad foo.cold
+; CHECK-NEXT:    .quad [[BLOCKEND]]
+; CHECK-NEXT:    .quad 0
+; CHECK-NEXT:    .quad 0
+
+; DWARF:       DW_TAG_subprogram
+; DWARF-NEXT:    DW_AT_ranges
+; DWARF-NEXT:      [0x0000000000000000, 0x{{[0-9a-f]+}})
+; DWARF-NEXT:      [0x0000000000000000, 0x{{[0-9a-f]+}}))
+; DWARF:       DW_TAG_lexical_block
+; DWARF-NEXT:    DW_AT_ranges
+; DWARF-NEXT:      [0x{{[0-9a-f]+}}, 0x{{[0-9a-f]+}})
+; DWARF-NEXT:      [0x0000000000000000, 0x{{[0-9a-f]+}}))
+; DWARF:       DW_TAG_variable
+; DWARF-NEXT:    DW_AT_location
+; DWARF-NEXT:      [0x{{[0-9a-f]+}}, 0x{{[0-9a-f]+}}): DW_OP_consts +0, DW_OP_stack_value
+; DWARF-NEXT:      [0x{{[0-9a-f]+}}, 0x{{[0-9a-f]+}}): DW_OP_consts +0, DW_OP_stack_value
+; DWARF-NEXT:      [0x{{[0-9a-f]+}}, 0x{{[0-9a-f]+}}): DW_OP_consts +1, DW_OP_stack_value)
+
+define void @foo(i1 %c) !dbg !7 !prof !20 {
+entry:
+  call void @llvm.dbg.value(metadata i32 0, metadata !12, metadata !DIExpression()), !dbg !14
+  br i1 %c, label %unlikely, label %likely, !dbg !14, !prof !21
+
+likely:
+  notail call void @hot(), !dbg !15
+  ret void, !dbg !15
+
+unlikely:
+  notail call void @cold(), !dbg !16
+  call void @llvm.dbg.value(metadata i32 1, metadata !12, metadata !DIExpression()), !dbg !17
+  notail call void @cold(), !dbg !17
+  ret void, !dbg !17
+}
+
+declare void @hot()
+declare void @cold()
+declare void @llvm.dbg.value(metadata, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, runtimeVersion: 0, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "split.c", directory: "/")
+!2 = !{}
+!3 = !{i32 2, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!7 = distinct !DISubprogram(name: "foo", scope: !1, file: !1, line: 1, type: !8, isLocal: false, isDefinition: true, scopeLine: 1, flags: DIFlagPrototyped, isOptimized: true, unit: !0, retainedNodes: !11)
+!8 = !DISubroutineType(types: !9)
+!9 = !{null, !10}
+!10 = !DIBasicType(name: "_Bool", size: 8, encoding: DW_ATE_boolean)
+!11 = !{!12}
+!12 = !DILocalVariable(name: "x", scope: !18, file: !1, line: 2, type: !13)
+!13 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!14 = !DILocation(line: 2, column: 7, scope: !7)
+!15 = !DILocation(line: 4, column: 5, scope: !18)
+!16 = !DILocation(line: 6, column: 5, scope: !18)
+!17 = !DILocation(line: 8, column: 5, scope: !18)
+!18 = distinct !DILexicalBlock(scope: !7, file: !1, line: 3, column: 3)
+!20 = !{!"function_entry_count", i64 1000}
+!21 = !{!"branch_weights", i32 0, i32 1000}
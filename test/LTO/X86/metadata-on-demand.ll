@@ -0,0 +1,32 @@
+; Check that regular LTO does not load the metadata of functions that it does
+; not link, such as non-prevailing linkonce_odr copies. -stats enables the
+; statistics before the modules are added, -stats-file prints them.
+; REQUIRES: asserts
+; RUN: llvm-as -bitcode-mdindex-threshold=0 %s -o %t1.bc
+; RUN: cp %t1.bc %t2.bc
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o -stats -stats-file=%t.stats \
+; RUN:   -r=%t1.bc,f,px -r=%t1.bc,g,px -r=%t2.bc,f, -r=%t2.bc,g,
+; RUN: FileCheck %s < %t.stats
+; CHECK: "bitcode-reader.NumMDRecordLoadedOnDemand": 2
+; CHECK: "bitcode-reader.NumMDRecordNeverLoaded": 2
+
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o -stats -stats-file=%t.eager.stats \
+; RUN:   -bitcode-ondemand-mds-for-lazy-modules=false \
+; RUN:   -r=%t1.bc,f,px -r=%t1.bc,g,px -r=%t2.bc,f, -r=%t2.bc,g,
+; RUN: FileCheck %s -check-prefix=EAGER < %t.eager.stats
+; EAGER-NOT: OnDemand
+; EAGER-NOT: NeverLoaded
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define linkonce_odr void @f() {
+  ret void, !attach !0
+}
+
+define linkonce_odr void @g() {
+  ret void, !attach !0
+}
+
+!0 = !{!1}
+!1 = !{!"shared"}
@@ -0,0 +1,26 @@
+; Reloading the linked module in a fresh context between batches of files must
+; not change the result.
+; RUN: llvm-as %s -o %t.main.bc
+; RUN: llvm-as %S/Inputs/basiclink.a.ll -o %t.a.bc
+; RUN: llvm-as %S/Inputs/basiclink.b.ll -o %t.b.bc
+; RUN: llvm-link %t.main.bc %t.a.bc %t.b.bc -S -o %t.ll
+; RUN: llvm-link -stream-batch-size=1 -report-memory %t.main.bc %t.a.bc \
+; RUN:   %t.b.bc -S -o %t.stream.ll 2>&1 | FileCheck --check-prefix=MEMORY %s
+; RUN: diff %t.ll %t.stream.ll
+; RUN: FileCheck %s < %t.stream.ll
+
+; MEMORY: Memory after linking: {{[0-9]+}} KB current, {{[0-9]+}} KB peak
+; MEMORY: Memory after verification:
+; MEMORY: Memory after writing:
+
+%struct.pair = type { i32, i32 }
+
+; CHECK: @pair = global %struct.pair zeroinitializer
+@pair = global %struct.pair zeroinitializer
+
+; CHECK: define i32 @main()
+define i32 @main() {
+  %p = getelementptr %struct.pair, %struct.pair* @pair, i32 0, i32 1
+  %v = load i32, i32* %p
+  ret i32 %v
+}
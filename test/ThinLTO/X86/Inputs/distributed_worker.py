@@ -0,0 +1,20 @@
+# A stand-in for clang's distributed ThinLTO backend. Rather than an object
+# file, it writes out the arguments it was invoked with, with the paths of the
+# temporary files replaced, after checking that it was handed bitcode.
+
+import sys
+
+args = sys.argv[1:]
+module = args[args.index('-x') + 2]
+index = [a for a in args if a.startswith('-fthinlto-index=')][0]
+out = args[args.index('-o') + 1]
+
+for path in (module, index[len('-fthinlto-index='):]):
+    with open(path, 'rb') as f:
+        if f.read(2) != b'BC':
+            sys.exit('not a bitcode file: ' + path)
+
+args[args.index(index)] = '-fthinlto-index=<index>'
+args[args.index(out)] = '<object>'
+with open(out, 'w') as f:
+    f.write(' '.join(args) + '\n')
@@ -0,0 +1,36 @@
+; Check that with per-function hashes in the summaries, the cache entry of a
+; module only depends on the functions it imports from another module, not on
+; the rest of that module.
+
+; RUN: opt -module-hash -module-summary -module-summary-function-hashes %s -o %t.bc
+; RUN: opt -module-hash -module-summary -module-summary-function-hashes %S/Inputs/cache-function-hashes1.ll -o %t1.bc
+; RUN: opt -module-hash -module-summary -module-summary-function-hashes %S/Inputs/cache-function-hashes2.ll -o %t2.bc
+; RUN: llvm-bcanalyzer -dump %t1.bc | FileCheck %s --check-prefix=BCA
+; BCA: <FUNCTION_HASH
+
+; The two versions of the input only differ in @other, which is not imported,
+; so the second link reuses the entry for this module.
+; RUN: rm -rf %t.cache
+; RUN: llvm-lto2 run -cache-dir %t.cache -o %t.o %t.bc %t1.bc -r=%t.bc,main,plx -r=%t.bc,f,lx -r=%t1.bc,f,plx -r=%t1.bc,other,plx
+; RUN: ls %t.cache/llvmcache-* | count 2
+; RUN: llvm-lto2 run -cache-dir %t.cache -o %t.o %t.bc %t2.bc -r=%t.bc,main,plx -r=%t.bc,f,lx -r=%t2.bc,f,plx -r=%t2.bc,other,plx
+; RUN: ls %t.cache/llvmcache-* | count 3
+
+; Without the hashes any change to the input invalidates this module's entry.
+; RUN: opt -module-hash -module-summary %s -o %t.bc
+; RUN: opt -module-hash -module-summary %S/Inputs/cache-function-hashes1.ll -o %t1.bc
+; RUN: opt -module-hash -module-summary %S/Inputs/cache-function-hashes2.ll -o %t2.bc
+; RUN: rm -rf %t.cache
+; RUN: llvm-lto2 run -cache-dir %t.cache -o %t.o %t.bc %t1.bc -r=%t.bc,main,plx -r=%t.bc,f,lx -r=%t1.bc,f,plx -r=%t1.bc,other,plx
+; RUN: llvm-lto2 run -cache-dir %t.cache -o %t.o %t.bc %t2.bc -r=%t.bc,main,plx -r=%t.bc,f,lx -r=%t2.bc,f,plx -r=%t2.bc,other,plx
+; RUN: ls %t.cache/llvmcache-* | count 4
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @main() {
+  call void @f()
+  ret void
+}
+
+declare void @f()
@@ -0,0 +1,52 @@
+; Check that a failing out-of-process backend job is reported for each module
+; rather than taking down the link, and that the objects of successful jobs
+; are collected and cached.
+; RUN: opt -module-hash -module-summary %s -o %t1.bc
+; RUN: opt -module-hash -module-summary %p/Inputs/distributed_worker.ll -o %t2.bc
+; RUN: not llvm-lto2 run %t1.bc %t2.bc -o %t.o -thinlto-threads=2 \
+; RUN:   -thinlto-distributed-worker=%t.missing-worker \
+; RUN:   -r=%t1.bc,f,px -r=%t1.bc,g, -r=%t1.bc,analias, \
+; RUN:   -r=%t2.bc,g,px -r=%t2.bc,analias,px -r=%t2.bc,aliasee,px \
+; RUN:   2>&1 | FileCheck %s
+
+; CHECK-DAG: ThinLTO backend worker for '{{.*}}.tmp1.bc' could not be run
+; CHECK-DAG: ThinLTO backend worker for '{{.*}}.tmp2.bc' could not be run
+
+; A stub worker writes out its arguments instead of an object file. What it
+; writes becomes the object of its task, and the codegen options are passed
+; on to it.
+; RUN: rm -rf %t.cache
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o -thinlto-threads=2 \
+; RUN:   -O1 -mcpu=corei7 -mattr=+avx -cache-dir %t.cache \
+; RUN:   -thinlto-distributed-worker=%python \
+; RUN:   -thinlto-distributed-worker-arg=%p/Inputs/distributed_worker.py \
+; RUN:   -r=%t1.bc,f,px -r=%t1.bc,g, -r=%t1.bc,analias, \
+; RUN:   -r=%t2.bc,g,px -r=%t2.bc,analias,px -r=%t2.bc,aliasee,px
+; RUN: FileCheck %s -check-prefix=OBJ1 < %t.o.1
+; RUN: FileCheck %s -check-prefix=OBJ2 < %t.o.2
+; OBJ1: {{^}}-O1 -Xclang -target-cpu -Xclang corei7
+; OBJ1-SAME: -Xclang -target-feature -Xclang +avx
+; OBJ1-SAME: -x ir {{.*}}.tmp1.bc -fthinlto-index=<index> -o <object>
+; OBJ2: -x ir {{.*}}.tmp2.bc -fthinlto-index=<index> -o <object>
+
+; With the objects in the cache, no worker is run.
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.hit.o -thinlto-threads=2 \
+; RUN:   -O1 -mcpu=corei7 -mattr=+avx -cache-dir %t.cache \
+; RUN:   -thinlto-distributed-worker=%t.missing-worker \
+; RUN:   -r=%t1.bc,f,px -r=%t1.bc,g, -r=%t1.bc,analias, \
+; RUN:   -r=%t2.bc,g,px -r=%t2.bc,analias,px -r=%t2.bc,aliasee,px
+; RUN: cmp %t.o.1 %t.hit.o.1
+; RUN: cmp %t.o.2 %t.hit.o.2
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare void @g(...)
+declare void @analias(...)
+
+define void @f() {
+entry:
+  call void (...) @g()
+  call void (...) @analias()
+  ret void
+}
@@ -0,0 +1,32 @@
+; Check that a combined index written in the flat summary index format drives
+; importing the same way as the bitcode one.
+; RUN: opt -module-summary %s -o %t1.bc
+; RUN: opt -module-summary %p/Inputs/funcimport2.ll -o %t2.bc
+; RUN: llvm-lto -thinlto-action=thinlink -o %t.index.bc %t1.bc %t2.bc
+; RUN: llvm-lto -thinlto-action=thinlink -thinlto-flat-index -o %t.index.flat \
+; RUN:   %t1.bc %t2.bc
+
+; RUN: llvm-lto -thinlto-action=import %t2.bc -thinlto-index=%t.index.bc \
+; RUN:   -o %t2.bc.imported.bc
+; RUN: llvm-lto -thinlto-action=import %t2.bc -thinlto-index=%t.index.flat \
+; RUN:   -o %t2.flat.imported.bc
+; RUN: llvm-dis < %t2.bc.imported.bc -o %t2.bc.imported.ll
+; RUN: llvm-dis < %t2.flat.imported.bc -o %t2.flat.imported.ll
+; RUN: diff %t2.bc.imported.ll %t2.flat.imported.ll
+; RUN: FileCheck %s < %t2.flat.imported.ll
+; CHECK: define available_externally {{.*}}void @foo()
+
+; A truncated file is rejected.
+; RUN: head -c 120 %t.index.flat > %t.truncated.flat
+; RUN: not llvm-lto -thinlto-action=import %t2.bc \
+; RUN:   -thinlto-index=%t.truncated.flat -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=TRUNCATED
+; TRUNCATED: error loading file '{{.*}}': malformed flat summary index: {{.*}} out of bounds
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @foo() {
+entry:
+  ret void
+}
@@ -0,0 +1,45 @@
+; Verifying on several threads reports the broken functions in module order.
+; RUN: not opt -verify-threads=3 -disable-output < %s 2>&1 | FileCheck %s
+; RUN: not opt -verify-threads=8 -disable-output < %s 2>&1 | FileCheck %s
+; RUN: not opt -disable-verify -verify -function-pass-threads=3 \
+; RUN:   -disable-output < %s 2>&1 | FileCheck %s --check-prefix=PASS
+
+; CHECK: Instruction does not dominate all uses!
+; CHECK-NEXT: %z = add i32 %x, 1
+; CHECK-NEXT: %y = add i32 %z, 1
+; CHECK: PHI nodes not grouped at top of basic block!
+; CHECK-NEXT: %p = phi i32 [ 0, %entry ]
+; CHECK: error: input module is broken!
+
+; The legacy verifier pass stops at the first broken function.
+; PASS: Instruction does not dominate all uses!
+; PASS-NOT: PHI nodes not grouped
+; PASS: LLVM ERROR: Broken function found, compilation aborted!
+
+define i32 @a(i32 %x) {
+  ret i32 %x
+}
+
+define i32 @b(i32 %x) {
+  %y = add i32 %z, 1
+  %z = add i32 %x, 1
+  ret i32 %y
+}
+
+define i32 @c(i32 %x) {
+  %y = mul i32 %x, %x
+  ret i32 %y
+}
+
+define i32 @d(i32 %x) {
+entry:
+  br label %next
+next:
+  %y = add i32 %x, 1
+  %p = phi i32 [ 0, %entry ]
+  ret i32 %p
+}
+
+define void @e() {
+  ret void
+}
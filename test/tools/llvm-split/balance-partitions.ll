@@ -0,0 +1,42 @@
+; RUN: llvm-split -balance-partitions -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; The two large functions are split up, and each small function goes with the
+; large function it calls when that does not unbalance the partitions.
+
+; CHECK0: define i32 @large1
+; CHECK0: declare i32 @large2
+; CHECK0: declare i32 @small1
+; CHECK0: define i32 @small2
+
+; CHECK1: declare i32 @large1
+; CHECK1: define i32 @large2
+; CHECK1: define i32 @small1
+; CHECK1: declare i32 @small2
+
+define i32 @large1(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %a
+  %d = xor i32 %c, %b
+  ret i32 %d
+}
+
+define i32 @large2(i32 %x) {
+  %a = add i32 %x, 2
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %a
+  %d = xor i32 %c, %b
+  ret i32 %d
+}
+
+define i32 @small1(i32 %x) {
+  %r = call i32 @large2(i32 %x)
+  ret i32 %r
+}
+
+define i32 @small2(i32 %x) {
+  %r = call i32 @large1(i32 %x)
+  ret i32 %r
+}
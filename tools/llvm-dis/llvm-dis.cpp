@@ -21,6 +21,7 @@
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/IRMemoryUsage.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -68,6 +69,11 @@ static cl::opt<bool>
                         cl::desc("Load module without materializing metadata, "
                                  "then materialize only the metadata"));
 
+static cl::opt<bool>
+    PrintIRMemoryUsage("ir-memory-usage",
+                       cl::desc("Print the memory taken by the instructions "
+                                "of the module to stderr"));
+
 namespace {
 
 static void printDebugLoc(const DebugLoc &DL, formatted_raw_ostream &OS) {
@@ -166,6 +172,9 @@ int main(int argc, char **argv) {
   else
     ExitOnErr(M->materializeAll());
 
+  if (PrintIRMemoryUsage)
+    measureIRMemoryUsage(*M).print(errs());
+
   BitcodeLTOInfo LTOInfo = ExitOnErr(getBitcodeLTOInfo(*MB));
   std::unique_ptr<ModuleSummaryIndex> Index;
   if (LTOInfo.HasSummary)
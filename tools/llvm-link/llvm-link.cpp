@@ -28,6 +28,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SystemUtils.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -99,6 +100,16 @@ static cl::opt<bool>
 SuppressWarnings("suppress-warnings", cl::desc("Suppress all linking warnings"),
                  cl::init(false));
 
+static cl::opt<unsigned> StreamBatchSize(
+    "stream-batch-size", cl::init(0), cl::value_desc("N"),
+    cl::desc("Reload the linked module in a fresh context after linking every "
+             "N files, releasing what remains of the sources (0 = never)"));
+
+static cl::opt<bool>
+    ReportMemory("report-memory",
+                 cl::desc("Print the current and peak heap usage of each stage "
+                          "of linking"));
+
 static cl::opt<bool> PreserveBitcodeUseListOrder(
     "preserve-bc-uselistorder",
     cl::desc("Preserve use-list order when writing LLVM bitcode."),
@@ -111,6 +122,31 @@ static cl::opt<bool> PreserveAssemblyUseListOrder(
 
 static ExitOnError ExitOnErr;
 
+namespace {
+/// Tracks the peak heap usage over the files handled in a stage of linking.
+class MemoryReporter {
+  size_t StagePeak = 0;
+
+public:
+  void sample() {
+    if (ReportMemory)
+      StagePeak = std::max(StagePeak, sys::Process::GetMallocUsage());
+  }
+
+  void endStage(StringRef Stage) {
+    if (!ReportMemory)
+      return;
+    sample();
+    errs() << "Memory after " << Stage << ": "
+           << sys::Process::GetMallocUsage() / 1024 << " KB current, "
+           << StagePeak / 1024 << " KB peak\n";
+    StagePeak = 0;
+  }
+};
+} // anonymous namespace
+
+static MemoryReporter Memory;
+
 // Read the specified bitcode file in and return it. This routine searches the
 // link path for the specified file to try to find it...
 //
@@ -273,15 +309,82 @@ static bool importFunctions(const char *argv0, Module &DestModule) {
   return true;
 }
 
-static bool linkFiles(const char *argv0, LLVMContext &Context, Linker &L,
+namespace {
+/// The module being linked into, along with its context and linker. Linking
+/// leaves behind the types, constants and metadata of every source in the
+/// context, so with -stream-batch-size the composite module is periodically
+/// round-tripped through bitcode into a fresh context to release them.
+struct LinkState {
+  std::unique_ptr<LLVMContext> Context;
+  std::unique_ptr<Module> Composite;
+  std::unique_ptr<Linker> L;
+  unsigned FilesSinceReload = 0;
+
+  LinkState() : Context(createContext()) {
+    Composite = make_unique<Module>("llvm-link", *Context);
+    L = make_unique<Linker>(*Composite);
+  }
+
+  static std::unique_ptr<LLVMContext> createContext() {
+    auto Context = make_unique<LLVMContext>();
+    Context->setDiagnosticHandler(
+        llvm::make_unique<LLVMLinkDiagnosticHandler>(), true);
+    if (!DisableDITypeMap)
+      Context->enableDebugTypeODRUniquing();
+    return Context;
+  }
+
+  /// Note that a file was linked in, and reload the composite module if the
+  /// batch is complete.
+  void fileLinked() {
+    if (!StreamBatchSize || ++FilesSinceReload < StreamBatchSize)
+      return;
+    FilesSinceReload = 0;
+
+    if (Verbose)
+      errs() << "Reloading the linked module in a new context\n";
+    SmallString<0> Buffer;
+    raw_svector_ostream OS(Buffer);
+    WriteBitcodeToFile(*Composite, OS, /*ShouldPreserveUseListOrder=*/true);
+
+    L.reset();
+    Composite.reset();
+    Context = createContext();
+    Composite = ExitOnErr(parseBitcodeFile(
+        MemoryBufferRef(StringRef(Buffer.data(), Buffer.size()), "llvm-link"),
+        *Context));
+    L = make_unique<Linker>(*Composite);
+  }
+};
+} // anonymous namespace
+
+static bool linkFiles(const char *argv0, LinkState &State,
                       const cl::list<std::string> &Files,
                       unsigned Flags) {
   // Filter out flags that don't apply to the first file we load.
   unsigned ApplicableFlags = Flags & Linker::Flags::OverrideFromSrc;
   // Similar to some flags, internalization doesn't apply to the first file.
   bool InternalizeLinkedSymbols = false;
+
+  // If a module summary index is supplied, load it so linkInModule can treat
+  // local functions/variables as exported and promote if necessary.
+  std::unique_ptr<ModuleSummaryIndex> Index;
+  if (!SummaryIndex.empty() && !Files.empty()) {
+    Index = ExitOnErr(llvm::getModuleSummaryIndexForFile(SummaryIndex));
+
+    // Conservatively mark all internal values as promoted, since this tool
+    // does not do the ThinLink that would normally determine what values to
+    // promote.
+    for (auto &I : *Index) {
+      for (auto &S : I.second.SummaryList) {
+        if (GlobalValue::isLocalLinkage(S->linkage()))
+          S->setLinkage(GlobalValue::ExternalLinkage);
+      }
+    }
+  }
+
   for (const auto &File : Files) {
-    std::unique_ptr<Module> M = loadFile(argv0, File, Context);
+    std::unique_ptr<Module> M = loadFile(argv0, File, *State.Context);
     if (!M.get()) {
       errs() << argv0 << ": ";
       WithColor::error() << " loading file '" << File << "'\n";
@@ -297,44 +400,30 @@ static bool linkFiles(const char *argv0, LLVMContext &Context, Linker &L,
       return false;
     }
 
-    // If a module summary index is supplied, load it so linkInModule can treat
-    // local functions/variables as exported and promote if necessary.
-    if (!SummaryIndex.empty()) {
-      std::unique_ptr<ModuleSummaryIndex> Index =
-          ExitOnErr(llvm::getModuleSummaryIndexForFile(SummaryIndex));
-
-      // Conservatively mark all internal values as promoted, since this tool
-      // does not do the ThinLink that would normally determine what values to
-      // promote.
-      for (auto &I : *Index) {
-        for (auto &S : I.second.SummaryList) {
-          if (GlobalValue::isLocalLinkage(S->linkage()))
-            S->setLinkage(GlobalValue::ExternalLinkage);
-        }
-      }
-
-      // Promotion
-      if (renameModuleForThinLTO(*M, *Index))
-        return true;
-    }
+    // Promotion
+    if (Index && renameModuleForThinLTO(*M, *Index))
+      return true;
 
     if (Verbose)
       errs() << "Linking in '" << File << "'\n";
 
+    Memory.sample();
     bool Err = false;
     if (InternalizeLinkedSymbols) {
-      Err = L.linkInModule(
+      Err = State.L->linkInModule(
           std::move(M), ApplicableFlags, [](Module &M, const StringSet<> &GVS) {
             internalizeModule(M, [&GVS](const GlobalValue &GV) {
               return !GV.hasName() || (GVS.count(GV.getName()) == 0);
             });
           });
     } else {
-      Err = L.linkInModule(std::move(M), ApplicableFlags);
+      Err = State.L->linkInModule(std::move(M), ApplicableFlags);
     }
 
     if (Err)
       return false;
+    State.fileLinked();
+    Memory.sample();
 
     // Internalization applies to linking of subsequent files.
     InternalizeLinkedSymbols = Internalize;
@@ -350,33 +439,36 @@ int main(int argc, char **argv) {
   InitLLVM X(argc, argv);
   ExitOnErr.setBanner(std::string(argv[0]) + ": ");
 
-  LLVMContext Context;
-  Context.setDiagnosticHandler(
-    llvm::make_unique<LLVMLinkDiagnosticHandler>(), true);
   cl::ParseCommandLineOptions(argc, argv, "llvm linker\n");
 
-  if (!DisableDITypeMap)
-    Context.enableDebugTypeODRUniquing();
-
-  auto Composite = make_unique<Module>("llvm-link", Context);
-  Linker L(*Composite);
+  LinkState State;
 
   unsigned Flags = Linker::Flags::None;
   if (OnlyNeeded)
     Flags |= Linker::Flags::LinkOnlyNeeded;
 
   // First add all the regular input files
-  if (!linkFiles(argv[0], Context, L, InputFilenames, Flags))
+  if (!linkFiles(argv[0], State, InputFilenames, Flags))
     return 1;
+  Memory.endStage("linking");
 
   // Next the -override ones.
-  if (!linkFiles(argv[0], Context, L, OverridingInputs,
+  if (!linkFiles(argv[0], State, OverridingInputs,
                  Flags | Linker::Flags::OverrideFromSrc))
     return 1;
+  if (!OverridingInputs.empty())
+    Memory.endStage("linking overrides");
+
+  // The linker is no longer needed, and the composite module is not reloaded
+  // after this point.
+  State.L.reset();
+  Module *Composite = State.Composite.get();
 
   // Import any functions requested via -import
   if (!importFunctions(argv[0], *Composite))
     return 1;
+  if (!Imports.empty())
+    Memory.endStage("importing");
 
   if (DumpAsm)
     errs() << "Here's the assembly:\n" << *Composite;
@@ -393,6 +485,7 @@ int main(int argc, char **argv) {
     WithColor::error() << "linked module is broken!\n";
     return 1;
   }
+  Memory.endStage("verification");
 
   if (Verbose)
     errs() << "Writing bitcode...\n";
@@ -400,6 +493,7 @@ int main(int argc, char **argv) {
     Composite->print(Out.os(), nullptr, PreserveAssemblyUseListOrder);
   } else if (Force || !CheckBitcodeOutputToConsole(Out.os(), true))
     WriteBitcodeToFile(*Composite, Out.os(), PreserveBitcodeUseListOrder);
+  Memory.endStage("writing");
 
   // Declare success.
   Out.keep();
@@ -25,6 +25,7 @@
 #include "llvm/CodeGen/CommandFlags.inc"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/FlatSummaryIndex.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
@@ -139,6 +140,11 @@ static cl::opt<std::string>
                  cl::desc("Provide the index produced by a ThinLink, required "
                           "to perform the promotion and/or importing."));
 
+static cl::opt<bool> ThinLTOFlatIndex(
+    "thinlto-flat-index",
+    cl::desc("Write the index produced by a ThinLink in the flat summary "
+             "index format instead of bitcode."));
+
 static cl::opt<std::string> ThinLTOPrefixReplace(
     "thinlto-prefix-replace",
     cl::desc("Control where files for distributed backends are "
@@ -443,7 +449,17 @@ std::unique_ptr<ModuleSummaryIndex> loadCombinedIndex() {
     report_fatal_error("Missing -thinlto-index for ThinLTO promotion stage");
   ExitOnError ExitOnErr("llvm-lto: error loading file '" + ThinLTOIndex +
                         "': ");
-  return ExitOnErr(getModuleSummaryIndexForFile(ThinLTOIndex));
+  std::unique_ptr<MemoryBuffer> Buffer = ExitOnErr(
+      errorOrToExpected(MemoryBuffer::getFile(ThinLTOIndex, /*FileSize=*/-1,
+                                              /*RequiresNullTerminator=*/false)));
+  if (FlatSummaryIndex::isFlatSummaryIndex(Buffer->getBuffer())) {
+    FlatSummaryIndex FlatIndex =
+        ExitOnErr(FlatSummaryIndex::create(Buffer->getMemBufferRef()));
+    auto Index = llvm::make_unique<ModuleSummaryIndex>(/*HaveGVs=*/false);
+    FlatIndex.materialize(*Index);
+    return Index;
+  }
+  return ExitOnErr(getModuleSummaryIndex(Buffer->getMemBufferRef()));
 }
 
 static std::unique_ptr<Module> loadModule(StringRef Filename,
@@ -538,6 +554,11 @@ private:
     std::error_code EC;
     raw_fd_ostream OS(OutputFilename, EC, sys::fs::OpenFlags::F_None);
     error(EC, "error opening the file '" + OutputFilename + "'");
+    if (ThinLTOFlatIndex) {
+      ExitOnError ExitOnErr("llvm-lto: error writing flat index: ");
+      ExitOnErr(writeFlatSummaryIndex(*CombinedIndex, OS));
+      return;
+    }
     WriteIndexToFile(*CombinedIndex, OS);
   }
 
@@ -65,6 +65,17 @@ static cl::opt<bool>
                                        "import files for the "
                                        "distributed backend case"));
 
+static cl::opt<std::string> ThinLTODistributedWorker(
+    "thinlto-distributed-worker",
+    cl::desc("Run each ThinLTO backend job in a separate process by invoking "
+             "this program as a clang-style distributed backend"),
+    cl::value_desc("path"));
+
+static cl::list<std::string> ThinLTODistributedWorkerArgs(
+    "thinlto-distributed-worker-arg",
+    cl::desc("Argument to pass to the ThinLTO backend worker"),
+    cl::value_desc("arg"));
+
 static cl::opt<int> Threads("thinlto-threads",
                             cl::init(llvm::heavyweight_hardware_concurrency()));
 
@@ -253,6 +264,9 @@ static int run(int argc, char **argv) {
                                             /* ShouldEmitImportsFiles */ true,
                                             /* LinkedObjectsFile */ nullptr,
                                             /* OnWrite */ {});
+  else if (!ThinLTODistributedWorker.empty())
+    Backend = createOutOfProcessThinBackend(Threads, ThinLTODistributedWorker,
+                                            ThinLTODistributedWorkerArgs);
   else
     Backend = createInProcessThinBackend(Threads);
   LTO Lto(std::move(Conf), std::move(Backend));
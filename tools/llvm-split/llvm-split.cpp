@@ -40,6 +40,11 @@ static cl::opt<bool>
     PreserveLocals("preserve-locals", cl::Prefix, cl::init(false),
                    cl::desc("Split without externalizing locals"));
 
+static cl::opt<bool>
+    BalancePartitions("balance-partitions", cl::init(false),
+                      cl::desc("Balance the estimated codegen cost of the "
+                               "partitions"));
+
 int main(int argc, char **argv) {
   LLVMContext Context;
   SMDiagnostic Err;
@@ -67,7 +72,7 @@ int main(int argc, char **argv) {
 
     // Declare success.
     Out->keep();
-  }, PreserveLocals);
+  }, PreserveLocals, BalancePartitions);
 
   return 0;
 }
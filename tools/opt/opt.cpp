@@ -245,6 +245,16 @@ static cl::opt<bool> DiscardValueNames(
     cl::desc("Discard names from Value (other than GlobalValue)."),
     cl::init(false), cl::Hidden);
 
+static cl::opt<bool> DiscardPrivateGlobalNames(
+    "discard-private-global-names",
+    cl::desc("Discard the names of private globals created by the passes."),
+    cl::init(false), cl::Hidden);
+
+static cl::opt<bool> PerNameUniqueSuffixes(
+    "per-name-unique-suffixes",
+    cl::desc("Number the renamed values separately for each name."),
+    cl::init(false), cl::Hidden);
+
 static cl::opt<bool> Coroutines(
   "enable-coroutines",
   cl::desc("Enable coroutine passes."),
@@ -469,6 +479,7 @@ int main(int argc, char **argv) {
   SMDiagnostic Err;
 
   Context.setDiscardValueNames(DiscardValueNames);
+  Context.setPerNameUniqueSuffixes(PerNameUniqueSuffixes);
   if (!DisableDITypeMap)
     Context.enableDebugTypeODRUniquing();
 
@@ -500,6 +511,10 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  // The input refers to its private globals by name, so only the globals
+  // created from here on can drop theirs.
+  Context.setDiscardPrivateGlobalNames(DiscardPrivateGlobalNames);
+
   // Strip debug info before running the verifier.
   if (StripDebug)
     StripDebugInfo(*M);
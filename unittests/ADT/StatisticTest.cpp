@@ -57,6 +57,26 @@ TEST(StatisticTest, Assign) {
 #endif
 }
 
+TEST(StatisticTest, AddSaturating) {
+  EnableStatistics();
+
+  Counter = 0;
+  Counter.addSaturating(5ull << 30);
+#if LLVM_ENABLE_STATS
+  EXPECT_EQ(Counter, UINT_MAX);
+#else
+  EXPECT_EQ(Counter, 0u);
+#endif
+
+  Counter = 3;
+  Counter.addSaturating(4);
+#if LLVM_ENABLE_STATS
+  EXPECT_EQ(Counter, 7u);
+#else
+  EXPECT_EQ(Counter, 0u);
+#endif
+}
+
 TEST(StatisticTest, API) {
   EnableStatistics();
 
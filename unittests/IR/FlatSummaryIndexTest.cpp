@@ -0,0 +1,208 @@
+//===- FlatSummaryIndexTest.cpp - Flat summary index unit tests -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/FlatSummaryIndex.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+const GlobalValue::GUID FooGUID = 0x1000, BarGUID = 0x2000, VarGUID = 0x3000,
+                        AliasGUID = 0x4000;
+
+std::unique_ptr<FunctionSummary>
+makeFunction(GlobalValue::LinkageTypes Linkage, unsigned InstCount,
+             std::vector<ValueInfo> Refs,
+             std::vector<FunctionSummary::EdgeTy> Calls) {
+  FunctionSummary::FFlags FunFlags{};
+  FunFlags.ReadOnly = true;
+  return llvm::make_unique<FunctionSummary>(
+      GlobalValueSummary::GVFlags(Linkage, /*NotEligibleToImport=*/false,
+                                  /*Live=*/true, /*IsLocal=*/false),
+      InstCount, FunFlags, std::move(Refs), std::move(Calls),
+      std::vector<GlobalValue::GUID>(), std::vector<FunctionSummary::VFuncId>(),
+      std::vector<FunctionSummary::VFuncId>(),
+      std::vector<FunctionSummary::ConstVCall>(),
+      std::vector<FunctionSummary::ConstVCall>());
+}
+
+class FlatSummaryIndexTest : public testing::Test {
+protected:
+  ModuleSummaryIndex Index{/*HaveGVs=*/false};
+
+  void SetUp() override {
+    StringRef A =
+        Index.addModule("a.o", 0, ModuleHash{{1, 2, 3, 4, 5}})->first();
+    StringRef B = Index.addModule("b.o", 1)->first();
+
+    auto Foo = makeFunction(
+        GlobalValue::ExternalLinkage, 12,
+        {Index.getOrInsertValueInfo(VarGUID)},
+        {{Index.getOrInsertValueInfo(BarGUID),
+          CalleeInfo(CalleeInfo::HotnessType::Hot, 42)}});
+    Foo->setModulePath(A);
+    Foo->setBodyHash(0xabcdef);
+    GlobalValueSummary *FooSummary = Foo.get();
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(FooGUID),
+                                std::move(Foo));
+
+    auto Bar = makeFunction(GlobalValue::LinkOnceODRLinkage, 3, {}, {});
+    Bar->setModulePath(B);
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(BarGUID),
+                                std::move(Bar));
+
+    auto Var = llvm::make_unique<GlobalVarSummary>(
+        GlobalValueSummary::GVFlags(GlobalValue::InternalLinkage,
+                                    /*NotEligibleToImport=*/true,
+                                    /*Live=*/false, /*IsLocal=*/true),
+        std::vector<ValueInfo>());
+    Var->setModulePath(A);
+    Var->setOriginalName(0x3333);
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(VarGUID),
+                                std::move(Var));
+
+    auto Alias = llvm::make_unique<AliasSummary>(GlobalValueSummary::GVFlags(
+        GlobalValue::WeakAnyLinkage, /*NotEligibleToImport=*/false,
+        /*Live=*/true, /*IsLocal=*/false));
+    Alias->setModulePath(A);
+    Alias->setAliasee(FooSummary);
+    Alias->setAliaseeGUID(FooGUID);
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(AliasGUID),
+                                std::move(Alias));
+
+    Index.setWithGlobalValueDeadStripping();
+  }
+
+  std::string write() {
+    std::string Buffer;
+    raw_string_ostream OS(Buffer);
+    EXPECT_FALSE(errorToBool(writeFlatSummaryIndex(Index, OS)));
+    return OS.str();
+  }
+};
+
+TEST_F(FlatSummaryIndexTest, Lookup) {
+  std::string Buffer = write();
+  ASSERT_TRUE(FlatSummaryIndex::isFlatSummaryIndex(Buffer));
+  Expected<FlatSummaryIndex> FlatOrErr =
+      FlatSummaryIndex::create(MemoryBufferRef(Buffer, "index"));
+  ASSERT_TRUE(!!FlatOrErr);
+  FlatSummaryIndex &Flat = *FlatOrErr;
+
+  EXPECT_TRUE(Flat.withGlobalValueDeadStripping());
+  EXPECT_FALSE(Flat.skipModuleByDistributedBackend());
+  ASSERT_EQ(2u, Flat.modules().size());
+  EXPECT_EQ("a.o", Flat.getModulePath(Flat.modules()[0]));
+  EXPECT_EQ("b.o", Flat.getModulePath(Flat.modules()[1]));
+  EXPECT_EQ((ModuleHash{{1, 2, 3, 4, 5}}),
+            Flat.getModuleHash(Flat.modules()[0]));
+  EXPECT_EQ(4u, Flat.values().size());
+
+  ArrayRef<flatsummary::SummaryEntry> Foo = Flat.findSummaries(FooGUID);
+  ASSERT_EQ(1u, Foo.size());
+  EXPECT_EQ(GlobalValueSummary::FunctionKind, Foo[0].Kind);
+  EXPECT_EQ(GlobalValue::ExternalLinkage, Foo[0].Linkage);
+  EXPECT_EQ("a.o", Flat.getModulePath(Foo[0]));
+  EXPECT_EQ(12u, Foo[0].InstCount);
+  EXPECT_EQ(0xabcdefu, Foo[0].AliaseeOrBodyHash);
+  ASSERT_EQ(1u, Flat.refs(Foo[0]).size());
+  EXPECT_EQ(VarGUID, Flat.refs(Foo[0])[0]);
+  ASSERT_EQ(1u, Flat.calls(Foo[0]).size());
+  EXPECT_EQ(BarGUID, Flat.calls(Foo[0])[0].Callee);
+
+  ArrayRef<flatsummary::SummaryEntry> Var = Flat.findSummaries(VarGUID);
+  ASSERT_EQ(1u, Var.size());
+  EXPECT_EQ(GlobalValueSummary::GlobalVarKind, Var[0].Kind);
+  EXPECT_EQ(0x3333u, Var[0].OriginalName);
+
+  EXPECT_TRUE(Flat.findSummaries(0x1234).empty());
+}
+
+TEST_F(FlatSummaryIndexTest, Materialize) {
+  std::string Buffer = write();
+  Expected<FlatSummaryIndex> FlatOrErr =
+      FlatSummaryIndex::create(MemoryBufferRef(Buffer, "index"));
+  ASSERT_TRUE(!!FlatOrErr);
+  ModuleSummaryIndex Copy(/*HaveGVs=*/false);
+  FlatOrErr->materialize(Copy);
+
+  EXPECT_TRUE(Copy.withGlobalValueDeadStripping());
+  EXPECT_EQ(2u, Copy.modulePaths().size());
+  EXPECT_EQ((ModuleHash{{1, 2, 3, 4, 5}}), Copy.getModuleHash("a.o"));
+  EXPECT_EQ(Index.size(), Copy.size());
+
+  auto *Foo = dyn_cast_or_null<FunctionSummary>(
+      Copy.findSummaryInModule(FooGUID, "a.o"));
+  ASSERT_TRUE(Foo);
+  EXPECT_EQ(12u, Foo->instCount());
+  EXPECT_TRUE(Foo->fflags().ReadOnly);
+  EXPECT_FALSE(Foo->fflags().ReadNone);
+  EXPECT_EQ(0xabcdefu, Foo->getBodyHash());
+  ASSERT_EQ(1u, Foo->calls().size());
+  EXPECT_EQ(BarGUID, Foo->calls()[0].first.getGUID());
+  EXPECT_EQ(CalleeInfo::HotnessType::Hot, Foo->calls()[0].second.getHotness());
+  EXPECT_EQ(42u, Foo->calls()[0].second.RelBlockFreq);
+
+  auto *Var = Copy.findSummaryInModule(VarGUID, "a.o");
+  ASSERT_TRUE(Var);
+  EXPECT_EQ(GlobalValue::InternalLinkage, Var->linkage());
+  EXPECT_TRUE(Var->notEligibleToImport());
+  EXPECT_FALSE(Var->isLive());
+  EXPECT_TRUE(Var->isDSOLocal());
+  EXPECT_EQ(0x3333u, Var->getOriginalName());
+
+  auto *Alias = dyn_cast_or_null<AliasSummary>(
+      Copy.findSummaryInModule(AliasGUID, "a.o"));
+  ASSERT_TRUE(Alias);
+  EXPECT_EQ(Foo, &Alias->getAliasee());
+}
+
+TEST_F(FlatSummaryIndexTest, Malformed) {
+  std::string Buffer = write();
+  auto Create = [](StringRef Data) {
+    return errorToBool(
+        FlatSummaryIndex::create(MemoryBufferRef(Data, "index")).takeError());
+  };
+  EXPECT_TRUE(Create(StringRef(Buffer).take_front(8)));
+  EXPECT_TRUE(Create(StringRef(Buffer).drop_back(1)));
+
+  std::string BadVersion = Buffer;
+  BadVersion[4] = 2;
+  EXPECT_TRUE(Create(BadVersion));
+}
+
+TEST_F(FlatSummaryIndexTest, UnknownAliasee) {
+  // An alias whose aliasee has no summary in the alias's module.
+  auto Alias = llvm::make_unique<AliasSummary>(GlobalValueSummary::GVFlags(
+      GlobalValue::ExternalLinkage, /*NotEligibleToImport=*/false,
+      /*Live=*/true, /*IsLocal=*/false));
+  Alias->setModulePath("b.o");
+  Alias->setAliasee(Index.findSummaryInModule(FooGUID, "a.o"));
+  Alias->setAliaseeGUID(FooGUID);
+  Index.addGlobalValueSummary(Index.getOrInsertValueInfo(0x5000),
+                              std::move(Alias));
+
+  std::string Buffer = write();
+  Expected<FlatSummaryIndex> FlatOrErr =
+      FlatSummaryIndex::create(MemoryBufferRef(Buffer, "index"));
+  ASSERT_FALSE(!!FlatOrErr);
+  EXPECT_EQ("malformed flat summary index: unknown aliasee",
+            toString(FlatOrErr.takeError()));
+}
+
+TEST_F(FlatSummaryIndexTest, UnsupportedContents) {
+  Index.cfiFunctionDefs().insert("f");
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  EXPECT_TRUE(errorToBool(writeFlatSummaryIndex(Index, OS)));
+}
+
+} // end anonymous namespace
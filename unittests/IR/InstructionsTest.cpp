@@ -17,11 +17,13 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/IRMemoryUsage.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/NoFolder.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/IR/Verifier.h"
 #include "llvm/Support/SourceMgr.h"
 #include "gmock/gmock-matchers.h"
 #include "gtest/gtest.h"
@@ -751,6 +753,67 @@ TEST(InstructionsTest, SwitchInst) {
   EXPECT_EQ(BB1.get(), Handle.getCaseSuccessor());
 }
 
+TEST(InstructionsTest, ShrinkOperandLists) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseIR(C, R"(
+      define i32 @f(i32 %x) {
+      entry:
+        switch i32 %x, label %a [i32 0, label %b]
+      a:
+        br label %join
+      b:
+        br label %join
+      join:
+        %p = phi i32 [ 1, %a ], [ 2, %b ]
+        ret i32 %p
+      }
+  )");
+  ASSERT_TRUE(M);
+  Function *F = M->getFunction("f");
+  auto *SI = cast<SwitchInst>(F->front().getTerminator());
+  BasicBlock *A = SI->getDefaultDest();
+  BasicBlock *B = SI->case_begin()->getCaseSuccessor();
+  auto *PN = cast<PHINode>(&F->back().front());
+
+  IRMemoryUsage Exact = measureIRMemoryUsage(*M);
+  EXPECT_EQ(1u, Exact.NumFunctions);
+  EXPECT_EQ(5u, Exact.NumInstructions);
+  EXPECT_EQ(0u, Exact.NumReservedOperands);
+  EXPECT_EQ(0u, Exact.ReservedOperandBytes);
+  EXPECT_EQ(0u, compactOperandLists(*M));
+
+  // Growing the lists reserves more than is added; removing keeps the space.
+  PN->addIncoming(ConstantInt::get(Type::getInt32Ty(C), 3), A);
+  PN->removeIncomingValue(2);
+  SI->addCase(ConstantInt::get(Type::getInt32Ty(C), 1), A);
+  SI->removeCase(std::next(SI->case_begin()));
+  EXPECT_EQ(3u, PN->getNumReservedOperands());
+  EXPECT_EQ(12u, SI->getNumReservedOperands());
+
+  IRMemoryUsage Grown = measureIRMemoryUsage(*M);
+  EXPECT_EQ(Exact.NumOperands, Grown.NumOperands);
+  EXPECT_EQ(9u, Grown.NumReservedOperands);
+  EXPECT_EQ(Grown.OperandBytes - Exact.OperandBytes,
+            Grown.ReservedOperandBytes);
+  EXPECT_EQ(Grown.ReservedOperandBytes, compactOperandLists(*M));
+
+  EXPECT_EQ(2u, PN->getNumReservedOperands());
+  EXPECT_EQ(4u, SI->getNumReservedOperands());
+  EXPECT_EQ(A, PN->getIncomingBlock(0));
+  EXPECT_EQ(B, PN->getIncomingBlock(1));
+  EXPECT_EQ(2, cast<ConstantInt>(PN->getIncomingValue(1))->getSExtValue());
+  EXPECT_EQ(PN, PN->getOperandUse(1).getUser());
+  EXPECT_EQ(A, SI->getDefaultDest());
+  EXPECT_EQ(B, SI->case_begin()->getCaseSuccessor());
+  EXPECT_EQ(SI, B->user_back());
+  EXPECT_EQ(Exact.OperandBytes, measureIRMemoryUsage(*M).OperandBytes);
+
+  // The compacted lists grow again as usual.
+  SI->addCase(ConstantInt::get(Type::getInt32Ty(C), 1), A);
+  EXPECT_EQ(2u, SI->getNumCases());
+  EXPECT_FALSE(verifyModule(*M, &errs()));
+}
+
 TEST(InstructionsTest, CommuteShuffleMask) {
   SmallVector<int, 16> Indices({-1, 0, 7});
   ShuffleVectorInst::commuteShuffleMask(Indices, 4);
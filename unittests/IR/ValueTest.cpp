@@ -10,6 +10,8 @@
 #include "llvm/IR/Value.h"
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSlotTracker.h"
@@ -107,6 +109,48 @@ TEST(GlobalTest, AlignDeath) {
 #endif
 #endif
 
+TEST(ValueTest, PerNameUniqueSuffixes) {
+  LLVMContext C;
+  C.setPerNameUniqueSuffixes(true);
+  Module M("m", C);
+  Function *F = Function::Create(FunctionType::get(Type::getVoidTy(C), false),
+                                 GlobalValue::ExternalLinkage, "f", &M);
+  BasicBlock *BB = BasicBlock::Create(C, "entry", F);
+  IRBuilder<> B(BB);
+  Value *Ptr = B.CreateAlloca(B.getInt32Ty(), nullptr, "x");
+  Value *X1 = B.CreateLoad(Ptr, "x");
+  Value *Y = B.CreateLoad(Ptr, "y");
+  Value *Y1 = B.CreateLoad(Ptr, "y");
+  Value *X2 = B.CreateLoad(Ptr, "x");
+  EXPECT_EQ("x1", X1->getName());
+  EXPECT_EQ("y", Y->getName());
+  EXPECT_EQ("y1", Y1->getName());
+  EXPECT_EQ("x2", X2->getName());
+
+  // Globals are numbered after the dot separator.
+  Function *F1 = Function::Create(F->getFunctionType(),
+                                  GlobalValue::ExternalLinkage, "f", &M);
+  EXPECT_EQ("f.1", F1->getName());
+}
+
+TEST(ValueTest, DiscardPrivateGlobalNames) {
+  LLVMContext C;
+  C.setDiscardPrivateGlobalNames(true);
+  Module M("m", C);
+  Type *I32 = Type::getInt32Ty(C);
+  auto *Private = new GlobalVariable(M, I32, true, GlobalValue::PrivateLinkage,
+                                     nullptr, "private");
+  auto *Internal = new GlobalVariable(M, I32, true,
+                                      GlobalValue::InternalLinkage, nullptr,
+                                      "internal");
+  auto *Used = new GlobalVariable(M, I32, true, GlobalValue::PrivateLinkage,
+                                  nullptr, "llvm.used");
+  EXPECT_FALSE(Private->hasName());
+  EXPECT_EQ("internal", Internal->getName());
+  EXPECT_EQ("llvm.used", Used->getName());
+  EXPECT_EQ(nullptr, M.getNamedValue("private"));
+}
+
 TEST(ValueTest, printSlots) {
   // Check that Value::print() and Value::printAsOperand() work with and
   // without a slot tracker.
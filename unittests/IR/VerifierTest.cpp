@@ -18,6 +18,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
 #include "gtest/gtest.h"
 
 namespace llvm {
@@ -190,5 +191,52 @@ TEST(VerifierTest, DetectInvalidDebugInfo) {
   }
 }
 
+TEST(VerifierTest, ParallelDoesNotModifyContext) {
+  // Each function loads a struct type whose sizedness has not been asked for
+  // yet, and every other one has a parameter attribute of the wrong type.
+  // Verifying them on several threads must not write to the types or insert
+  // into the context; run under ThreadSanitizer to catch a race.
+  LLVMContext C;
+  Module M("M", C);
+  const unsigned NumFunctions = 32;
+  for (unsigned I = 0; I != NumFunctions; ++I) {
+    StructType *STy = StructType::create(
+        {Type::getInt32Ty(C), Type::getInt64Ty(C)}, ("T" + Twine(I)).str());
+    FunctionType *FTy =
+        FunctionType::get(Type::getVoidTy(C),
+                          {Type::getInt32Ty(C), STy->getPointerTo()},
+                          /*isVarArg=*/false);
+    Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                                   "f" + Twine(I), &M);
+    if (I % 2)
+      F->addParamAttr(0, Attribute::NoAlias);
+    IRBuilder<> Builder(BasicBlock::Create(C, "entry", F));
+    Value *Ptr = &*std::next(F->arg_begin());
+    Value *Slot = Builder.CreateAlloca(STy);
+    Builder.CreateLoad(Builder.CreateStructGEP(STy, Ptr, 1));
+    Builder.CreateStore(Builder.CreateLoad(STy, Ptr), Slot);
+    Builder.CreateRetVoid();
+  }
+
+  auto *VerifyThreads = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions()["verify-threads"]);
+  ASSERT_TRUE(VerifyThreads);
+  *VerifyThreads = 4;
+  std::string Parallel;
+  raw_string_ostream ParallelOS(Parallel);
+  EXPECT_TRUE(verifyModule(M, &ParallelOS));
+  *VerifyThreads = 1;
+
+  std::string Serial;
+  raw_string_ostream SerialOS(Serial);
+  EXPECT_TRUE(verifyModule(M, &SerialOS));
+  EXPECT_EQ(SerialOS.str(), ParallelOS.str());
+
+  StringRef Diagnostics = ParallelOS.str();
+  EXPECT_EQ(NumFunctions / 2,
+            Diagnostics.count("Wrong types for attribute: noalias\n"));
+  EXPECT_EQ(StringRef::npos, Diagnostics.find("unsized"));
+}
+
 } // end anonymous namespace
 } // end namespace llvm
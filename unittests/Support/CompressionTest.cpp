@@ -16,6 +16,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Testing/Support/Error.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -66,6 +67,40 @@ TEST(CompressionTest, Zlib) {
   TestZlibCompression(BinaryDataStr, zlib::DefaultCompression);
 }
 
+TEST(CompressionTest, ZlibParallel) {
+  // Build an input spanning several parallel blocks, with enough repetition
+  // across block boundaries to exercise the dictionary priming.
+  std::string Input;
+  for (unsigned i = 0; Input.size() < (5 << 20) + 1234; ++i)
+    Input += "line " + std::to_string(i % 5000) + " of compressible text\n";
+
+  for (zlib::CompressionLevel Level :
+       {zlib::NoCompression, zlib::BestSpeedCompression,
+        zlib::DefaultCompression, zlib::BestSizeCompression}) {
+    SmallString<32> Compressed;
+    SmallString<32> Uncompressed;
+    EXPECT_THAT_ERROR(zlib::compressParallel(Input, Compressed, Level),
+                      Succeeded());
+    EXPECT_THAT_ERROR(zlib::uncompress(Compressed, Uncompressed, Input.size()),
+                      Succeeded());
+    EXPECT_EQ(Input, Uncompressed);
+
+    // The output does not depend on the number of threads.
+    SmallString<32> OneThread;
+    EXPECT_THAT_ERROR(zlib::compressParallel(Input, OneThread, Level, 1),
+                      Succeeded());
+    EXPECT_EQ(Compressed, OneThread);
+  }
+
+  // Small inputs take the serial path and match compress() exactly.
+  SmallString<32> Serial;
+  SmallString<32> Parallel;
+  EXPECT_THAT_ERROR(zlib::compress("hello, world!", Serial), Succeeded());
+  EXPECT_THAT_ERROR(zlib::compressParallel("hello, world!", Parallel),
+                    Succeeded());
+  EXPECT_EQ(Serial, Parallel);
+}
+
 TEST(CompressionTest, ZlibCRC32) {
   EXPECT_EQ(
       0x414FA339U,
@@ -13,6 +13,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
@@ -171,4 +172,64 @@ TEST(FileOutputBuffer, TestModify) {
   ASSERT_NO_ERROR(fs::remove(TestDirectory));
 }
 
+TEST(FileOutputBuffer, TestParallelWrites) {
+  // Create unique temporary directory for these tests
+  SmallString<128> TestDirectory;
+  {
+    ASSERT_NO_ERROR(
+        fs::createUniqueDirectory("FileOutputBuffer-parallel", TestDirectory));
+  }
+
+  SmallString<128> File1(TestDirectory);
+  File1.append("/file");
+  const size_t ChunkSize = 4096 + 17;
+  const size_t NumChunks = 64;
+
+  // Write disjoint chunks from several threads at once.
+  {
+    Expected<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
+        FileOutputBuffer::create(File1, ChunkSize * NumChunks);
+    ASSERT_NO_ERROR(errorToErrorCode(BufferOrErr.takeError()));
+    std::unique_ptr<FileOutputBuffer> &Buffer = *BufferOrErr;
+    uint8_t *Data = Buffer->getBufferStart();
+    {
+      // A pool of its own rather than the global parallel executor, whose
+      // threads would outlive the test and hang the death tests that fork.
+      ThreadPool Pool(4);
+      for (size_t I = 0; I != NumChunks; ++I)
+        Pool.async(
+            [=] { memset(Data + I * ChunkSize, 'a' + I % 26, ChunkSize); });
+    }
+    ASSERT_NO_ERROR(errorToErrorCode(Buffer->commit()));
+  }
+
+  // Re-open it for modification; the unmodified chunks must be carried over.
+  {
+    Expected<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
+        FileOutputBuffer::create(File1, size_t(-1), FileOutputBuffer::F_modify);
+    ASSERT_NO_ERROR(errorToErrorCode(BufferOrErr.takeError()));
+    std::unique_ptr<FileOutputBuffer> &Buffer = *BufferOrErr;
+    ASSERT_EQ(ChunkSize * NumChunks, Buffer->getBufferSize());
+    memset(Buffer->getBufferStart() + ChunkSize, 'X', ChunkSize);
+    ASSERT_NO_ERROR(errorToErrorCode(Buffer->commit()));
+  }
+
+  {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(File1);
+    ASSERT_NO_ERROR(BufferOrErr.getError());
+    StringRef Contents = (*BufferOrErr)->getBuffer();
+    ASSERT_EQ(ChunkSize * NumChunks, Contents.size());
+    for (size_t I = 0; I != NumChunks; ++I) {
+      char Expected = I == 1 ? 'X' : 'a' + I % 26;
+      StringRef Chunk = Contents.substr(I * ChunkSize, ChunkSize);
+      EXPECT_EQ(ChunkSize, Chunk.count(Expected)) << "chunk " << I;
+    }
+  }
+
+  // Clean up.
+  ASSERT_NO_ERROR(fs::remove(File1));
+  ASSERT_NO_ERROR(fs::remove(TestDirectory));
+}
+
 } // anonymous namespace
@@ -89,6 +89,40 @@ TEST_F(MemoryBufferTest, NullTerminator4K) {
   EXPECT_EQ('\0', BufData[4096]);
 }
 
+TEST_F(MemoryBufferTest, getFileWithOptions) {
+  // Create a file large enough to be mmap'd by default.
+  int TestFD;
+  SmallString<64> TestPath;
+  sys::fs::createTemporaryFile("MemoryBufferTest_getFileWithOptions", "temp",
+                               TestFD, TestPath);
+  FileRemover Cleanup(TestPath);
+  raw_fd_ostream OF(TestFD, true, /*unbuffered=*/true);
+  for (unsigned i = 0; i < 5000; ++i)
+    OF << "0123456789";
+  OF.close();
+
+  MemoryBuffer::FileOptions Stream;
+  Stream.Stream = true;
+  Stream.Access = MemoryBuffer::AP_Sequential;
+  ErrorOr<OwningBuffer> MB = MemoryBuffer::getFile(TestPath, Stream);
+  ASSERT_FALSE(MB.getError());
+  EXPECT_EQ(MemoryBuffer::MemoryBuffer_Malloc, (*MB)->getBufferKind());
+  EXPECT_EQ(50000U, (*MB)->getBufferSize());
+  EXPECT_EQ('9', (*MB)->getBufferStart()[49999]);
+  EXPECT_EQ('\0', (*MB)->getBufferEnd()[0]);
+
+  MemoryBuffer::FileOptions Mapped;
+  Mapped.Access = MemoryBuffer::AP_Random;
+  Mapped.Prefault = true;
+  Mapped.HugePages = true;
+  MB = MemoryBuffer::getFile(TestPath, Mapped);
+  ASSERT_FALSE(MB.getError());
+  EXPECT_EQ(MemoryBuffer::MemoryBuffer_MMap, (*MB)->getBufferKind());
+  EXPECT_EQ(50000U, (*MB)->getBufferSize());
+  EXPECT_EQ('0', (*MB)->getBufferStart()[0]);
+  EXPECT_EQ('9', (*MB)->getBufferStart()[49999]);
+}
+
 TEST_F(MemoryBufferTest, copy) {
   // copy with no name
   OwningBuffer MBC1(MemoryBuffer::getMemBufferCopy(data));
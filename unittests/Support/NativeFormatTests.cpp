@@ -58,6 +58,18 @@ TEST(NativeFormatTest, BasicIntegerTests) {
   EXPECT_EQ("-257257257235709",
             format_number(-257257257235709LL, IntegerStyle::Integer));
 
+  // Values around the boundaries of the two-digits-at-a-time conversion.
+  EXPECT_EQ("9", format_number(9u, IntegerStyle::Integer));
+  EXPECT_EQ("10", format_number(10u, IntegerStyle::Integer));
+  EXPECT_EQ("99", format_number(99u, IntegerStyle::Integer));
+  EXPECT_EQ("100", format_number(100u, IntegerStyle::Integer));
+  EXPECT_EQ("1005", format_number(1005u, IntegerStyle::Integer));
+  EXPECT_EQ("4294967295", format_number(4294967295u, IntegerStyle::Integer));
+  EXPECT_EQ("18446744073709551615",
+            format_number(18446744073709551615ULL, IntegerStyle::Integer));
+  EXPECT_EQ("-9223372036854775808",
+            format_number(INT64_MIN, IntegerStyle::Integer));
+
   // Number formatting.
   EXPECT_EQ("0", format_number(0, IntegerStyle::Number));
   EXPECT_EQ("2,425", format_number(2425, IntegerStyle::Number));
@@ -18,3 +18,70 @@ TEST(xxhashTest, Basic) {
   EXPECT_EQ(0x69196c1b3af0bff9U,
             xxHash64("0123456789abcdefghijklmnopqrstuvwxyz"));
 }
+
+TEST(xxhashTest, xxh3) {
+  constexpr size_t Size = 4096;
+  uint8_t A[Size];
+  uint64_t X = 1;
+  for (size_t I = 0; I < Size; ++I) {
+    X ^= X << 13;
+    X ^= X >> 7;
+    X ^= X << 17;
+    A[I] = uint8_t(X);
+  }
+
+  // Reference values from XXH3_64bits() in xxHash v0.8.
+#define F(Len, Expected)                                                       \
+  EXPECT_EQ(uint64_t(Expected), xxh3_64bits(makeArrayRef(A, size_t(Len))))
+  F(0, 0x2d06800538d394c2ULL);
+  F(1, 0xd0d496e05c553485ULL);
+  F(2, 0x84d625edb7055eacULL);
+  F(3, 0x6ea2d59aca5c3778ULL);
+  F(4, 0xbf65290914e80242ULL);
+  F(5, 0xc01fd099ad4fc8e4ULL);
+  F(6, 0x9e3ea8187399caa5ULL);
+  F(7, 0x9da8b60540644f5aULL);
+  F(8, 0xabc1413da6cd0209ULL);
+  F(9, 0x8bc89400bfed51f6ULL);
+  F(16, 0x7e46916754d7c9b8ULL);
+  F(17, 0xed4be912ba5f836dULL);
+  F(32, 0xf59b59b58c304fd1ULL);
+  F(33, 0x9013fb74ca603e0cULL);
+  F(64, 0xfa5271fcce0db1c3ULL);
+  F(65, 0x79c42431727f1012ULL);
+  F(96, 0x591ee0ddf9c9ccd1ULL);
+  F(97, 0x8ffc6a3111fe19daULL);
+  F(128, 0x06a146ee9a2da378ULL);
+  F(129, 0xbc7138129bf065daULL);
+  F(130, 0xa90da2a1dee82596ULL);
+  F(160, 0x01a75894b0de1eb9ULL);
+  F(240, 0x6a459e3c9a0ca573ULL);
+  F(241, 0xd20eaf952a68efc8ULL);
+  F(242, 0x710ce1b58a7d186cULL);
+  F(255, 0x31006989c33c8481ULL);
+  F(256, 0xf58df47befc25a8dULL);
+  F(257, 0xa58139d913d8c24fULL);
+  F(511, 0xa89d1987db2e2e6fULL);
+  F(512, 0xcdfa6b6268e3650fULL);
+  F(513, 0x4bb5d42742f9765fULL);
+  F(1024, 0x602f8ceacc27496aULL);
+  F(1025, 0x6f6b3a8c679843c1ULL);
+  F(2048, 0x330ce110cbb79eaeULL);
+  F(2243, 0x0979f786a24edde7ULL);
+  F(4096, 0x23b95ee01b71e0d4ULL);
+#undef F
+
+  // Streaming must agree with the one-shot hash for every split point and
+  // chunk size, including ones that straddle the internal buffer and the
+  // secret's block boundary.
+  for (size_t Len : {0, 100, 240, 241, 256, 300, 1024, 1100, 2243, 4096}) {
+    uint64_t Expected = xxh3_64bits(makeArrayRef(A, Len));
+    for (size_t Chunk : {1, 7, 64, 255, 256, 257, 1000}) {
+      XXH3_64 Hasher;
+      for (size_t I = 0; I < Len; I += Chunk)
+        Hasher.update(makeArrayRef(A + I, std::min(Chunk, Len - I)));
+      EXPECT_EQ(Expected, Hasher.final()) << "Len " << Len << " Chunk "
+                                          << Chunk;
+    }
+  }
+}
@@ -0,0 +1,61 @@
+//===- CodeLayoutTest.cpp - Unit tests for the Ext-TSP code layout --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/CodeLayout.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(CodeLayoutTest, Diamond) {
+  // 0 -> 1 -> 3, 0 -> 2 -> 3, where the path through 2 is hot.
+  std::vector<uint64_t> Sizes = {16, 16, 16, 16};
+  std::vector<uint64_t> Counts = {100, 10, 90, 100};
+  std::vector<ExtTspEdge> Edges = {
+      {0, 1, 10}, {0, 2, 90}, {1, 3, 10}, {2, 3, 90}};
+  std::vector<unsigned> Order = applyExtTspLayout(Sizes, Counts, Edges);
+  EXPECT_EQ(std::vector<unsigned>({0, 2, 3, 1}), Order);
+
+  std::vector<unsigned> Original = {0, 1, 2, 3};
+  EXPECT_GT(calcExtTspScore(Order, Sizes, Edges),
+            calcExtTspScore(Original, Sizes, Edges));
+}
+
+TEST(CodeLayoutTest, ForcedPairs) {
+  std::vector<uint64_t> Sizes = {16, 16, 16, 16};
+  std::vector<uint64_t> Counts = {100, 10, 90, 100};
+  std::vector<ExtTspEdge> Edges = {
+      {0, 1, 10}, {0, 2, 90}, {1, 3, 10}, {2, 3, 90}};
+  std::vector<std::pair<unsigned, unsigned>> Forced = {{0, 1}};
+  std::vector<unsigned> Order = applyExtTspLayout(Sizes, Counts, Edges, Forced);
+  ASSERT_EQ(4u, Order.size());
+  EXPECT_EQ(0u, Order[0]);
+  EXPECT_EQ(1u, Order[1]);
+}
+
+TEST(CodeLayoutTest, EntryStaysFirst) {
+  // A hot loop 1 <-> 2 that is entered once from 0.
+  std::vector<uint64_t> Sizes = {8, 8, 8};
+  std::vector<uint64_t> Counts = {1, 100, 100};
+  std::vector<ExtTspEdge> Edges = {{0, 1, 1}, {1, 2, 100}, {2, 1, 99}};
+  std::vector<unsigned> Order = applyExtTspLayout(Sizes, Counts, Edges);
+  EXPECT_EQ(std::vector<unsigned>({0, 1, 2}), Order);
+}
+
+TEST(CodeLayoutTest, ColdBlocksKeepOrder) {
+  std::vector<uint64_t> Sizes = {4, 4, 4, 4, 4};
+  std::vector<uint64_t> Counts = {100, 0, 0, 100, 0};
+  std::vector<ExtTspEdge> Edges = {
+      {0, 1, 0}, {1, 2, 0}, {0, 3, 100}, {3, 4, 0}};
+  std::vector<unsigned> Order = applyExtTspLayout(Sizes, Counts, Edges);
+  EXPECT_EQ(std::vector<unsigned>({0, 3, 1, 2, 4}), Order);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,452 @@
+//===- GICombinerEmitter.cpp - Generate a GlobalISel combiner -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// This tablegen backend emits combiner helpers for use by GlobalISel combiner
+/// passes from the GICombineRule definitions that a GICombinerHelper lists.
+/// See include/llvm/Target/GlobalISel/Combine.td.
+///
+/// The generated file defines a class derived from GICombinerMatcher with a
+/// single entry point:
+///     bool <Classname>::tryCombineAll(MachineInstr &MI,
+///                                     CombinerHelper &Helper,
+///                                     CodeGenCoverage &CoverageInfo) const;
+/// which switches over the opcode of MI and runs a match table holding the
+/// rules rooted at that opcode, in the order the rules were listed in.
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TableGen/Error.h"
+#include "llvm/TableGen/Record.h"
+#include "llvm/TableGen/TableGenBackend.h"
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "gicombiner-emitter"
+
+cl::OptionCategory GICombinerEmitterCat(
+    "Options for -gen-global-isel-combiner");
+static cl::list<std::string>
+    SelectedCombiners("combiners", cl::desc("Emit the specified combiners"),
+                      cl::cat(GICombinerEmitterCat), cl::CommaSeparated);
+
+namespace {
+
+/// An entry of a generated match table, with an optional comment that is
+/// printed in front of it.
+struct MatchTableEntry {
+  std::string Value;
+  std::string Comment;
+
+  MatchTableEntry(StringRef Value, StringRef Comment = "")
+      : Value(Value), Comment(Comment) {}
+
+  bool isOpcode() const { return StringRef(Value).startswith("GICM_"); }
+};
+
+/// One instruction that a rule matches.
+struct InstructionPattern {
+  const Record *Opcode;
+  std::vector<std::string> OperandNames;
+};
+
+/// A GICombineRule after parsing its Match and Apply dags.
+class CombineRule {
+  const Record &TheDef;
+  unsigned ID;
+  /// The instructions to match. The first one is the root.
+  std::vector<InstructionPattern> Insns;
+  /// The C++ predicates that must hold, with the operand references expanded.
+  std::vector<std::string> Predicates;
+  /// The C++ code of the combine, with the operand references expanded.
+  std::string ApplyCode;
+  /// The instruction and operand index that each operand name refers to.
+  StringMap<std::pair<unsigned, unsigned>> Bindings;
+
+  std::string expandCode(StringRef Code, StringRef What) const;
+
+public:
+  CombineRule(const Record &R, unsigned ID) : TheDef(R), ID(ID) {}
+
+  void parse();
+
+  const Record &getDef() const { return TheDef; }
+  unsigned getID() const { return ID; }
+  const Record *getRootOpcode() const { return Insns.front().Opcode; }
+  ArrayRef<std::string> getPredicates() const { return Predicates; }
+  StringRef getApplyCode() const { return ApplyCode; }
+
+  /// Append the try-block for this rule to \p Table. The predicates of the
+  /// rule are numbered from \p FirstPredicateID.
+  void emitMatchTable(std::vector<MatchTableEntry> &Table,
+                      unsigned FirstPredicateID) const;
+};
+
+void CombineRule::parse() {
+  DagInit *Match = TheDef.getValueAsDag("Match");
+  DefInit *MatchOp = dyn_cast<DefInit>(Match->getOperator());
+  if (!MatchOp || MatchOp->getDef()->getName() != "match")
+    PrintFatalError(TheDef.getLoc(), "Expected a (match ...) dag");
+
+  std::vector<StringRef> PredicateCode;
+  for (unsigned I = 0, E = Match->getNumArgs(); I != E; ++I) {
+    Init *Arg = Match->getArg(I);
+    if (auto *Code = dyn_cast<CodeInit>(Arg)) {
+      PredicateCode.push_back(Code->getValue().trim());
+      continue;
+    }
+    if (auto *Str = dyn_cast<StringInit>(Arg)) {
+      PredicateCode.push_back(Str->getValue().trim());
+      continue;
+    }
+
+    auto *InsnDag = dyn_cast<DagInit>(Arg);
+    DefInit *InsnOp =
+        InsnDag ? dyn_cast<DefInit>(InsnDag->getOperator()) : nullptr;
+    if (!InsnOp || !InsnOp->getDef()->isSubClassOf("Instruction"))
+      PrintFatalError(TheDef.getLoc(),
+                      "Expected an instruction pattern or C++ predicate in "
+                      "(match ...), got " + Arg->getAsString());
+
+    InstructionPattern Insn;
+    Insn.Opcode = InsnOp->getDef();
+    for (unsigned J = 0, F = InsnDag->getNumArgs(); J != F; ++J) {
+      if (!isa<UnsetInit>(InsnDag->getArg(J)) || !InsnDag->getArgName(J))
+        PrintFatalError(TheDef.getLoc(),
+                        "Expected a named operand ($name) in " +
+                            InsnDag->getAsString());
+      Insn.OperandNames.push_back(InsnDag->getArgNameStr(J));
+    }
+    if (Insn.OperandNames.empty())
+      PrintFatalError(TheDef.getLoc(), "Instruction patterns must have at "
+                                       "least one operand");
+
+    unsigned InsnID = Insns.size();
+    for (unsigned J = 0, F = Insn.OperandNames.size(); J != F; ++J) {
+      // The definition of an operand of an earlier instruction is bound
+      // where it was used.
+      if (InsnID != 0 && J == 0) {
+        if (!Bindings.count(Insn.OperandNames[0]))
+          PrintFatalError(TheDef.getLoc(),
+                          "$" + Insn.OperandNames[0] +
+                              " must be an operand of an earlier instruction");
+        continue;
+      }
+      Bindings.insert(
+          std::make_pair(Insn.OperandNames[J], std::make_pair(InsnID, J)));
+    }
+    Insns.push_back(std::move(Insn));
+  }
+  if (Insns.empty())
+    PrintFatalError(TheDef.getLoc(), "Expected a root instruction to match");
+
+  for (StringRef Code : PredicateCode)
+    Predicates.push_back(expandCode(Code, "predicate"));
+
+  DagInit *Apply = TheDef.getValueAsDag("Apply");
+  DefInit *ApplyOp = dyn_cast<DefInit>(Apply->getOperator());
+  if (!ApplyOp || ApplyOp->getDef()->getName() != "apply" ||
+      Apply->getNumArgs() != 1)
+    PrintFatalError(TheDef.getLoc(), "Expected an (apply [{ code }]) dag");
+  if (auto *Code = dyn_cast<CodeInit>(Apply->getArg(0)))
+    ApplyCode = expandCode(Code->getValue().trim(), "apply code");
+  else if (auto *Str = dyn_cast<StringInit>(Apply->getArg(0)))
+    ApplyCode = expandCode(Str->getValue().trim(), "apply code");
+  else
+    PrintFatalError(TheDef.getLoc(), "Expected C++ code in (apply ...)");
+}
+
+std::string CombineRule::expandCode(StringRef Code, StringRef What) const {
+  std::string Result;
+  raw_string_ostream OS(Result);
+  while (!Code.empty()) {
+    size_t Pos = Code.find("${");
+    if (Pos == StringRef::npos) {
+      OS << Code;
+      break;
+    }
+    OS << Code.substr(0, Pos);
+    Code = Code.drop_front(Pos + 2);
+    size_t End = Code.find('}');
+    if (End == StringRef::npos)
+      PrintFatalError(TheDef.getLoc(), "Unterminated ${ in " + What);
+    StringRef Name = Code.substr(0, End);
+    auto Binding = Bindings.find(Name);
+    if (Binding == Bindings.end())
+      PrintFatalError(TheDef.getLoc(),
+                      "Unknown operand ${" + Name + "} in " + What);
+    OS << "State.MIs[" << Binding->second.first << "]->getOperand("
+       << Binding->second.second << ")";
+    Code = Code.drop_front(End + 1);
+  }
+  return OS.str();
+}
+
+void CombineRule::emitMatchTable(std::vector<MatchTableEntry> &Table,
+                                 unsigned FirstPredicateID) const {
+  // The fail target is filled in once the size of the try-block is known.
+  Table.emplace_back("GICM_Try");
+  size_t OnFailIdx = Table.size();
+  Table.emplace_back("0", "On fail goto");
+
+  // Operands whose names occur more than once must be identical. Remember the
+  // first occurrence of each name.
+  StringMap<std::pair<unsigned, unsigned>> Seen;
+  for (unsigned InsnID = 0, E = Insns.size(); InsnID != E; ++InsnID) {
+    const InstructionPattern &Insn = Insns[InsnID];
+    if (InsnID != 0) {
+      const auto &Def = Bindings.find(Insn.OperandNames[0])->second;
+      Table.emplace_back("GICM_RecordDefInsn");
+      Table.emplace_back(Twine(InsnID).str(), "MIs");
+      Table.emplace_back(Twine(Def.first).str(),
+                         "$" + Insn.OperandNames[0]);
+      Table.emplace_back(Twine(Def.second).str());
+      Table.emplace_back("GICM_CheckOpcode");
+      Table.emplace_back(Twine(InsnID).str());
+      Table.emplace_back((Insn.Opcode->getValueAsString("Namespace") + "::" +
+                          Insn.Opcode->getName())
+                             .str());
+    }
+    Table.emplace_back("GICM_CheckNumOperands");
+    Table.emplace_back(Twine(InsnID).str());
+    Table.emplace_back(Twine(Insn.OperandNames.size()).str());
+
+    for (unsigned OpIdx = 0, F = Insn.OperandNames.size(); OpIdx != F;
+         ++OpIdx) {
+      if (InsnID != 0 && OpIdx == 0)
+        continue;
+      StringRef Name = Insn.OperandNames[OpIdx];
+      auto Inserted =
+          Seen.insert(std::make_pair(Name, std::make_pair(InsnID, OpIdx)));
+      if (Inserted.second)
+        continue;
+      Table.emplace_back("GICM_CheckIsSameOperand");
+      Table.emplace_back(Twine(InsnID).str(), ("$" + Name).str());
+      Table.emplace_back(Twine(OpIdx).str());
+      Table.emplace_back(Twine(Inserted.first->second.first).str());
+      Table.emplace_back(Twine(Inserted.first->second.second).str());
+    }
+  }
+
+  for (unsigned I = 0, E = Predicates.size(); I != E; ++I) {
+    Table.emplace_back("GICM_CheckPredicate");
+    Table.emplace_back(Twine(FirstPredicateID + I).str());
+  }
+
+  Table.emplace_back("GICM_Apply");
+  Table.emplace_back(Twine(ID).str(), TheDef.getName());
+  Table.emplace_back(Twine(ID).str());
+  Table[OnFailIdx].Value = Twine(Table.size()).str();
+}
+
+class GICombinerEmitter {
+  RecordKeeper &Records;
+  const Record *Combiner;
+  std::vector<std::unique_ptr<CombineRule>> Rules;
+
+  void gatherRules(std::vector<const Record *> &ActiveRules,
+                   const std::vector<Record *> &RuleList);
+
+public:
+  GICombinerEmitter(RecordKeeper &Records, const Record *Combiner)
+      : Records(Records), Combiner(Combiner) {}
+
+  void run(raw_ostream &OS);
+};
+
+void GICombinerEmitter::gatherRules(std::vector<const Record *> &ActiveRules,
+                                    const std::vector<Record *> &RuleList) {
+  for (const Record *R : RuleList) {
+    if (R->isSubClassOf("GICombineRule")) {
+      if (!is_contained(ActiveRules, R))
+        ActiveRules.push_back(R);
+    } else if (R->isSubClassOf("GICombineGroup")) {
+      gatherRules(ActiveRules, R->getValueAsListOfDefs("Rules"));
+    } else {
+      PrintFatalError(R->getLoc(), "Expected a GICombineRule or "
+                                   "GICombineGroup");
+    }
+  }
+}
+
+void GICombinerEmitter::run(raw_ostream &OS) {
+  std::vector<const Record *> ActiveRules;
+  gatherRules(ActiveRules, Combiner->getValueAsListOfDefs("Rules"));
+  for (const Record *R : ActiveRules) {
+    Rules.emplace_back(new CombineRule(*R, Rules.size()));
+    Rules.back()->parse();
+  }
+
+  StringRef Classname = Combiner->getValueAsString("Classname");
+  std::string Name = Combiner->getName();
+  std::string Guard = StringRef(Name).upper();
+  std::string DisableOptionName;
+  if (!Combiner->isValueUnset("DisableRuleOption"))
+    DisableOptionName = Combiner->getValueAsString("DisableRuleOption");
+
+  // Number the predicates and group the rules by their root opcode, keeping
+  // the order the rules were listed in within each group.
+  std::vector<unsigned> FirstPredicateIDs;
+  unsigned NumPredicates = 0;
+  std::vector<const Record *> RootOpcodes;
+  std::map<const Record *, std::vector<const CombineRule *>> RulesByRoot;
+  for (const auto &Rule : Rules) {
+    FirstPredicateIDs.push_back(NumPredicates);
+    NumPredicates += Rule->getPredicates().size();
+    const Record *Root = Rule->getRootOpcode();
+    if (!RulesByRoot.count(Root))
+      RootOpcodes.push_back(Root);
+    RulesByRoot[Root].push_back(Rule.get());
+  }
+
+  emitSourceFileHeader("Global Combiner Helper: " + Name, OS);
+
+  OS << "#ifdef " << Guard << "_GENCOMBINERHELPER_H\n"
+     << "class " << Classname << " : public GICombinerMatcher {\n"
+     << "  BitVector DisabledRules;\n\n"
+     << "public:\n"
+     << "  " << Classname << "();\n\n"
+     << "  bool tryCombineAll(MachineInstr &MI, CombinerHelper &Helper,\n"
+     << "                     CodeGenCoverage &CoverageInfo) const;\n\n"
+     << "protected:\n"
+     << "  bool isRuleDisabled(unsigned RuleID) const override;\n"
+     << "  bool testPredicate(unsigned PredicateID, MachineInstr &MI,\n"
+     << "                     GICombinerMatchState &State,\n"
+     << "                     MachineRegisterInfo &MRI,\n"
+     << "                     CombinerHelper &Helper) const override;\n"
+     << "  void runApply(unsigned ApplyID, MachineInstr &MI,\n"
+     << "                GICombinerMatchState &State, "
+     << "MachineRegisterInfo &MRI,\n"
+     << "                CombinerHelper &Helper) const override;\n"
+     << "};\n"
+     << "#endif // ifdef " << Guard << "_GENCOMBINERHELPER_H\n\n";
+
+  OS << "#ifdef " << Guard << "_GENCOMBINERHELPER_CPP\n";
+  if (!DisableOptionName.empty())
+    OS << "static cl::list<std::string> " << Name << "Option(\n"
+       << "    \"" << DisableOptionName << "\",\n"
+       << "    cl::desc(\"Disable one or more combiner rules temporarily in "
+       << "the " << Name << " pass\"),\n"
+       << "    cl::CommaSeparated, cl::Hidden);\n\n";
+
+  OS << Classname << "::" << Classname << "() : DisabledRules("
+     << Rules.size() << ") {\n";
+  if (!DisableOptionName.empty()) {
+    OS << "  for (const std::string &Identifier : " << Name << "Option) {\n"
+       << "    int RuleID = StringSwitch<int>(Identifier)\n";
+    for (const auto &Rule : Rules)
+      OS << "        .Case(\"" << Rule->getDef().getName() << "\", "
+         << Rule->getID() << ")\n";
+    OS << "        .Default(-1);\n"
+       << "    if (RuleID < 0)\n"
+       << "      report_fatal_error(\"Invalid rule identifier \" + Identifier "
+       << "+ \" for -" << DisableOptionName << "\");\n"
+       << "    DisabledRules.set(RuleID);\n"
+       << "  }\n";
+  }
+  OS << "}\n\n";
+
+  OS << "bool " << Classname
+     << "::isRuleDisabled(unsigned RuleID) const {\n"
+     << "  return DisabledRules.test(RuleID);\n"
+     << "}\n\n";
+
+  OS << "bool " << Classname << "::testPredicate(\n"
+     << "    unsigned PredicateID, MachineInstr &MI, "
+     << "GICombinerMatchState &State,\n"
+     << "    MachineRegisterInfo &MRI, CombinerHelper &Helper) const {\n"
+     << "  int64_t &MatchInfo = State.MatchInfo;\n"
+     << "  (void)MatchInfo;\n"
+     << "  switch (PredicateID) {\n";
+  for (const auto &Rule : Rules) {
+    unsigned PredicateID = FirstPredicateIDs[Rule->getID()];
+    for (StringRef Code : Rule->getPredicates())
+      OS << "  case " << PredicateID++ << ": {\n"
+         << "    // " << Rule->getDef().getName() << "\n"
+         << "    " << Code << "\n"
+         << "  }\n";
+  }
+  OS << "  }\n"
+     << "  llvm_unreachable(\"Unknown predicate\");\n"
+     << "}\n\n";
+
+  OS << "void " << Classname << "::runApply(\n"
+     << "    unsigned ApplyID, MachineInstr &MI, GICombinerMatchState &State,\n"
+     << "    MachineRegisterInfo &MRI, CombinerHelper &Helper) const {\n"
+     << "  int64_t &MatchInfo = State.MatchInfo;\n"
+     << "  (void)MatchInfo;\n"
+     << "  switch (ApplyID) {\n";
+  for (const auto &Rule : Rules)
+    OS << "  case " << Rule->getID() << ": {\n"
+       << "    // " << Rule->getDef().getName() << "\n"
+       << "    " << Rule->getApplyCode() << "\n"
+       << "    return;\n"
+       << "  }\n";
+  OS << "  }\n"
+     << "  llvm_unreachable(\"Unknown apply code\");\n"
+     << "}\n\n";
+
+  OS << "bool " << Classname << "::tryCombineAll(\n"
+     << "    MachineInstr &MI, CombinerHelper &Helper,\n"
+     << "    CodeGenCoverage &CoverageInfo) const {\n"
+     << "  MachineRegisterInfo &MRI = MI.getMF()->getRegInfo();\n"
+     << "  switch (MI.getOpcode()) {\n";
+  for (const Record *Root : RootOpcodes) {
+    std::vector<MatchTableEntry> Table;
+    for (const CombineRule *Rule : RulesByRoot[Root])
+      Rule->emitMatchTable(Table, FirstPredicateIDs[Rule->getID()]);
+    Table.emplace_back("GICM_Reject");
+
+    OS << "  case " << Root->getValueAsString("Namespace")
+       << "::" << Root->getName() << ": {\n"
+       << "    static const int64_t MatchTable[] = {\n";
+    for (unsigned I = 0, E = Table.size(); I != E; ++I) {
+      const MatchTableEntry &Entry = Table[I];
+      if (Entry.isOpcode())
+        OS << (I ? "\n" : "") << "      /*" << I << "*/";
+      OS << " ";
+      if (!Entry.Comment.empty())
+        OS << "/*" << Entry.Comment << "*/";
+      OS << Entry.Value << ",";
+    }
+    OS << "\n"
+       << "    };\n"
+       << "    return executeMatchTable(MatchTable, MI, MRI, Helper, "
+       << "CoverageInfo);\n"
+       << "  }\n";
+  }
+  OS << "  default:\n"
+     << "    return false;\n"
+     << "  }\n"
+     << "}\n"
+     << "#endif // ifdef " << Guard << "_GENCOMBINERHELPER_CPP\n";
+}
+
+} // end anonymous namespace
+
+namespace llvm {
+void EmitGICombiner(RecordKeeper &RK, raw_ostream &OS) {
+  if (SelectedCombiners.empty())
+    PrintFatalError("No combiners selected with -combiners");
+  for (const auto &Combiner : SelectedCombiners) {
+    Record *CombinerDef = RK.getDef(Combiner);
+    if (!CombinerDef || !CombinerDef->isSubClassOf("GICombinerHelper"))
+      PrintFatalError("Could not find GICombinerHelper " + Combiner);
+    GICombinerEmitter(RK, CombinerDef).run(OS);
+  }
+}
+} // End llvm namespace